@@ -1,11 +1,14 @@
+dnl kdump_COMPRESSION(name, VAR, lib, function [, pkg-config-module])
+dnl
+dnl The pkg-config module defaults to name.
 AC_DEFUN([kdump_COMPRESSION], [dnl
 AC_ARG_WITH([$1],
   [AS_HELP_STRING([--with-$1],
     [support for $1 compression @<:@default=check@:>@])],
   [], [with_$1=check])
 AS_IF([test "x$with_$1" != xno],
-  [PKG_CHECK_MODULES([$2], [$1],
-     [AS_VAR_SET([$2][_REQUIRES],[$1])
+  [PKG_CHECK_MODULES([$2], [m4_default([$5], [$1])],
+     [AS_VAR_SET([$2][_REQUIRES],[m4_default([$5], [$1])])
       have_$1=yes
      ],[dnl Fall back to searching if there is no pkg-config file
       saved_LIBS="$LIBS"
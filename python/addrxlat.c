@@ -1299,6 +1299,56 @@ fulladdr_AsPointer(PyObject *self)
 	return &((fulladdr_object*)self)->faddr;
 }
 
+/** Lock provided by the owner of a shared C object.
+ *
+ * Objects handed out by another extension module (e.g. kdumpfile)
+ * wrap C objects which that module may use from other threads
+ * without holding the GIL. The owner provides a lock to serialize
+ * access to such objects.
+ */
+typedef struct {
+	/** Owner object, or @c NULL if the object is not shared. */
+	PyObject *owner;
+	/** Acquire the lock. */
+	addrxlat_lock_fn *lock;
+	/** Release the lock. */
+	addrxlat_lock_fn *unlock;
+} owner_lock_t;
+
+/** Acquire an owner lock (if any).
+ * @param lock  Owner lock.
+ */
+static void
+owner_lock(const owner_lock_t *lock)
+{
+	if (lock->owner)
+		lock->lock(lock->owner);
+}
+
+/** Release an owner lock (if any).
+ * @param lock  Owner lock.
+ */
+static void
+owner_unlock(const owner_lock_t *lock)
+{
+	if (lock->owner)
+		lock->unlock(lock->owner);
+}
+
+/** Replace an owner lock.
+ * @param dst  Owner lock to be replaced.
+ * @param src  New owner lock.
+ */
+static void
+owner_lock_set(owner_lock_t *dst, const owner_lock_t *src)
+{
+	PyObject *old = dst->owner;
+
+	Py_XINCREF(src->owner);
+	*dst = *src;
+	Py_XDECREF(old);
+}
+
 typedef struct tag_ctx_object {
 	PyObject_HEAD
 
@@ -1307,6 +1357,9 @@ typedef struct tag_ctx_object {
 
 	PyObject *exc_type, *exc_val, *exc_tb;
 
+	/** Lock of the owner of @c ctx. */
+	owner_lock_t lock;
+
 	PyObject *convert;
 } ctx_object;
 
@@ -1433,7 +1486,7 @@ cb_none(ctx_object *self)
 }
 
 static addrxlat_status
-cb_sym(void *_self, addrxlat_sym_t *sym)
+call_cb_sym(void *_self, addrxlat_sym_t *sym)
 {
 	ctx_object *self = (ctx_object*)_self;
 	PyObject *cb_sym;
@@ -1492,7 +1545,7 @@ cb_sym(void *_self, addrxlat_sym_t *sym)
 }
 
 static addrxlat_status
-cb_read32(void *_self, const addrxlat_fulladdr_t *addr, uint32_t *val)
+call_cb_read32(void *_self, const addrxlat_fulladdr_t *addr, uint32_t *val)
 {
 	ctx_object *self = (ctx_object*)_self;
 	PyObject *addrobj, *result;
@@ -1521,7 +1574,7 @@ cb_read32(void *_self, const addrxlat_fulladdr_t *addr, uint32_t *val)
 }
 
 static addrxlat_status
-cb_read64(void *_self, const addrxlat_fulladdr_t *addr, uint64_t *val)
+call_cb_read64(void *_self, const addrxlat_fulladdr_t *addr, uint64_t *val)
 {
 	ctx_object *self = (ctx_object*)_self;
 	PyObject *addrobj, *result;
@@ -1549,6 +1602,37 @@ cb_read64(void *_self, const addrxlat_fulladdr_t *addr, uint64_t *val)
 	return ADDRXLAT_OK;
 }
 
+/* The callbacks below may be invoked by a C library call which was
+ * made without holding the GIL, so they must acquire it first.
+ */
+
+static addrxlat_status
+cb_sym(void *_self, addrxlat_sym_t *sym)
+{
+	PyGILState_STATE gstate = PyGILState_Ensure();
+	addrxlat_status status = call_cb_sym(_self, sym);
+	PyGILState_Release(gstate);
+	return status;
+}
+
+static addrxlat_status
+cb_read32(void *_self, const addrxlat_fulladdr_t *addr, uint32_t *val)
+{
+	PyGILState_STATE gstate = PyGILState_Ensure();
+	addrxlat_status status = call_cb_read32(_self, addr, val);
+	PyGILState_Release(gstate);
+	return status;
+}
+
+static addrxlat_status
+cb_read64(void *_self, const addrxlat_fulladdr_t *addr, uint64_t *val)
+{
+	PyGILState_STATE gstate = PyGILState_Ensure();
+	addrxlat_status status = call_cb_read64(_self, addr, val);
+	PyGILState_Release(gstate);
+	return status;
+}
+
 static void cb_hook(void *_self, addrxlat_cb_t *cb);
 
 static void
@@ -1569,14 +1653,17 @@ static void
 cb_hook(void *_self, addrxlat_cb_t *cb)
 {
 	ctx_object *self = (ctx_object*)_self;
+	PyGILState_STATE gstate;
 
 	if (self->next_cb.cb_hook)
 		self->next_cb.cb_hook(self->next_cb.data, cb);
 
+	gstate = PyGILState_Ensure();
 	if (self->ctx)
 		install_cb_hook(self, cb);
 
 	Py_DECREF((PyObject *)self);
+	PyGILState_Release(gstate);
 }
 
 PyDoc_STRVAR(ctx__doc__,
@@ -1663,9 +1750,12 @@ ctx_dealloc(PyObject *_self)
 	if (self->ctx) {
 		addrxlat_ctx_t *ctx = self->ctx;
 		self->ctx = NULL;
+		owner_lock(&self->lock);
 		addrxlat_ctx_set_cb(ctx, addrxlat_ctx_get_cb(ctx));
 		addrxlat_ctx_decref(ctx);
+		owner_unlock(&self->lock);
 	}
+	Py_XDECREF(self->lock.owner);
 
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -1679,6 +1769,7 @@ ctx_traverse(PyObject *_self, visitproc visit, void *arg)
 	Py_VISIT(self->exc_val);
 	Py_VISIT(self->exc_tb);
 
+	Py_VISIT(self->lock.owner);
 	Py_VISIT(self->convert);
 
 	return 0;
@@ -1716,13 +1807,17 @@ ctx_err(PyObject *_self, PyObject *args, PyObject *kwargs)
 	int statusparam;
 	const char *msg;
 	addrxlat_status status;
+	PyObject *result;
 
 	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "is:err",
 					 keywords, &statusparam, &msg))
 		return NULL;
 
+	owner_lock(&self->lock);
 	status = addrxlat_ctx_err(self->ctx, statusparam, "%s", msg);
-	return ctx_status_result((PyObject*)self, status);
+	result = ctx_status_result((PyObject*)self, status);
+	owner_unlock(&self->lock);
+	return result;
 }
 
 PyDoc_STRVAR(ctx_clear_err__doc__,
@@ -1735,7 +1830,9 @@ ctx_clear_err(PyObject *_self, PyObject *args)
 {
 	ctx_object *self = (ctx_object*)_self;
 
+	owner_lock(&self->lock);
 	addrxlat_ctx_clear_err(self->ctx);
+	owner_unlock(&self->lock);
 	Py_RETURN_NONE;
 }
 
@@ -1748,11 +1845,16 @@ static PyObject *
 ctx_get_err(PyObject *_self, PyObject *args)
 {
 	ctx_object *self = (ctx_object*)_self;
-	const char *err = addrxlat_ctx_get_err(self->ctx);
+	const char *err;
+	PyObject *result;
 
-	return err
+	owner_lock(&self->lock);
+	err = addrxlat_ctx_get_err(self->ctx);
+	result = err
 		? Text_FromUTF8(err)
 		: (Py_INCREF(Py_None), Py_None);
+	owner_unlock(&self->lock);
+	return result;
 }
 
 static PyObject *
@@ -1795,48 +1897,56 @@ ctx_next_cb_sym(PyObject *_self, PyObject *args)
 	int symargc;
 	addrxlat_sym_t sym;
 	addrxlat_status status;
+	PyObject *result = NULL;
 
+	owner_lock(&self->lock);
 	addrxlat_ctx_clear_err(self->ctx);
-	if (!self->next_cb.sym)
-		return raise_exception(self->ctx, cb_null(self));
+	if (!self->next_cb.sym) {
+		result = raise_exception(self->ctx, cb_null(self));
+		goto out;
+	}
 
 	argc = PyTuple_GET_SIZE(args);
 	if (argc < 1) {
 		PyErr_Format(PyExc_TypeError,
 			     "%s() takes at least one argument",
 			     "next_cb_sym");
-		return NULL;
+		goto out;
 	}
 
 	obj = PyTuple_GET_ITEM(args, 0);
 	type = Number_AsLong(obj);
 	Py_DECREF(obj);
 	if (PyErr_Occurred())
-		return NULL;
+		goto out;
 
 	symargc = addrxlat_sym_argc(type);
 	if (symargc == -1) {
 		PyErr_Format(PyExc_NotImplementedError,
 			     "Unknown symbolic info type: %d", (int)type);
-		return NULL;
+		goto out;
 	}
 	if (argc != symargc + 1) {
 		PyErr_Format(PyExc_TypeError,
 			     "%s(%d, ...) requires exactly %d arguments",
 			     "next_cb_sym", (int)type, symargc + 1);
-		return NULL;
+		goto out;
 	}
 
 	sym.type = type;
 	for (i = 1; i < argc; ++i) {
 		char *arg = Text_AsUTF8(PyTuple_GET_ITEM(args, i));
 		if (!arg)
-			return NULL;
+			goto out;
 		sym.args[i - 1] = arg;
 	}
 
 	status = self->next_cb.sym(self->next_cb.data, &sym);
-	return cb_status_result(self, status, sym.val);
+	result = cb_status_result(self, status, sym.val);
+
+ out:
+	owner_unlock(&self->lock);
+	return result;
 }
 
 PyDoc_STRVAR(ctx_cb_read32__doc__,
@@ -1857,19 +1967,27 @@ ctx_next_cb_read32(PyObject *_self, PyObject *args)
 	addrxlat_fulladdr_t *addr;
 	uint32_t val;
 	addrxlat_status status;
+	PyObject *result = NULL;
 
+	owner_lock(&self->lock);
 	addrxlat_ctx_clear_err(self->ctx);
-	if (!self->next_cb.read32)
-		return raise_exception(self->ctx, cb_null(self));
+	if (!self->next_cb.read32) {
+		result = raise_exception(self->ctx, cb_null(self));
+		goto out;
+	}
 
 	if (!PyArg_ParseTuple(args, "O", &addrobj))
-		return NULL;
+		goto out;
 	addr = fulladdr_AsPointer(addrobj);
 	if (!addr)
-		return NULL;
+		goto out;
 
 	status = self->next_cb.read32(self->next_cb.data, addr, &val);
-	return cb_status_result(self, status, val);
+	result = cb_status_result(self, status, val);
+
+ out:
+	owner_unlock(&self->lock);
+	return result;
 }
 
 PyDoc_STRVAR(ctx_cb_read64__doc__,
@@ -1890,19 +2008,27 @@ ctx_next_cb_read64(PyObject *_self, PyObject *args)
 	addrxlat_fulladdr_t *addr;
 	uint64_t val;
 	addrxlat_status status;
+	PyObject *result = NULL;
 
+	owner_lock(&self->lock);
 	addrxlat_ctx_clear_err(self->ctx);
-	if (!self->next_cb.read64)
-		return raise_exception(self->ctx, cb_null(self));
+	if (!self->next_cb.read64) {
+		result = raise_exception(self->ctx, cb_null(self));
+		goto out;
+	}
 
 	if (!PyArg_ParseTuple(args, "O", &addrobj))
-		return NULL;
+		goto out;
 	addr = fulladdr_AsPointer(addrobj);
 	if (!addr)
-		return NULL;
+		goto out;
 
 	status = self->next_cb.read64(self->next_cb.data, addr, &val);
-	return cb_status_result(self, status, val);
+	result = cb_status_result(self, status, val);
+
+ out:
+	owner_unlock(&self->lock);
+	return result;
 }
 
 static PyMethodDef ctx_methods[] = {
@@ -1946,7 +2072,11 @@ static PyObject *
 ctx_get_read_caps(PyObject *_self, void *data)
 {
 	ctx_object *self = (ctx_object*)_self;
-	unsigned long read_caps = addrxlat_ctx_get_cb(self->ctx)->read_caps;
+	unsigned long read_caps;
+
+	owner_lock(&self->lock);
+	read_caps = addrxlat_ctx_get_cb(self->ctx)->read_caps;
+	owner_unlock(&self->lock);
 
 	return PyLong_FromUnsignedLong(read_caps);
 }
@@ -1955,14 +2085,17 @@ static int
 ctx_set_read_caps(PyObject *_self, PyObject *value, void *data)
 {
 	ctx_object *self = (ctx_object*)_self;
-	addrxlat_cb_t cb = *addrxlat_ctx_get_cb(self->ctx);
+	addrxlat_cb_t cb;
 	long read_caps = Number_AsLong(value);
 
 	if (PyErr_Occurred())
 		return -1;
 
+	owner_lock(&self->lock);
+	cb = *addrxlat_ctx_get_cb(self->ctx);
 	cb.read_caps = read_caps;
 	addrxlat_ctx_set_cb(self->ctx, &cb);
+	owner_unlock(&self->lock);
 	return 0;
 }
 
@@ -3732,6 +3865,9 @@ typedef struct {
 
 	addrxlat_map_t *map;
 
+	/** Lock of the owner of @c map. */
+	owner_lock_t lock;
+
 	PyObject *convert;
 } map_object;
 
@@ -3799,9 +3935,12 @@ map_dealloc(PyObject *_self)
 	Py_XDECREF(self->convert);
 
 	if (self->map) {
+		owner_lock(&self->lock);
 		addrxlat_map_decref(self->map);
+		owner_unlock(&self->lock);
 		self->map = NULL;
 	}
+	Py_XDECREF(self->lock.owner);
 
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -3810,6 +3949,7 @@ static int
 map_traverse(PyObject *_self, visitproc visit, void *arg)
 {
 	map_object *self = (map_object*)_self;
+	Py_VISIT(self->lock.owner);
 	Py_VISIT(self->convert);
 	return 0;
 }
@@ -3837,9 +3977,15 @@ static Py_ssize_t
 map_len(PyObject *_self)
 {
 	map_object *self = (map_object*)_self;
-	return self->map
-		? addrxlat_map_len(self->map)
-		: 0;
+	Py_ssize_t len;
+
+	if (!self->map)
+		return 0;
+
+	owner_lock(&self->lock);
+	len = addrxlat_map_len(self->map);
+	owner_unlock(&self->lock);
+	return len;
 }
 
 static PyObject *
@@ -3847,18 +3993,23 @@ map_item(PyObject *_self, Py_ssize_t index)
 {
 	map_object *self = (map_object*)_self;
 	const addrxlat_range_t *ranges;
+	addrxlat_range_t range;
 	Py_ssize_t n;
 
+	owner_lock(&self->lock);
 	n = map_len((PyObject*)self);
 	if (index < 0)
 		index = n - index;
 	if (index >= n) {
+		owner_unlock(&self->lock);
 		PyErr_SetString(PyExc_IndexError, "map index out of range");
 		return NULL;
 	}
 
 	ranges = addrxlat_map_ranges(self->map);
-	return range_FromPointer(self->convert, &ranges[index]);
+	range = ranges[index];
+	owner_unlock(&self->lock);
+	return range_FromPointer(self->convert, &range);
 }
 
 static PySequenceMethods map_as_sequence = {
@@ -3896,7 +4047,9 @@ map_set(PyObject *_self, PyObject *args, PyObject *kwargs)
 	if (!range)
 		return NULL;
 
+	owner_lock(&self->lock);
 	status = addrxlat_map_set(self->map, addr, range);
+	owner_unlock(&self->lock);
 	return PyInt_FromLong(status);
 }
 
@@ -3911,12 +4064,16 @@ map_search(PyObject *_self, PyObject *args, PyObject *kwargs)
 	map_object *self = (map_object*)_self;
 	static char *keywords[] = {"addr", NULL};
 	unsigned long long addr;
+	long idx;
 
 	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "K:search",
 					 keywords, &addr))
 		return NULL;
 
-	return PyInt_FromLong(addrxlat_map_search(self->map, addr));
+	owner_lock(&self->lock);
+	idx = addrxlat_map_search(self->map, addr);
+	owner_unlock(&self->lock);
+	return PyInt_FromLong(idx);
 }
 
 PyDoc_STRVAR(map_copy__doc__,
@@ -3931,7 +4088,9 @@ map_copy(PyObject *_self, PyObject *args)
 	addrxlat_map_t *map;
 	PyObject *result;
 
+	owner_lock(&self->lock);
 	map = addrxlat_map_copy(self->map);
+	owner_unlock(&self->lock);
 	if (!map)
 		return PyErr_NoMemory();
 
@@ -4033,6 +4192,9 @@ typedef struct {
 
 	addrxlat_sys_t *sys;
 
+	/** Lock of the owner of @c sys. */
+	owner_lock_t lock;
+
 	PyObject *convert;
 } sys_object;
 
@@ -4100,9 +4262,12 @@ sys_dealloc(PyObject *_self)
 	Py_XDECREF(self->convert);
 
 	if (self->sys) {
+		owner_lock(&self->lock);
 		addrxlat_sys_decref(self->sys);
+		owner_unlock(&self->lock);
 		self->sys = NULL;
 	}
+	Py_XDECREF(self->lock.owner);
 
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -4111,6 +4276,7 @@ static int
 sys_traverse(PyObject *_self, visitproc visit, void *arg)
 {
 	sys_object *self = (sys_object*)_self;
+	Py_VISIT(self->lock.owner);
 	Py_VISIT(self->convert);
 	return 0;
 }
@@ -4149,9 +4315,11 @@ sys_os_init(PyObject *_self, PyObject *args, PyObject *kwargs)
 	};
 	PyObject *ctxobj;
 	addrxlat_ctx_t *ctx;
+	const owner_lock_t *ctxlock;
 	addrxlat_osdesc_t osdesc;
 	long type;
 	addrxlat_status status;
+	PyObject *result;
 
 	type = ADDRXLAT_OS_UNKNOWN;
 	osdesc.ver = 0;
@@ -4166,8 +4334,14 @@ sys_os_init(PyObject *_self, PyObject *args, PyObject *kwargs)
 		return NULL;
 
 	osdesc.type = type;
+	ctxlock = &((ctx_object*)ctxobj)->lock;
+	owner_lock(ctxlock);
+	owner_lock(&self->lock);
 	status = addrxlat_sys_os_init(self->sys, ctx, &osdesc);
-	return ctx_status_result(ctxobj, status);
+	owner_unlock(&self->lock);
+	result = ctx_status_result(ctxobj, status);
+	owner_unlock(ctxlock);
+	return result;
 }
 
 PyDoc_STRVAR(sys_set_map__doc__,
@@ -4199,7 +4373,9 @@ sys_set_map(PyObject *_self, PyObject *args, PyObject *kwargs)
 	if (PyErr_Occurred())
 		return NULL;
 
+	owner_lock(&self->lock);
 	addrxlat_sys_set_map(self->sys, idx, map);
+	owner_unlock(&self->lock);
 	Py_RETURN_NONE;
 }
 
@@ -4216,6 +4392,7 @@ sys_get_map(PyObject *_self, PyObject *args, PyObject *kwargs)
 	static char *keywords[] = { "idx", NULL };
 	unsigned long idx;
 	addrxlat_map_t *map;
+	PyObject *result;
 
 	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "k:get_map",
 					 keywords, &idx))
@@ -4227,8 +4404,13 @@ sys_get_map(PyObject *_self, PyObject *args, PyObject *kwargs)
 		return NULL;
 	}
 
+	owner_lock(&self->lock);
 	map = addrxlat_sys_get_map(self->sys, idx);
-	return map_FromPointer(self->convert, map);
+	result = map_FromPointer(self->convert, map);
+	if (result && PyObject_TypeCheck(result, &map_type))
+		owner_lock_set(&((map_object*)result)->lock, &self->lock);
+	owner_unlock(&self->lock);
+	return result;
 }
 
 PyDoc_STRVAR(sys_set_meth__doc__,
@@ -4261,7 +4443,9 @@ sys_set_meth(PyObject *_self, PyObject *args, PyObject *kwargs)
 	if (PyErr_Occurred())
 		return NULL;
 
+	owner_lock(&self->lock);
 	addrxlat_sys_set_meth(self->sys, idx, meth);
+	owner_unlock(&self->lock);
 
 	Py_RETURN_NONE;
 }
@@ -4279,6 +4463,7 @@ sys_get_meth(PyObject *_self, PyObject *args, PyObject *kwargs)
 	static char *keywords[] = { "idx", NULL };
 	unsigned long idx;
 	const addrxlat_meth_t *meth;
+	PyObject *result;
 
 	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "k:get_meth",
 					 keywords, &idx))
@@ -4290,8 +4475,11 @@ sys_get_meth(PyObject *_self, PyObject *args, PyObject *kwargs)
 		return NULL;
 	}
 
+	owner_lock(&self->lock);
 	meth = addrxlat_sys_get_meth(self->sys, idx);
-	return meth_FromPointer(self->convert, meth);
+	result = meth_FromPointer(self->convert, meth);
+	owner_unlock(&self->lock);
+	return result;
 }
 
 static PyMethodDef sys_methods[] = {
@@ -4406,6 +4594,84 @@ replace_sys(PyObject **psysobj, addrxlat_sys_t **psys, PyObject *newval)
 	return 0;
 }
 
+/** Get the owner lock of a Python object.
+ * @param obj  Python object (may be @c NULL).
+ * @returns    Owner lock, or @c NULL if @c obj cannot have one.
+ */
+static owner_lock_t *
+get_owner_lock(PyObject *obj)
+{
+	if (!obj)
+		return NULL;
+	if (PyObject_TypeCheck(obj, &ctx_type))
+		return &((ctx_object*)obj)->lock;
+	if (PyObject_TypeCheck(obj, &map_type))
+		return &((map_object*)obj)->lock;
+	if (PyObject_TypeCheck(obj, &sys_type))
+		return &((sys_object*)obj)->lock;
+	return NULL;
+}
+
+/** Acquire the owner locks of a translation context and system.
+ * @param ctxobj  Context object (may be @c NULL or @c None).
+ * @param sysobj  System object (may be @c NULL or @c None).
+ *
+ * The context lock is always taken first.
+ */
+static void
+lock_ctx_sys(PyObject *ctxobj, PyObject *sysobj)
+{
+	owner_lock_t *lock;
+
+	if ( (lock = get_owner_lock(ctxobj)) )
+		owner_lock(lock);
+	if ( (lock = get_owner_lock(sysobj)) )
+		owner_lock(lock);
+}
+
+/** Release the owner locks taken by @ref lock_ctx_sys.
+ * @param ctxobj  Context object (may be @c NULL or @c None).
+ * @param sysobj  System object (may be @c NULL or @c None).
+ */
+static void
+unlock_ctx_sys(PyObject *ctxobj, PyObject *sysobj)
+{
+	owner_lock_t *lock;
+
+	if ( (lock = get_owner_lock(sysobj)) )
+		owner_unlock(lock);
+	if ( (lock = get_owner_lock(ctxobj)) )
+		owner_unlock(lock);
+}
+
+/** Set the owner lock of a Context, Map or System object.
+ * @param self    Context, Map or System object.
+ * @param owner   Owner object, or @c NULL to remove the lock.
+ * @param lock    Function to acquire the lock.
+ * @param unlock  Function to release the lock.
+ * @returns       Zero on success, -1 with an exception set otherwise.
+ */
+static int
+set_owner_lock(PyObject *self, PyObject *owner,
+	       addrxlat_lock_fn *lock, addrxlat_lock_fn *unlock)
+{
+	owner_lock_t *dst = get_owner_lock(self);
+	owner_lock_t src;
+
+	if (!dst) {
+		PyErr_Format(PyExc_TypeError,
+			     "need a Context, Map or System, not '%.200s'",
+			     Py_TYPE(self)->tp_name);
+		return -1;
+	}
+
+	src.owner = owner;
+	src.lock = lock;
+	src.unlock = unlock;
+	owner_lock_set(dst, &src);
+	return 0;
+}
+
 /** Number of parameter locations in @ref step_object. */
 #define STEP_NLOC	2
 
@@ -4892,7 +5158,9 @@ step_launch(PyObject *_self, PyObject *args, PyObject *kwargs)
 					 keywords, &addr))
 		return NULL;
 
+	lock_ctx_sys(self->ctx, self->sys);
 	status = addrxlat_launch(&self->step, addr);
+	unlock_ctx_sys(self->ctx, self->sys);
 	step_Init((PyObject*)self, &self->step);
 	return ctx_status_result(self->ctx, status);
 }
@@ -4913,7 +5181,9 @@ step_step(PyObject *_self, PyObject *args)
 	step_object *self = (step_object*)_self;
 	addrxlat_status status;
 
+	lock_ctx_sys(self->ctx, self->sys);
 	status = addrxlat_step(&self->step);
+	unlock_ctx_sys(self->ctx, self->sys);
 	step_Init((PyObject*)self, &self->step);
 	return ctx_status_result(self->ctx, status);
 }
@@ -4934,7 +5204,9 @@ step_walk(PyObject *_self, PyObject *args)
 	step_object *self = (step_object*)_self;
 	addrxlat_status status;
 
+	lock_ctx_sys(self->ctx, self->sys);
 	status = addrxlat_walk(&self->step);
+	unlock_ctx_sys(self->ctx, self->sys);
 	return ctx_status_result(self->ctx, status);
 }
 
@@ -5206,7 +5478,9 @@ op_call(PyObject *_self, PyObject *args, PyObject *kwargs)
 	if (!addr)
 		return NULL;
 
+	lock_ctx_sys(self->ctx, self->sys);
 	status = addrxlat_op(&self->opctl, addr);
+	unlock_ctx_sys(self->ctx, self->sys);
 	result = ctx_status_result(self->ctx, status);
 	if (result) {
 		result = Py_BuildValue("(NN)", result, self->result);
@@ -5288,9 +5562,100 @@ op_callback(PyObject *_self, PyObject *args, PyObject *kwargs)
 	Py_RETURN_NONE;
 }
 
+PyDoc_STRVAR(op_batch__doc__,
+"OP.batch(addrspace, addrs) -> (results, status)\n\
+\n\
+Translate many addresses with one call. The addresses are read from\n\
+a buffer of native unsigned 64-bit integers, all in addrspace. The\n\
+callback is not called; translated addresses are returned in another\n\
+buffer of 64-bit integers, and the error status of each translation\n\
+is returned in a buffer of native C ints. Translated addresses are in\n\
+an address space included in caps, so use an operator with a single\n\
+target address space.");
+
+/** Wrapper for @ref addrxlat_op_batch
+ * @param _self   op object
+ * @param args    positional arguments
+ * @param kwargs  keyword arguments
+ * @returns       tuple of result and status buffers (or @c NULL)
+ */
+static PyObject *
+op_batch(PyObject *_self, PyObject *args, PyObject *kwargs)
+{
+	op_object *self = (op_object*)_self;
+	static char *keywords[] = {"addrspace", "addrs", NULL};
+	PyObject *addrsobj, *resobj, *statobj, *result;
+	addrxlat_fulladdr_t *addrs;
+	addrxlat_status *status;
+	addrxlat_status ret;
+	Py_buffer view;
+	uint64_t *val;
+	int *stat;
+	int addrspace;
+	size_t i, n;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "iO:batch",
+					 keywords, &addrspace, &addrsobj))
+		return NULL;
+
+	if (PyObject_GetBuffer(addrsobj, &view, PyBUF_SIMPLE))
+		return NULL;
+	if (view.len % sizeof(uint64_t)) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_ValueError,
+				"buffer size is not a multiple of 8");
+		return NULL;
+	}
+	n = view.len / sizeof(uint64_t);
+
+	addrs = malloc(n * sizeof(*addrs) + n * sizeof(*status));
+	if (!addrs && n) {
+		PyBuffer_Release(&view);
+		return PyErr_NoMemory();
+	}
+	status = (addrxlat_status*)(addrs + n);
+	val = view.buf;
+	for (i = 0; i < n; ++i) {
+		addrs[i].addr = val[i];
+		addrs[i].as = addrspace;
+	}
+	PyBuffer_Release(&view);
+
+	lock_ctx_sys(self->ctx, self->sys);
+	ret = addrxlat_op_batch(self->opctl.ctx, self->opctl.sys,
+				self->opctl.caps, n, addrs, addrs, status);
+	unlock_ctx_sys(self->ctx, self->sys);
+	result = ctx_status_result(self->ctx, ret);
+	if (!result) {
+		free(addrs);
+		return NULL;
+	}
+	Py_DECREF(result);
+
+	resobj = PyByteArray_FromStringAndSize(NULL, n * sizeof(uint64_t));
+	statobj = PyByteArray_FromStringAndSize(NULL, n * sizeof(int));
+	if (!resobj || !statobj) {
+		Py_XDECREF(resobj);
+		Py_XDECREF(statobj);
+		free(addrs);
+		return NULL;
+	}
+	val = (uint64_t*)PyByteArray_AS_STRING(resobj);
+	stat = (int*)PyByteArray_AS_STRING(statobj);
+	for (i = 0; i < n; ++i) {
+		val[i] = addrs[i].addr;
+		stat[i] = status[i];
+	}
+	free(addrs);
+
+	return Py_BuildValue("(NN)", resobj, statobj);
+}
+
 static PyMethodDef op_methods[] = {
 	{ "callback", (PyCFunction)op_callback, METH_VARARGS,
 	  op_callback__doc__ },
+	{ "batch", (PyCFunction)op_batch, METH_VARARGS | METH_KEYWORDS,
+	  op_batch__doc__ },
 	{ NULL }
 };
 
@@ -5817,6 +6182,7 @@ init_addrxlat (void)
 	CAPI.Operator_FromPointer = op_FromPointer;
 	CAPI.Operator_Init = op_Init;
 	CAPI.Operator_AsPointer = op_AsPointer;
+	CAPI.SetOwnerLock = set_owner_lock;
 
 	obj = PyCapsule_New(&CAPI, addrxlat_CAPSULE_NAME, NULL);
 	if (!obj)
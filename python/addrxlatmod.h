@@ -39,7 +39,15 @@ extern "C" {
 #include <libkdumpfile/addrxlat.h>
 
 #define addrxlat_CAPSULE_NAME	"_addrxlat._C_API"
-#define addrxlat_CAPI_VER	1UL
+#define addrxlat_CAPI_VER	2UL
+
+/** Function to acquire or release the lock of an owner object.
+ * @param owner  Owner object (passed to @c SetOwnerLock).
+ *
+ * The function is called with the GIL held. The lock must be
+ * recursive, because Python callbacks may be invoked while it is held.
+ */
+typedef void addrxlat_lock_fn(PyObject *owner);
 
 struct addrxlat_CAPI {
 	unsigned long ver;	/**< Structure version. */
@@ -77,6 +85,14 @@ struct addrxlat_CAPI {
 	int (*Operator_Init)(PyObject *self, const addrxlat_op_ctl_t *opctl);
 	addrxlat_op_ctl_t *(*Operator_AsPointer)(PyObject *self);
 
+	/** Serialize access to a Context, Map or System object.
+	 * The lock is held while the object's C data is used. A Map
+	 * returned by a locked System shares its lock. Pass @c NULL as
+	 * @c owner to remove the lock. Returns zero on success, or -1
+	 * with a Python exception set.
+	 */
+	int (*SetOwnerLock)(PyObject *self, PyObject *owner,
+			    addrxlat_lock_fn *lock, addrxlat_lock_fn *unlock);
 };
 
 #ifdef __cplusplus
@@ -24,8 +24,71 @@ typedef struct {
 	int fd;
 	PyObject *attr;
 	PyObject *addrxlat_convert;
+
+	/* Serializes all libkdumpfile calls on this object. */
+	PyThread_type_lock lock;
+	unsigned long lock_owner; /* Thread which holds the lock. */
+	unsigned lock_depth;	/* Recursion depth of lock_owner. */
+
+	/* Object which owns the file descriptor (clones only). */
+	PyObject *parent;
 } kdumpfile_object;
 
+/* Acquire the object lock. Must be called with the GIL held.
+ * The lock is recursive, because a Python callback invoked from
+ * libkdumpfile may use the same object again.
+ */
+static void
+kdumpfile_lock(kdumpfile_object *self)
+{
+	unsigned long me = PyThread_get_thread_ident();
+
+	if (self->lock_depth && self->lock_owner == me) {
+		++self->lock_depth;
+		return;
+	}
+
+	if (!PyThread_acquire_lock(self->lock, NOWAIT_LOCK)) {
+		Py_BEGIN_ALLOW_THREADS
+		PyThread_acquire_lock(self->lock, WAIT_LOCK);
+		Py_END_ALLOW_THREADS
+	}
+	self->lock_owner = me;
+	self->lock_depth = 1;
+}
+
+/* Release the object lock. Must be called with the GIL held. */
+static void
+kdumpfile_unlock(kdumpfile_object *self)
+{
+	if (--self->lock_depth == 0)
+		PyThread_release_lock(self->lock);
+}
+
+/* Lock callbacks for addrxlat objects which share data with
+ * libkdumpfile. See get_addrxlat_ctx() and get_addrxlat_sys().
+ */
+static void
+kdumpfile_lock_cb(PyObject *owner)
+{
+	kdumpfile_lock((kdumpfile_object*)owner);
+}
+
+static void
+kdumpfile_unlock_cb(PyObject *owner)
+{
+	kdumpfile_unlock((kdumpfile_object*)owner);
+}
+
+/* Release the GIL around a potentially slow libkdumpfile call.
+ * The object lock must be held. Python callbacks invoked from the
+ * call re-acquire the GIL themselves.
+ */
+#define BEGIN_KDUMP_CALL(self)						\
+	Py_BEGIN_ALLOW_THREADS
+#define END_KDUMP_CALL							\
+	Py_END_ALLOW_THREADS
+
 static PyObject *OSErrorException;
 static PyObject *NotImplementedException;
 static PyObject *NoDataException;
@@ -44,6 +107,8 @@ static PyTypeObject attr_itervalue_object_type;
 static PyTypeObject attr_iteritem_object_type;
 
 static PyTypeObject bmp_object_type;
+static PyTypeObject bmp_runs_object_type;
+static PyTypeObject page_object_type;
 
 static PyObject *attr_viewkeys_type;
 static PyObject *attr_viewvalues_type;
@@ -53,7 +118,7 @@ static PyObject *attr_viewdict_type;
 static PyObject *attr_dir_new(kdumpfile_object *kdumpfile,
 			      const kdump_attr_ref_t *baseref);
 
-static PyObject *bmp_new(kdump_bmp_t *bitmap);
+static PyObject *bmp_new(kdumpfile_object *kdumpfile, kdump_bmp_t *bitmap);
 
 static PyObject *
 exception_map(kdump_status status)
@@ -91,6 +156,13 @@ kdumpfile_new (PyTypeObject *type, PyObject *args, PyObject *kw)
 	if (!self)
 		return NULL;
 
+	self->lock = PyThread_allocate_lock();
+	if (!self->lock) {
+		PyErr_SetString(PyExc_MemoryError,
+				"Couldn't allocate object lock");
+		goto fail;
+	}
+
 	self->ctx = kdump_new();
 	if (!self->ctx) {
 		PyErr_SetString(PyExc_MemoryError,
@@ -148,7 +220,10 @@ kdumpfile_dealloc(PyObject *_self)
 		self->ctx = NULL;
 	}
 
-	if (self->fd) close(self->fd);
+	if (self->fd > 0) close(self->fd);
+	if (self->lock)
+		PyThread_free_lock(self->lock);
+	Py_XDECREF(self->parent);
 	Py_XDECREF(self->addrxlat_convert);
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -181,18 +256,197 @@ static PyObject *kdumpfile_read (PyObject *_self, PyObject *args, PyObject *kw)
 		return NULL;
 
 	r = size;
+	kdumpfile_lock(self);
+	BEGIN_KDUMP_CALL(self)
 	status = kdump_read(self->ctx, addrspace, addr,
 			    PyByteArray_AS_STRING(obj), &r);
+	END_KDUMP_CALL
 	if (status != KDUMP_OK) {
 		Py_XDECREF(obj);
 		PyErr_SetString(exception_map(status),
 				kdump_get_err(self->ctx));
-		return NULL;
+		obj = NULL;
 	}
+	kdumpfile_unlock(self);
 
 	return obj;
 }
 
+PyDoc_STRVAR(readinto__doc__,
+"K.readinto(addrspace, address, buffer) -> number of bytes\n\
+\n\
+Read dump data directly into a writable buffer object (e.g. a bytearray,\n\
+a memoryview or an array), filling the whole buffer.");
+
+static PyObject *
+kdumpfile_readinto(PyObject *_self, PyObject *args, PyObject *kw)
+{
+	kdumpfile_object *self = (kdumpfile_object*)_self;
+	static char *keywords[] = {"addrspace", "address", "buffer", NULL};
+	unsigned long long addr;
+	kdump_status status;
+	int addrspace;
+	Py_buffer view;
+	size_t r;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "iKw*:readinto",
+					 keywords, &addrspace, &addr, &view))
+		return NULL;
+
+	r = view.len;
+	if (!r) {
+		PyBuffer_Release(&view);
+		return PyLong_FromLong(0);
+	}
+
+	kdumpfile_lock(self);
+	BEGIN_KDUMP_CALL(self)
+	status = kdump_read(self->ctx, addrspace, addr, view.buf, &r);
+	END_KDUMP_CALL
+	if (status != KDUMP_OK)
+		PyErr_SetString(exception_map(status),
+				kdump_get_err(self->ctx));
+	kdumpfile_unlock(self);
+	PyBuffer_Release(&view);
+
+	return status == KDUMP_OK
+		? PyLong_FromSize_t(r)
+		: NULL;
+}
+
+typedef struct {
+	PyObject_HEAD
+	kdumpfile_object *kdumpfile;
+	kdump_page_t *page;
+	const void *data;
+	Py_ssize_t size;
+} page_object;
+
+PyDoc_STRVAR(get_page__doc__,
+"K.get_page(addrspace, address) -> memoryview\n\
+\n\
+Get read-only access to the page which contains address without copying\n\
+its data. The view starts at the beginning of the page. It pins a page\n\
+cache entry, so release it as soon as possible, and always before\n\
+changing any cache attribute.");
+
+static PyObject *
+kdumpfile_get_page(PyObject *_self, PyObject *args, PyObject *kw)
+{
+	kdumpfile_object *self = (kdumpfile_object*)_self;
+	static char *keywords[] = {"addrspace", "address", NULL};
+	unsigned long long addr;
+	kdump_status status;
+	kdump_num_t size;
+	kdump_page_t *page;
+	const void *data;
+	page_object *pageobj;
+	PyObject *view;
+	int addrspace;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kw, "iK:get_page",
+					 keywords, &addrspace, &addr))
+		return NULL;
+
+	kdumpfile_lock(self);
+	BEGIN_KDUMP_CALL(self)
+	status = kdump_get_number_attr(self->ctx, KDUMP_ATTR_PAGE_SIZE,
+				       &size);
+	if (status == KDUMP_OK)
+		status = kdump_get_page(self->ctx, addrspace, addr,
+					&data, &page);
+	END_KDUMP_CALL
+	if (status != KDUMP_OK)
+		PyErr_SetString(exception_map(status),
+				kdump_get_err(self->ctx));
+	kdumpfile_unlock(self);
+	if (status != KDUMP_OK)
+		return NULL;
+
+	pageobj = PyObject_New(page_object, &page_object_type);
+	if (!pageobj) {
+		kdumpfile_lock(self);
+		kdump_put_page(page);
+		kdumpfile_unlock(self);
+		return NULL;
+	}
+	Py_INCREF(self);
+	pageobj->kdumpfile = self;
+	pageobj->page = page;
+	pageobj->data = data;
+	pageobj->size = size;
+
+	view = PyMemoryView_FromObject((PyObject*)pageobj);
+	Py_DECREF(pageobj);
+	return view;
+}
+
+PyDoc_STRVAR(clone__doc__,
+"K.clone() -> kdumpfile\n\
+\n\
+Create a new object for the same dump file. The clone shares cached\n\
+data and attributes with the original, but it can be used concurrently\n\
+from another thread. Reads release the GIL while they access the dump\n\
+file.");
+
+static PyObject *
+kdumpfile_clone(PyObject *_self, PyObject *args)
+{
+	kdumpfile_object *self = (kdumpfile_object*)_self;
+	kdumpfile_object *clone;
+	kdump_attr_ref_t rootref;
+	kdump_status status;
+
+	clone = (kdumpfile_object*) Py_TYPE(self)->tp_alloc(Py_TYPE(self), 0);
+	if (!clone)
+		return NULL;
+	clone->fd = -1;
+
+	clone->lock = PyThread_allocate_lock();
+	if (!clone->lock) {
+		PyErr_SetString(PyExc_MemoryError,
+				"Couldn't allocate object lock");
+		goto fail;
+	}
+
+	kdumpfile_lock(self);
+	BEGIN_KDUMP_CALL(self)
+	clone->ctx = kdump_clone(self->ctx, 0);
+	END_KDUMP_CALL
+	kdumpfile_unlock(self);
+	if (!clone->ctx) {
+		PyErr_SetString(PyExc_MemoryError,
+				"Couldn't allocate kdump context");
+		goto fail;
+	}
+
+	Py_INCREF(self);
+	clone->parent = (PyObject*)self;
+
+	status = kdump_attr_ref(clone->ctx, NULL, &rootref);
+	if (status != KDUMP_OK) {
+		PyErr_Format(exception_map(status),
+			     "Cannot reference root attribute: %s",
+			     kdump_get_err(clone->ctx));
+		goto fail;
+	}
+
+	clone->attr = attr_dir_new(clone, &rootref);
+	if (!clone->attr) {
+		kdump_attr_unref(clone->ctx, &rootref);
+		goto fail;
+	}
+
+	Py_XINCREF(self->addrxlat_convert);
+	clone->addrxlat_convert = self->addrxlat_convert;
+
+	return (PyObject*)clone;
+
+fail:
+	Py_DECREF(clone);
+	return NULL;
+}
+
 static PyObject *
 attr_new(kdumpfile_object *kdumpfile, kdump_attr_ref_t *ref, kdump_attr_t *attr)
 {
@@ -209,7 +463,7 @@ attr_new(kdumpfile_object *kdumpfile, kdump_attr_ref_t *ref, kdump_attr_t *attr)
 		case KDUMP_DIRECTORY:
 			return attr_dir_new(kdumpfile, ref);
 		case KDUMP_BITMAP:
-			return bmp_new(attr->val.bitmap);
+			return bmp_new(kdumpfile, attr->val.bitmap);
 		default:
 			PyErr_SetString(PyExc_RuntimeError, "Unhandled attr type");
 			return NULL;
@@ -217,7 +471,11 @@ attr_new(kdumpfile_object *kdumpfile, kdump_attr_ref_t *ref, kdump_attr_t *attr)
 }
 
 PyDoc_STRVAR(get_addrxlat_ctx__doc__,
-"K.get_addrxlat_ctx() -> addrxlat.Context");
+"K.get_addrxlat_ctx() -> addrxlat.Context\n\
+\n\
+Get the address translation context used by this object. The context\n\
+shares the lock of this object, so its methods wait for any pending\n\
+read from another thread.");
 
 static PyObject *
 get_addrxlat_ctx(PyObject *_self, PyObject *args)
@@ -225,18 +483,35 @@ get_addrxlat_ctx(PyObject *_self, PyObject *args)
 	kdumpfile_object *self = (kdumpfile_object*)_self;
 	addrxlat_ctx_t *ctx;
 	kdump_status status;
+	PyObject *ret;
 
+	kdumpfile_lock(self);
 	status = kdump_get_addrxlat(self->ctx, &ctx, NULL);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status),
 				kdump_get_err(self->ctx));
+		kdumpfile_unlock(self);
 		return NULL;
 	}
-	return addrxlat_API->Context_FromPointer(self->addrxlat_convert, ctx);
+	ret = addrxlat_API->Context_FromPointer(self->addrxlat_convert, ctx);
+	if (ret && ret != Py_None &&
+	    addrxlat_API->SetOwnerLock(ret, (PyObject*)self,
+				       kdumpfile_lock_cb,
+				       kdumpfile_unlock_cb)) {
+		Py_DECREF(ret);
+		ret = NULL;
+	}
+	kdumpfile_unlock(self);
+	return ret;
 }
 
 PyDoc_STRVAR(get_addrxlat_sys__doc__,
-"K.get_addrxlat_sys() -> addrxlat.System");
+"K.get_addrxlat_sys() -> addrxlat.System\n\
+\n\
+Get the address translation system used by this object. The system\n\
+(and any map obtained from it) shares the lock of this object. Clones\n\
+share the translation system, but not the lock, so do not modify it\n\
+while a clone is used from another thread.");
 
 static PyObject *
 get_addrxlat_sys(PyObject *_self, PyObject *args)
@@ -244,19 +519,39 @@ get_addrxlat_sys(PyObject *_self, PyObject *args)
 	kdumpfile_object *self = (kdumpfile_object*)_self;
 	addrxlat_sys_t *sys;
 	kdump_status status;
+	PyObject *ret;
 
+	kdumpfile_lock(self);
 	status = kdump_get_addrxlat(self->ctx, NULL, &sys);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status),
 				kdump_get_err(self->ctx));
+		kdumpfile_unlock(self);
 		return NULL;
 	}
-	return addrxlat_API->System_FromPointer(self->addrxlat_convert, sys);
+	ret = addrxlat_API->System_FromPointer(self->addrxlat_convert, sys);
+	if (ret && ret != Py_None &&
+	    addrxlat_API->SetOwnerLock(ret, (PyObject*)self,
+				       kdumpfile_lock_cb,
+				       kdumpfile_unlock_cb)) {
+		Py_DECREF(ret);
+		ret = NULL;
+	}
+	kdumpfile_unlock(self);
+	return ret;
 }
 
 static PyMethodDef kdumpfile_object_methods[] = {
 	{"read",      (PyCFunction) kdumpfile_read, METH_VARARGS | METH_KEYWORDS,
 		read__doc__},
+	{"readinto",  (PyCFunction) kdumpfile_readinto,
+	  METH_VARARGS | METH_KEYWORDS,
+		readinto__doc__},
+	{"get_page",  (PyCFunction) kdumpfile_get_page,
+	  METH_VARARGS | METH_KEYWORDS,
+		get_page__doc__},
+	{"clone",     kdumpfile_clone, METH_NOARGS,
+		clone__doc__},
 	{ "get_addrxlat_ctx", get_addrxlat_ctx, METH_NOARGS,
 	  get_addrxlat_ctx__doc__ },
 	{ "get_addrxlat_sys", get_addrxlat_sys, METH_NOARGS,
@@ -460,6 +755,7 @@ lookup_attribute(attr_dir_object *self, PyObject *key, kdump_attr_ref_t *ref)
 		kdump_ctx_t *ctx = self->kdumpfile->ctx;
 		kdump_status status;
 
+		kdumpfile_lock(self->kdumpfile);
 		status = kdump_sub_attr_ref(ctx, &self->baseref, keystr, ref);
 		if (status == KDUMP_OK)
 			ret = 1;
@@ -468,6 +764,7 @@ lookup_attribute(attr_dir_object *self, PyObject *key, kdump_attr_ref_t *ref)
 		else
 			PyErr_SetString(exception_map(status),
 					kdump_get_err(ctx));
+		kdumpfile_unlock(self->kdumpfile);
 	}
 
 	if (stringkey != key)
@@ -498,8 +795,10 @@ attr_dir_contains(PyObject *_self, PyObject *key)
 
 	ret = lookup_attribute(self, key, &ref);
 	if (ret > 0) {
+		kdumpfile_lock(self->kdumpfile);
 		ret = kdump_attr_ref_isset(&ref);
 		kdump_attr_unref(self->kdumpfile->ctx, &ref);
+		kdumpfile_unlock(self->kdumpfile);
 	}
 	return ret;
 }
@@ -526,6 +825,7 @@ attr_dir_length(PyObject *_self)
 	kdump_status status;
 	Py_ssize_t len = 0;
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_iter_start(ctx, &self->baseref, &iter);
 	if (status != KDUMP_OK)
 		goto err;
@@ -540,10 +840,12 @@ attr_dir_length(PyObject *_self)
 	if (status != KDUMP_OK)
 		goto err;
 
+	kdumpfile_unlock(self->kdumpfile);
 	return len;
 
  err:
 	PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+	kdumpfile_unlock(self->kdumpfile);
 	return -1;
 }
 
@@ -555,14 +857,19 @@ attr_dir_subscript(PyObject *_self, PyObject *key)
 	kdump_attr_t attr;
 	kdump_attr_ref_t ref;
 	kdump_status status;
+	PyObject *ret;
 
 	if (get_attribute(self, key, &ref) <= 0)
 		return NULL;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_get(ctx, &ref, &attr);
-	if (status == KDUMP_OK)
-		return attr_new(self->kdumpfile, &ref, &attr);
+	if (status == KDUMP_OK) {
+		ret = attr_new(self->kdumpfile, &ref, &attr);
+		kdumpfile_unlock(self->kdumpfile);
+		return ret;
+	}
 
 	if (status == KDUMP_ERR_NODATA)
 		PyErr_SetObject(PyExc_KeyError, key);
@@ -570,6 +877,7 @@ attr_dir_subscript(PyObject *_self, PyObject *key)
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
 
 	kdump_attr_unref(ctx, &ref);
+	kdumpfile_unlock(self->kdumpfile);
 	return NULL;
 }
 
@@ -665,15 +973,15 @@ set_attribute(attr_dir_object *self, kdump_attr_ref_t *ref, PyObject *value)
 		return -1;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_set(ctx, ref, &attr);
+	if (status != KDUMP_OK)
+		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+	kdumpfile_unlock(self->kdumpfile);
 	if (conv != value)
 		Py_XDECREF(conv);
-	if (status != KDUMP_OK) {
-		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
-		return -1;
-	}
 
-	return 0;
+	return status == KDUMP_OK ? 0 : -1;
 }
 
 static int
@@ -687,7 +995,9 @@ attr_dir_ass_subscript(PyObject *_self, PyObject *key, PyObject *value)
 		return ret;
 
 	ret = set_attribute(self, &ref, value);
+	kdumpfile_lock(self->kdumpfile);
 	kdump_attr_unref(self->kdumpfile->ctx, &ref);
+	kdumpfile_unlock(self->kdumpfile);
 	return ret;
 }
 
@@ -719,7 +1029,9 @@ attr_dir_dealloc(PyObject *_self)
 	attr_dir_object *self = (attr_dir_object*)_self;
 
 	PyObject_GC_UnTrack(self);
+	kdumpfile_lock(self->kdumpfile);
 	kdump_attr_unref(self->kdumpfile->ctx, &self->baseref);
+	kdumpfile_unlock(self->kdumpfile);
 	Py_XDECREF((PyObject*)self->kdumpfile);
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -833,14 +1145,21 @@ attr_dir_get(PyObject *_self, PyObject *args)
 		goto notfound;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_get(ctx, &ref, &attr);
-	if (status == KDUMP_OK)
-		return attr_new(self->kdumpfile, &ref, &attr);
+	if (status == KDUMP_OK) {
+		PyObject *ret = attr_new(self->kdumpfile, &ref, &attr);
+		kdumpfile_unlock(self->kdumpfile);
+		return ret;
+	}
 
+	kdump_attr_unref(ctx, &ref);
 	if (status != KDUMP_ERR_NODATA) {
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+		kdumpfile_unlock(self->kdumpfile);
 		return NULL;
 	}
+	kdumpfile_unlock(self->kdumpfile);
 
  notfound:
 	Py_INCREF(failobj);
@@ -869,6 +1188,7 @@ dict_setdefault(PyObject *_self, PyObject *args)
 		return NULL;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_get(ctx, &ref, &attr);
 	if (status == KDUMP_OK)
 		val = attr_new(self->kdumpfile, &ref, &attr);
@@ -881,6 +1201,7 @@ dict_setdefault(PyObject *_self, PyObject *args)
 		val = NULL;
 	}
 	kdump_attr_unref(ctx, &ref);
+	kdumpfile_unlock(self->kdumpfile);
 
 	Py_XINCREF(val);
 	return val;
@@ -1021,6 +1342,7 @@ attr_dir_clear(PyObject *_self, PyObject *args)
 	kdump_attr_t attr;
 	kdump_status status;
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_iter_start(ctx, &self->baseref, &iter);
 	if (status != KDUMP_OK)
 		goto err_noiter;
@@ -1036,12 +1358,14 @@ attr_dir_clear(PyObject *_self, PyObject *args)
 	}
 
 	kdump_attr_iter_end(ctx, &iter);
+	kdumpfile_unlock(self->kdumpfile);
 	Py_RETURN_NONE;
 
  err:
 	kdump_attr_iter_end(ctx, &iter);
  err_noiter:
 	PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+	kdumpfile_unlock(self->kdumpfile);
 	return NULL;
 }
 
@@ -1058,9 +1382,11 @@ attr_dir_repr(PyObject *_self)
 	PyObject *result = NULL;
 	int res;
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_iter_start(ctx, &self->baseref, &iter);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+		kdumpfile_unlock(self->kdumpfile);
 		return NULL;
 	}
 
@@ -1134,6 +1460,7 @@ attr_dir_repr(PyObject *_self)
 
  out:
 	kdump_attr_iter_end(ctx, &iter);
+	kdumpfile_unlock(self->kdumpfile);
 	Py_XDECREF(pieces);
 	Py_XDECREF(colon);
 	return result;
@@ -1150,9 +1477,11 @@ attr_dir_print(PyObject *_self, FILE *fp, int flags)
 	PyObject *s, *temp;
 	int res;
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_iter_start(ctx, &self->baseref, &iter);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+		kdumpfile_unlock(self->kdumpfile);
 		return -1;
 	}
 
@@ -1198,6 +1527,7 @@ attr_dir_print(PyObject *_self, FILE *fp, int flags)
 	}
 
 	kdump_attr_iter_end(ctx, &iter);
+	kdumpfile_unlock(self->kdumpfile);
 
 	Py_BEGIN_ALLOW_THREADS
 	fputs("})", fp);
@@ -1207,6 +1537,7 @@ attr_dir_print(PyObject *_self, FILE *fp, int flags)
 
  err:
 	kdump_attr_iter_end(ctx, &iter);
+	kdumpfile_unlock(self->kdumpfile);
 	return -1;
 }
 
@@ -1489,10 +1820,13 @@ attr_iter_new(attr_dir_object *attr_dir, PyTypeObject *itertype)
 	if (self == NULL)
 		return NULL;
 
+	kdumpfile_lock(attr_dir->kdumpfile);
 	status = kdump_attr_ref_iter_start(ctx, &attr_dir->baseref,
 					   &self->iter);
-	if (status != KDUMP_OK) {
+	if (status != KDUMP_OK)
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+	kdumpfile_unlock(attr_dir->kdumpfile);
+	if (status != KDUMP_OK) {
 		Py_DECREF(self);
 		return NULL;
 	}
@@ -1509,7 +1843,9 @@ attr_iter_dealloc(PyObject *_self)
 	attr_iter_object *self = (attr_iter_object*)_self;
 	kdump_ctx_t *ctx = self->kdumpfile->ctx;
 
+	kdumpfile_lock(self->kdumpfile);
 	kdump_attr_iter_end(ctx, &self->iter);
+	kdumpfile_unlock(self->kdumpfile);
 	PyObject_GC_UnTrack(self);
 	Py_XDECREF((PyObject*)self->kdumpfile);
 	Py_TYPE(self)->tp_free((PyObject*)self);
@@ -1530,9 +1866,12 @@ attr_iter_advance(attr_iter_object *self, PyObject *ret)
 	kdump_ctx_t *ctx = self->kdumpfile->ctx;
 	kdump_status status;
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_iter_next(ctx, &self->iter);
-	if (status != KDUMP_OK) {
+	if (status != KDUMP_OK)
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+	kdumpfile_unlock(self->kdumpfile);
+	if (status != KDUMP_OK) {
 		Py_XDECREF(ret);
 		ret = NULL;
 	}
@@ -1564,13 +1903,16 @@ attr_itervalue_next(PyObject *_self)
 		return NULL;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_get(ctx, &self->iter.pos, &attr);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
+		kdumpfile_unlock(self->kdumpfile);
 		return NULL;
 	}
 
 	value = attr_new(self->kdumpfile, &self->iter.pos, &attr);
+	kdumpfile_unlock(self->kdumpfile);
 	return attr_iter_advance(self, value);
 }
 
@@ -1587,21 +1929,23 @@ attr_iteritem_next(PyObject *_self)
 		return NULL;
 
 	ctx = self->kdumpfile->ctx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_attr_ref_get(ctx, &self->iter.pos, &attr);
 	if (status != KDUMP_OK) {
 		PyErr_SetString(exception_map(status), kdump_get_err(ctx));
-		return NULL;
+		goto err_unlock;
 	}
 
 	result = PyTuple_New(2);
 	if (result == NULL)
-		return NULL;
+		goto err_unlock;
 	key = PyString_FromString(self->iter.key);
 	if (!key)
 		goto err_result;
 	value = attr_new(self->kdumpfile, &self->iter.pos, &attr);
 	if (!value)
 		goto err_key;
+	kdumpfile_unlock(self->kdumpfile);
 
 	PyTuple_SET_ITEM(result, 0, key);
 	PyTuple_SET_ITEM(result, 1, value);
@@ -1611,6 +1955,8 @@ attr_iteritem_next(PyObject *_self)
 	Py_DECREF(key);
  err_result:
 	Py_DECREF(result);
+ err_unlock:
+	kdumpfile_unlock(self->kdumpfile);
 	return NULL;
 }
 
@@ -1709,6 +2055,7 @@ static PyTypeObject attr_iteritem_object_type = {
 
 typedef struct {
 	PyObject_HEAD
+	kdumpfile_object *kdumpfile;
 	kdump_bmp_t *bmp;
 } bmp_object;
 
@@ -1716,7 +2063,7 @@ PyDoc_STRVAR(bmp__doc__,
 "bmp() -> dump bitmap");
 
 static PyObject *
-bmp_new(kdump_bmp_t *bmp)
+bmp_new(kdumpfile_object *kdumpfile, kdump_bmp_t *bmp)
 {
 	bmp_object *self;
 
@@ -1724,6 +2071,8 @@ bmp_new(kdump_bmp_t *bmp)
 	if (!self)
 		return NULL;
 
+	Py_INCREF((PyObject*)kdumpfile);
+	self->kdumpfile = kdumpfile;
 	kdump_bmp_incref(bmp);
 	self->bmp = bmp;
 
@@ -1735,8 +2084,12 @@ bmp_dealloc(PyObject *_self)
 {
 	bmp_object *self = (bmp_object*)_self;
 
-	if (self->bmp)
+	if (self->bmp) {
+		kdumpfile_lock(self->kdumpfile);
 		kdump_bmp_decref(self->bmp);
+		kdumpfile_unlock(self->kdumpfile);
+	}
+	Py_XDECREF((PyObject*)self->kdumpfile);
 
 	Py_TYPE(self)->tp_free((PyObject*)self);
 }
@@ -1771,6 +2124,7 @@ bmp_get_bits(PyObject *_self, PyObject *args, PyObject *kwargs)
 	}
 
 
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_bmp_get_bits(
 		self->bmp, first, last,
 		(unsigned char*)PyByteArray_AS_STRING(buffer));
@@ -1778,12 +2132,216 @@ bmp_get_bits(PyObject *_self, PyObject *args, PyObject *kwargs)
 		Py_DECREF(buffer);
 		PyErr_SetString(exception_map(status),
 				kdump_bmp_get_err(self->bmp));
-		return NULL;
+		buffer = NULL;
 	}
+	kdumpfile_unlock(self->kdumpfile);
 
 	return buffer;
 }
 
+PyDoc_STRVAR(bmp_get_bits_into__doc__,
+"BMP.get_bits_into(first, last, buffer) -> number of bytes\n\
+\n\
+Store bitmap bits as a raw bitmap into a writable buffer object\n\
+(e.g. a bytearray or a numpy array). The buffer must be large enough\n\
+to hold all bits between first and last (inclusive).");
+
+static PyObject *
+bmp_get_bits_into(PyObject *_self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"first", "last", "buffer", NULL};
+	bmp_object *self = (bmp_object*)_self;
+	unsigned long long first, last;
+	Py_buffer view;
+	Py_ssize_t sz;
+	kdump_status status;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "KKw*:get_bits_into",
+					 keywords, &first, &last, &view))
+		return NULL;
+
+	if (last < first) {
+		PyBuffer_Release(&view);
+		PyErr_SetString(PyExc_ValueError, "Invalid bit range");
+		return NULL;
+	}
+
+	sz = (((last - first) | 7) + 1) / 8;
+	if (view.len < sz) {
+		PyBuffer_Release(&view);
+		PyErr_Format(PyExc_ValueError,
+			     "Buffer too small (%zd bytes needed)", sz);
+		return NULL;
+	}
+
+	kdumpfile_lock(self->kdumpfile);
+	status = kdump_bmp_get_bits(self->bmp, first, last, view.buf);
+	if (status != KDUMP_OK)
+		PyErr_SetString(exception_map(status),
+				kdump_bmp_get_err(self->bmp));
+	kdumpfile_unlock(self->kdumpfile);
+	PyBuffer_Release(&view);
+	if (status != KDUMP_OK)
+		return NULL;
+
+	return PyLong_FromSsize_t(sz);
+}
+
+/** Number of runs fetched from the bitmap at once. */
+#define RUNS_BATCH	256
+
+typedef struct {
+	PyObject_HEAD
+	bmp_object *bmp;
+	kdump_addr_t idx;
+	kdump_addr_t last;
+	int done;
+
+	/** Runs fetched by the last call to kdump_bmp_iter_runs(). */
+	kdump_addr_t run[RUNS_BATCH][2];
+	unsigned nruns;		/**< Number of entries in @c run. */
+	unsigned pos;		/**< Position of the next run to return. */
+} bmp_runs_object;
+
+PyDoc_STRVAR(bmp_runs__doc__,
+"BMP.runs(first=0, last=None) -> iterator\n\
+\n\
+Iterate over runs of set bits between first and last (inclusive).\n\
+Each run is returned as a (start, length) tuple.");
+
+static PyObject *
+bmp_runs(PyObject *_self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = {"first", "last", NULL};
+	bmp_object *self = (bmp_object*)_self;
+	unsigned long long first, last;
+	PyObject *lastobj;
+	bmp_runs_object *runs;
+
+	first = 0;
+	lastobj = Py_None;
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|KO:runs",
+					 keywords, &first, &lastobj))
+		return NULL;
+
+	if (lastobj == Py_None)
+		last = KDUMP_ADDR_MAX;
+	else {
+		last = PyLong_AsUnsignedLongLong(lastobj);
+		if (PyErr_Occurred())
+			return NULL;
+	}
+
+	runs = PyObject_New(bmp_runs_object, &bmp_runs_object_type);
+	if (!runs)
+		return NULL;
+
+	Py_INCREF(self);
+	runs->bmp = self;
+	runs->idx = first;
+	runs->last = last;
+	runs->done = (last < first);
+	runs->nruns = 0;
+	runs->pos = 0;
+
+	return (PyObject*)runs;
+}
+
+static void
+bmp_runs_dealloc(PyObject *_self)
+{
+	bmp_runs_object *self = (bmp_runs_object*)_self;
+
+	Py_XDECREF(self->bmp);
+	PyObject_Del(self);
+}
+
+static int
+bmp_runs_add(void *data, kdump_addr_t first, kdump_addr_t last)
+{
+	bmp_runs_object *self = data;
+
+	self->run[self->nruns][0] = first;
+	self->run[self->nruns][1] = last;
+	return ++self->nruns >= RUNS_BATCH;
+}
+
+static PyObject *
+bmp_runs_next(PyObject *_self)
+{
+	bmp_runs_object *self = (bmp_runs_object*)_self;
+	kdump_addr_t start, end;
+	kdump_status status;
+
+	if (self->pos >= self->nruns) {
+		if (self->done)
+			return NULL;
+
+		self->nruns = 0;
+		self->pos = 0;
+		kdumpfile_lock(self->bmp->kdumpfile);
+		status = kdump_bmp_iter_runs(self->bmp->bmp,
+					     self->idx, self->last,
+					     bmp_runs_add, self);
+		if (status != KDUMP_OK)
+			PyErr_SetString(exception_map(status),
+					kdump_bmp_get_err(self->bmp->bmp));
+		kdumpfile_unlock(self->bmp->kdumpfile);
+		if (status != KDUMP_OK) {
+			self->done = 1;
+			return NULL;
+		}
+
+		/* Each run is maximal, so the next index is clear. */
+		if (self->nruns < RUNS_BATCH ||
+		    self->run[self->nruns - 1][1] >= self->last)
+			self->done = 1;
+		else
+			self->idx = self->run[self->nruns - 1][1] + 1;
+
+		if (!self->nruns)
+			return NULL;
+	}
+
+	start = self->run[self->pos][0];
+	end = self->run[self->pos][1] + 1;
+	++self->pos;
+
+	return Py_BuildValue("(KK)", (unsigned long long) start,
+			     (unsigned long long) (end - start));
+}
+
+static PyTypeObject bmp_runs_object_type =
+{
+	PyVarObject_HEAD_INIT(NULL, 0)
+	MOD_NAME ".bmp_runs",		/* tp_name */
+	sizeof (bmp_runs_object),	/* tp_basicsize */
+	0,				/* tp_itemsize */
+	bmp_runs_dealloc,		/* tp_dealloc */
+	0,				/* tp_print */
+	0,				/* tp_getattr */
+	0,				/* tp_setattr */
+	0,				/* tp_compare */
+	0,				/* tp_repr */
+	0,				/* tp_as_number */
+	0,				/* tp_as_sequence */
+	0,				/* tp_as_mapping */
+	0,				/* tp_hash */
+	0,				/* tp_call */
+	0,				/* tp_str */
+	0,				/* tp_getattro */
+	0,				/* tp_setattro */
+	0,				/* tp_as_buffer */
+	Py_TPFLAGS_DEFAULT,		/* tp_flags */
+	0,				/* tp_doc */
+	0,				/* tp_traverse */
+	0,				/* tp_clear */
+	0,				/* tp_richcompare */
+	0,				/* tp_weaklistoffset */
+	PyObject_SelfIter,		/* tp_iter */
+	bmp_runs_next,			/* tp_iternext */
+};
+
 PyDoc_STRVAR(bmp_find_set__doc__,
 "BMP.find_set(idx) -> index\n\
 \n\
@@ -1803,12 +2361,14 @@ bmp_find_set(PyObject *_self, PyObject *args, PyObject *kwargs)
 		return NULL;
 
 	idx = argidx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_bmp_find_set(self->bmp, &idx);
-	if (status != KDUMP_OK) {
+	if (status != KDUMP_OK)
 		PyErr_SetString(exception_map(status),
 				kdump_bmp_get_err(self->bmp));
+	kdumpfile_unlock(self->kdumpfile);
+	if (status != KDUMP_OK)
 		return NULL;
-	}
 
 	return PyLong_FromUnsignedLong(idx);
 }
@@ -1832,12 +2392,14 @@ bmp_find_clear(PyObject *_self, PyObject *args, PyObject *kwargs)
 		return NULL;
 
 	idx = argidx;
+	kdumpfile_lock(self->kdumpfile);
 	status = kdump_bmp_find_clear(self->bmp, &idx);
-	if (status != KDUMP_OK) {
+	if (status != KDUMP_OK)
 		PyErr_SetString(exception_map(status),
 				kdump_bmp_get_err(self->bmp));
+	kdumpfile_unlock(self->kdumpfile);
+	if (status != KDUMP_OK)
 		return NULL;
-	}
 
 	return PyLong_FromUnsignedLong(idx);
 }
@@ -1846,6 +2408,12 @@ static PyMethodDef bmp_methods[] = {
 	{ "get_bits", (PyCFunction)bmp_get_bits,
 	  METH_VARARGS | METH_KEYWORDS,
 	  bmp_get_bits__doc__ },
+	{ "get_bits_into", (PyCFunction)bmp_get_bits_into,
+	  METH_VARARGS | METH_KEYWORDS,
+	  bmp_get_bits_into__doc__ },
+	{ "runs", (PyCFunction)bmp_runs,
+	  METH_VARARGS | METH_KEYWORDS,
+	  bmp_runs__doc__ },
 	{ "find_set", (PyCFunction)bmp_find_set,
 	  METH_VARARGS | METH_KEYWORDS,
 	  bmp_find_set__doc__ },
@@ -1888,6 +2456,64 @@ static PyTypeObject bmp_object_type =
 	bmp_methods,			/* tp_methods */
 };
 
+static void
+page_dealloc(PyObject *_self)
+{
+	page_object *self = (page_object*)_self;
+	kdumpfile_object *kdumpfile = self->kdumpfile;
+
+	kdumpfile_lock(kdumpfile);
+	kdump_put_page(self->page);
+	kdumpfile_unlock(kdumpfile);
+
+	Py_DECREF(kdumpfile);
+	PyObject_Del(self);
+}
+
+static int
+page_getbuffer(PyObject *_self, Py_buffer *view, int flags)
+{
+	page_object *self = (page_object*)_self;
+
+	return PyBuffer_FillInfo(view, _self, (void*)self->data,
+				 self->size, 1, flags);
+}
+
+static PyBufferProcs page_as_buffer = {
+	.bf_getbuffer = page_getbuffer,
+};
+
+#if PY_MAJOR_VERSION >= 3
+#define PAGE_TPFLAGS	Py_TPFLAGS_DEFAULT
+#else
+#define PAGE_TPFLAGS	(Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER)
+#endif
+
+static PyTypeObject page_object_type =
+{
+	PyVarObject_HEAD_INIT(NULL, 0)
+	MOD_NAME ".page",		/* tp_name */
+	sizeof (page_object),		/* tp_basicsize */
+	0,				/* tp_itemsize */
+	page_dealloc,			/* tp_dealloc */
+	0,				/* tp_print */
+	0,				/* tp_getattr */
+	0,				/* tp_setattr */
+	0,				/* tp_compare */
+	0,				/* tp_repr */
+	0,				/* tp_as_number */
+	0,				/* tp_as_sequence */
+	0,				/* tp_as_mapping */
+	0,				/* tp_hash */
+	0,				/* tp_call */
+	0,				/* tp_str */
+	0,				/* tp_getattro */
+	0,				/* tp_setattro */
+	&page_as_buffer,		/* tp_as_buffer */
+	PAGE_TPFLAGS,			/* tp_flags */
+	"borrowed dump page",		/* tp_doc */
+};
+
 struct constdef {
 	const char *name;
 	int value;
@@ -1945,6 +2571,10 @@ init_kdumpfile (void)
 		return MOD_ERROR_VAL;
 	if (PyType_Ready(&bmp_object_type) < 0)
 		return MOD_ERROR_VAL;
+	if (PyType_Ready(&page_object_type) < 0)
+		return MOD_ERROR_VAL;
+	if (PyType_Ready(&bmp_runs_object_type) < 0)
+		return MOD_ERROR_VAL;
 
 #if PY_MAJOR_VERSION >= 3
 	mod = PyModule_Create(&kdumpfile_moddef);
@@ -3,6 +3,7 @@
 
 import unittest
 import addrxlat
+import struct
 import sys
 
 if (sys.version_info.major >= 3):
@@ -780,6 +781,31 @@ class TestTranslation(unittest.TestCase):
         result = myop(addrxlat.FullAddress(addrxlat.KVADDR, 0xabc))
         self.assertEqual(result, '0x1abc')
 
+    def test_op_batch(self):
+        "Batch translation using Operator"
+        myop = addrxlat.Operator(ctx=self.ctx, sys=self.sys, caps=addrxlat.CAPS(addrxlat.KPHYSADDR))
+        addrs = (0x6502, 0x1234, 0x4255, 0x2055, 0x4055)
+        buf = bytearray(struct.pack('={}Q'.format(len(addrs)), *addrs))
+        result, status = myop.batch(addrxlat.KVADDR, buf)
+        self.assertEqual(struct.unpack('={}Q'.format(len(addrs)), result),
+                         (0xc002, 0x2234, 0, 0xfa55, 0xaa55))
+        self.assertEqual(struct.unpack('={}i'.format(len(addrs)), status),
+                         (addrxlat.OK, addrxlat.OK, addrxlat.ERR_NOMETH,
+                          addrxlat.OK, addrxlat.OK))
+
+    def test_op_batch_empty(self):
+        "Batch translation of no addresses"
+        myop = addrxlat.Operator(ctx=self.ctx, sys=self.sys, caps=addrxlat.CAPS(addrxlat.KPHYSADDR))
+        result, status = myop.batch(addrxlat.KVADDR, b'')
+        self.assertEqual(len(result), 0)
+        self.assertEqual(len(status), 0)
+
+    def test_op_batch_badlen(self):
+        "Batch translation with a truncated buffer"
+        myop = addrxlat.Operator(ctx=self.ctx, sys=self.sys, caps=addrxlat.CAPS(addrxlat.KPHYSADDR))
+        with self.assertRaises(ValueError):
+            myop.batch(addrxlat.KVADDR, b'\0' * 12)
+
     def test_subclass_memarr(self):
         "KV -> KPHYS using memory array and a subclass"
 
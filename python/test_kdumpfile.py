@@ -0,0 +1,211 @@
+#!/usr/bin/env python
+# vim:sw=4 ts=4 et
+
+import unittest
+import addrxlat
+import kdumpfile
+from kdumpfile.exceptions import NoDataException
+import os
+import struct
+import sys
+import tempfile
+import threading
+
+if (sys.version_info.major >= 3):
+    xrange = range
+
+PAGE_SIZE = 4096
+NPAGES = 4
+PHYS_BASE = 0x10000
+
+def page_data(idx):
+    return bytearray([(idx * 16 + i) & 0xff for i in xrange(PAGE_SIZE)])
+
+def make_elf_dump(path):
+    '''Create a minimal x86_64 ELF core file with one LOAD segment.'''
+    ehdr = struct.pack('<4sBBBBB7xHHIQQQIHHHHHH',
+                       b'\x7fELF', 2, 1, 1, 0, 0,
+                       4,               # e_type = ET_CORE
+                       62,              # e_machine = EM_X86_64
+                       1,               # e_version
+                       0,               # e_entry
+                       64,              # e_phoff
+                       0,               # e_shoff
+                       0,               # e_flags
+                       64,              # e_ehsize
+                       56,              # e_phentsize
+                       1,               # e_phnum
+                       64, 0, 0)
+    phdr = struct.pack('<IIQQQQQQ',
+                       1,               # p_type = PT_LOAD
+                       4,               # p_flags = PF_R
+                       PAGE_SIZE,       # p_offset
+                       0,               # p_vaddr
+                       PHYS_BASE,       # p_paddr
+                       NPAGES * PAGE_SIZE,
+                       NPAGES * PAGE_SIZE,
+                       PAGE_SIZE)
+    with open(path, 'wb') as f:
+        f.write(ehdr + phdr)
+        f.write(b'\0' * (PAGE_SIZE - len(ehdr) - len(phdr)))
+        for i in xrange(NPAGES):
+            f.write(page_data(i))
+
+class TestRead(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        fd, cls.path = tempfile.mkstemp(prefix='test_kdumpfile')
+        os.close(fd)
+        make_elf_dump(cls.path)
+
+    @classmethod
+    def tearDownClass(cls):
+        os.unlink(cls.path)
+
+    def setUp(self):
+        self.k = kdumpfile.kdumpfile(self.path)
+
+    def test_read(self):
+        data = self.k.read(kdumpfile.KDUMP_MACHPHYSADDR,
+                           PHYS_BASE + PAGE_SIZE, 16)
+        self.assertEqual(data, page_data(1)[:16])
+
+    def test_readinto(self):
+        buf = bytearray(PAGE_SIZE + 8)
+        n = self.k.readinto(kdumpfile.KDUMP_MACHPHYSADDR,
+                            PHYS_BASE + 8, buf)
+        self.assertEqual(n, len(buf))
+        self.assertEqual(buf, page_data(0)[8:] + page_data(1)[:16])
+
+    def test_readinto_memoryview(self):
+        buf = bytearray(32)
+        n = self.k.readinto(kdumpfile.KDUMP_MACHPHYSADDR,
+                            PHYS_BASE + 2 * PAGE_SIZE,
+                            memoryview(buf)[8:24])
+        self.assertEqual(n, 16)
+        self.assertEqual(buf[:8], bytearray(8))
+        self.assertEqual(buf[8:24], page_data(2)[:16])
+        self.assertEqual(buf[24:], bytearray(8))
+
+    def test_readinto_readonly(self):
+        with self.assertRaises(TypeError):
+            self.k.readinto(kdumpfile.KDUMP_MACHPHYSADDR,
+                            PHYS_BASE, b'readonly')
+
+    def test_readinto_nodata(self):
+        buf = bytearray(16)
+        with self.assertRaises(NoDataException):
+            self.k.readinto(kdumpfile.KDUMP_MACHPHYSADDR,
+                            PHYS_BASE + NPAGES * PAGE_SIZE, buf)
+
+    def test_get_page(self):
+        view = self.k.get_page(kdumpfile.KDUMP_MACHPHYSADDR,
+                               PHYS_BASE + 3 * PAGE_SIZE + 100)
+        self.assertTrue(view.readonly)
+        self.assertEqual(len(view), PAGE_SIZE)
+        self.assertEqual(bytearray(view), page_data(3))
+        view.release()
+
+    def test_get_page_readonly(self):
+        view = self.k.get_page(kdumpfile.KDUMP_MACHPHYSADDR, PHYS_BASE)
+        with self.assertRaises(TypeError):
+            view[0] = 0
+        view.release()
+
+    def test_get_page_lifetime(self):
+        view = self.k.get_page(kdumpfile.KDUMP_MACHPHYSADDR, PHYS_BASE)
+        sub = view[16:32]
+        del view
+        del self.k
+        self.assertEqual(bytearray(sub), page_data(0)[16:32])
+
+    def test_get_page_many(self):
+        # Pin more pages than fit in a small cache.
+        self.k.attr['cache.size'] = 2
+        views = [ self.k.get_page(kdumpfile.KDUMP_MACHPHYSADDR,
+                                  PHYS_BASE + i * PAGE_SIZE)
+                  for i in xrange(NPAGES) ]
+        for i in xrange(NPAGES):
+            self.assertEqual(bytearray(views[i]), page_data(i))
+
+    def test_clone(self):
+        clone = self.k.clone()
+        data = clone.read(kdumpfile.KDUMP_MACHPHYSADDR,
+                          PHYS_BASE + PAGE_SIZE, 16)
+        self.assertEqual(data, page_data(1)[:16])
+        self.assertEqual(clone.attr['file.format'],
+                         self.k.attr['file.format'])
+
+    def test_clone_lifetime(self):
+        clone = self.k.clone()
+        del self.k
+        data = clone.read(kdumpfile.KDUMP_MACHPHYSADDR, PHYS_BASE, 16)
+        self.assertEqual(data, page_data(0)[:16])
+
+    def test_bitmap_lifetime(self):
+        bmp = self.k.attr['file.pagemap']
+        del self.k
+        self.assertEqual(bmp.find_set(0), PHYS_BASE // PAGE_SIZE)
+
+    def test_threads(self):
+        errors = []
+
+        def reader(k, idx):
+            buf = bytearray(PAGE_SIZE)
+            try:
+                for i in xrange(200):
+                    page = (idx + i) % NPAGES
+                    k.readinto(kdumpfile.KDUMP_MACHPHYSADDR,
+                               PHYS_BASE + page * PAGE_SIZE, buf)
+                    if buf != page_data(page):
+                        errors.append('bad data in page %d' % page)
+                    view = k.get_page(kdumpfile.KDUMP_MACHPHYSADDR,
+                                      PHYS_BASE + page * PAGE_SIZE)
+                    if bytearray(view[:16]) != page_data(page)[:16]:
+                        errors.append('bad view of page %d' % page)
+                    view.release()
+                    k.attr['file.format']
+            except Exception as e:
+                errors.append(repr(e))
+
+        # Share one object and use clones at the same time.
+        objs = [ self.k, self.k, self.k.clone(), self.k.clone() ]
+        threads = [ threading.Thread(target=reader, args=(k, i))
+                    for i, k in enumerate(objs) ]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        self.assertEqual(errors, [])
+
+    def test_threads_addrxlat(self):
+        # Addrxlat objects may run Python callbacks inside libkdumpfile,
+        # and they share the lock of their kdumpfile object.
+        ctx = self.k.get_addrxlat_ctx()
+        xlatsys = self.k.get_addrxlat_sys()
+        stop = threading.Event()
+        errors = []
+
+        def xlat_user():
+            try:
+                while not stop.is_set():
+                    ctx.clear_err()
+                    ctx.get_err()
+                    for idx in xrange(addrxlat.SYS_MAP_NUM):
+                        xlatmap = xlatsys.get_map(idx)
+                        if xlatmap is not None:
+                            len(xlatmap)
+            except Exception as e:
+                errors.append(repr(e))
+
+        t = threading.Thread(target=xlat_user)
+        t.start()
+        try:
+            self.test_threads()
+        finally:
+            stop.set()
+            t.join()
+        self.assertEqual(errors, [])
+
+if __name__ == '__main__':
+    unittest.main()
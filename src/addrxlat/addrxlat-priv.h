@@ -50,6 +50,80 @@
 /**  In-flight translation. */
 struct inflight;
 
+/** Number of entries in each translation lookaside buffer set. */
+#define TLB_WAYS	4
+
+/**  Translation lookaside buffer entry.
+ * An entry caches the result of a page table walk for one page.
+ */
+struct tlb_entry {
+	/** Source address of the page. */
+	addrxlat_addr_t page;
+
+	/** Page offset mask (page size minus one). */
+	addrxlat_addr_t mask;
+
+	/** Target address of the page. */
+	addrxlat_addr_t target;
+
+	/** Translation method, or @c ADDRXLAT_SYS_METH_NONE if unused. */
+	addrxlat_sys_meth_t meth;
+
+	/** Target address space. */
+	addrxlat_addrspace_t as;
+};
+
+/** Number of cached page table entries for each paging level. */
+#define PWC_SLOTS	32
+
+/**  Paging-structure cache entry.
+ * An entry caches the value of a non-leaf page table entry.
+ */
+struct pwc_entry {
+	/** Address of the page table entry (@c ADDRXLAT_NOADDR if unused). */
+	addrxlat_fulladdr_t addr;
+
+	/** Size of the page table entry in bytes. */
+	unsigned elemsz;
+
+	/** Raw page table entry value. */
+	addrxlat_pte_t pte;
+};
+
+/**  Translation lookaside buffer.
+ *
+ * This is a set-associative cache of page table walks. The set is
+ * chosen by the source address shifted by the size of the smallest
+ * page. Entries in a set are kept in most-recently-used order.
+ *
+ * The buffer also includes a paging-structure cache of upper-level
+ * page table entries, so a page table walk which misses the buffer
+ * usually has to read only the lowest-level entry. This cache is
+ * direct-mapped, with @c PWC_SLOTS entries for each paging level.
+ */
+struct tlb {
+	/** Buffer entries (@c TLB_WAYS entries for each set). */
+	struct tlb_entry *entries;
+
+	/** Total number of entries (zero if disabled). */
+	size_t size;
+
+	/** Paging-structure cache (@c PWC_SLOTS entries for each level). */
+	struct pwc_entry *pwc;
+
+	/** Translation system which owns the cached entries. */
+	const addrxlat_sys_t *sys;
+
+	/** Generation of @c sys when the entries were added. */
+	unsigned long gen;
+
+	/** Number of translations found in the buffer. */
+	unsigned long hits;
+
+	/** Number of page table walks. */
+	unsigned long misses;
+};
+
 /**  Representation of address translation.
  *
  * This structure contains all internal state needed to perform address
@@ -77,6 +151,9 @@ struct _addrxlat_ctx {
 	/** In-flight translations. */
 	struct inflight *inflight;
 
+	/** Translation lookaside buffer. */
+	struct tlb tlb;
+
 	/** Error message buffer.
 	 * This must be the last member. */
 	kdump_errmsg_t err;
@@ -147,6 +224,9 @@ struct _addrxlat_map {
 
 	/** Actual range definitions. */
 	addrxlat_range_t *ranges;
+
+	/** Start addresses of @c ranges, sorted (used for lookups). */
+	addrxlat_addr_t *starts;
 };
 
 /** Clear a translation map.
@@ -161,6 +241,32 @@ map_clear(addrxlat_map_t *map)
 	map->n = 0;
 }
 
+INTERNAL_DECL(addrxlat_sys_meth_t, map_search_endoff,
+	      (const addrxlat_map_t *map, addrxlat_addr_t addr,
+	       addrxlat_addr_t *endoff));
+
+/** Entry in a sorted lookup table index.
+ */
+struct lookup_ent {
+	addrxlat_addr_t orig;	/**< Original address. */
+	size_t idx;		/**< Index in the lookup table. */
+};
+
+/** Sorted index of an @ref ADDRXLAT_LOOKUP table.
+ * The index is valid only as long as @c tbl and @c nelem match
+ * the method parameters.
+ */
+struct lookup_idx {
+	/** Indexed lookup table. */
+	const addrxlat_lookup_elem_t *tbl;
+
+	/** Number of elements in @c tbl. */
+	size_t nelem;
+
+	/** Index entries, sorted by original address. */
+	struct lookup_ent *ent;
+};
+
 /** Translation system.
  */
 struct _addrxlat_sys {
@@ -172,10 +278,33 @@ struct _addrxlat_sys {
 
 	/** Address translation methods. */
 	addrxlat_meth_t meth[ADDRXLAT_SYS_METH_NUM];
+
+	/** Sorted indices of lookup tables in @c meth. */
+	struct lookup_idx lookup[ADDRXLAT_SYS_METH_NUM];
+
+	/** Generation number.
+	 * This number changes whenever the maps or methods are modified.
+	 * It is unique among all translation systems, so a translation
+	 * lookaside buffer can tell if its entries are still valid.
+	 * Zero means that translations must not be cached.
+	 */
+	unsigned long gen;
 };
 
+/** Mark a translation system as modified.
+ * @param sys  Translation system.
+ */
+INTERNAL_DECL(void, sys_changed, (addrxlat_sys_t *sys));
+
+INTERNAL_DECL(const struct lookup_idx *, sys_lookup_idx,
+	      (const addrxlat_sys_t *sys, const addrxlat_meth_t *meth));
+
 /* vtop */
 
+INTERNAL_DECL(int, pwc_lookup, (addrxlat_step_t *step));
+
+INTERNAL_DECL(void, pwc_insert, (const addrxlat_step_t *step));
+
 /** Read raw 32-bit PTE value.
  * @param step  Current step state.
  * @returns     Error status.
@@ -188,9 +317,13 @@ read_pte32(addrxlat_step_t *step)
 {
 	uint32_t pte32;
 	addrxlat_status status;
+	if (pwc_lookup(step))
+		return ADDRXLAT_OK;
 	status = read32(step, &step->base, &pte32, "PTE");
-	if (status == ADDRXLAT_OK)
+	if (status == ADDRXLAT_OK) {
 		step->raw.pte = pte32;
+		pwc_insert(step);
+	}
 	return status;
 }
 
@@ -206,14 +339,25 @@ read_pte64(addrxlat_step_t *step)
 {
 	uint64_t pte64;
 	addrxlat_status status;
+	if (pwc_lookup(step))
+		return ADDRXLAT_OK;
 	status = read64(step, &step->base, &pte64, "PTE");
-	if (status == ADDRXLAT_OK)
+	if (status == ADDRXLAT_OK) {
 		step->raw.pte = pte64;
+		pwc_insert(step);
+	}
 	return status;
 }
 
 INTERNAL_DECL(addrxlat_status, pgt_huge_page, (addrxlat_step_t *state));
 
+INTERNAL_DECL(addrxlat_status, walk_pgt,
+	      (addrxlat_step_t *step, addrxlat_addr_t *mask));
+
+INTERNAL_DECL(addrxlat_status, tlb_walk,
+	      (addrxlat_step_t *step, addrxlat_sys_meth_t methidx,
+	       addrxlat_addr_t *mask));
+
 INTERNAL_DECL(addrxlat_next_step_fn, pgt_ia32, );
 
 INTERNAL_DECL(addrxlat_next_step_fn, pgt_ia32_pae, );
@@ -345,6 +489,7 @@ INTERNAL_DECL(addrxlat_status, sys_sym_pgtroot,
 
 #define set_error internal_ctx_err
 DECLARE_ALIAS(ctx_err);
+DECLARE_ALIAS(ctx_flush_tlb);
 
 DECLARE_ALIAS(map_new);
 DECLARE_ALIAS(map_incref);
@@ -356,6 +501,8 @@ DECLARE_ALIAS(launch);
 DECLARE_ALIAS(step);
 DECLARE_ALIAS(walk);
 DECLARE_ALIAS(op);
+DECLARE_ALIAS(op_range);
+DECLARE_ALIAS(op_batch);
 DECLARE_ALIAS(fulladdr_conv);
 
 /** Clear the error message.
@@ -37,6 +37,75 @@
 /** Maximum length of the static error message. */
 #define ERRBUF	64
 
+/** Number of entries in the paging-structure cache. */
+#define PWC_SIZE	((ADDRXLAT_FIELDS_MAX - 1) * PWC_SLOTS)
+
+/** Free the translation lookaside buffer storage.
+ * @param tlb  Translation lookaside buffer.
+ */
+static void
+tlb_free(struct tlb *tlb)
+{
+	if (tlb->entries) {
+		free(tlb->entries);
+		tlb->entries = NULL;
+	}
+	if (tlb->pwc) {
+		free(tlb->pwc);
+		tlb->pwc = NULL;
+	}
+	tlb->sys = NULL;
+}
+
+/** Discard all entries in a translation lookaside buffer.
+ * @param tlb  Translation lookaside buffer.
+ */
+static void
+tlb_flush(struct tlb *tlb)
+{
+	size_t i;
+
+	if (tlb->entries)
+		for (i = 0; i < tlb->size; ++i)
+			tlb->entries[i].meth = ADDRXLAT_SYS_METH_NONE;
+	if (tlb->pwc)
+		for (i = 0; i < PWC_SIZE; ++i)
+			tlb->pwc[i].addr.as = ADDRXLAT_NOADDR;
+}
+
+/** Prepare a translation lookaside buffer for use.
+ * @param tlb  Translation lookaside buffer.
+ * @param sys  Translation system.
+ * @returns    Non-zero if the buffer can be used.
+ *
+ * The buffer is allocated if necessary. If it contains entries for
+ * another translation system, or for an older generation of @p sys,
+ * it is flushed.
+ */
+static int
+tlb_prepare(struct tlb *tlb, const addrxlat_sys_t *sys)
+{
+	if (!tlb->size || !sys || !sys->gen)
+		return 0;
+
+	if (!tlb->entries) {
+		tlb->entries = malloc(tlb->size * sizeof(*tlb->entries));
+		tlb->pwc = malloc(PWC_SIZE * sizeof(*tlb->pwc));
+		if (!tlb->entries || !tlb->pwc) {
+			tlb_free(tlb);
+			return 0;
+		}
+		tlb->sys = NULL;
+	}
+
+	if (tlb->sys != sys || tlb->gen != sys->gen) {
+		tlb_flush(tlb);
+		tlb->sys = sys;
+		tlb->gen = sys->gen;
+	}
+	return 1;
+}
+
 addrxlat_ctx_t *
 addrxlat_ctx_new(void)
 {
@@ -59,6 +128,7 @@ addrxlat_ctx_decref(addrxlat_ctx_t *ctx)
 {
 	unsigned long refcnt = --ctx->refcnt;
 	if (!refcnt) {
+		tlb_free(&ctx->tlb);
 		err_cleanup(&ctx->err);
 		free(ctx);
 	}
@@ -90,6 +160,7 @@ addrxlat_ctx_set_cb(addrxlat_ctx_t *ctx, const addrxlat_cb_t *cb)
 	ctx->cb = ctx->orig_cb = *cb;
 	if (hook)
 		hook(data, &ctx->cb);
+	internal_ctx_flush_tlb(ctx);
 }
 
 const addrxlat_cb_t *
@@ -101,9 +172,144 @@ addrxlat_ctx_get_cb(const addrxlat_ctx_t *ctx)
 addrxlat_cb_t *
 addrxlat_ctx_get_ecb(addrxlat_ctx_t *ctx)
 {
+	/* The caller may change the callbacks. */
+	internal_ctx_flush_tlb(ctx);
 	return &ctx->cb;
 }
 
+DEFINE_ALIAS(ctx_flush_tlb);
+
+void
+addrxlat_ctx_flush_tlb(addrxlat_ctx_t *ctx)
+{
+	tlb_flush(&ctx->tlb);
+	ctx->tlb.sys = NULL;
+}
+
+addrxlat_status
+addrxlat_ctx_set_tlb_size(addrxlat_ctx_t *ctx, size_t size)
+{
+	struct tlb *tlb = &ctx->tlb;
+	size_t newsize;
+
+	clear_error(ctx);
+
+	newsize = size ? TLB_WAYS : 0;
+	while (newsize && newsize < size) {
+		newsize <<= 1;
+		if (!newsize)
+			return set_error(ctx, ADDRXLAT_ERR_INVALID,
+					 "TLB size too big");
+	}
+
+	/* The buffer is allocated on first use. */
+	tlb_free(tlb);
+	tlb->size = newsize;
+	return ADDRXLAT_OK;
+}
+
+size_t
+addrxlat_ctx_get_tlb_size(const addrxlat_ctx_t *ctx)
+{
+	return ctx->tlb.size;
+}
+
+void
+addrxlat_ctx_get_tlb_stats(const addrxlat_ctx_t *ctx,
+			   unsigned long *hits, unsigned long *misses)
+{
+	*hits = ctx->tlb.hits;
+	*misses = ctx->tlb.misses;
+}
+
+/** Get the translation lookaside buffer set for an address.
+ * @param tlb   Translation lookaside buffer.
+ * @param step  Step state.
+ * @param addr  Source address.
+ * @returns     Pointer to the first entry in the set, or @c NULL.
+ *
+ * If the buffer cannot be used (see @ref tlb_prepare), this function
+ * returns @c NULL.
+ */
+static struct tlb_entry *
+tlb_set(struct tlb *tlb, const addrxlat_step_t *step, addrxlat_addr_t addr)
+{
+	const addrxlat_paging_form_t *pf = &step->meth->param.pgt.pf;
+	size_t nsets;
+
+	if (!tlb_prepare(tlb, step->sys))
+		return NULL;
+
+	nsets = tlb->size / TLB_WAYS;
+	if (pf->nfields && pf->fieldsz[0] < 8 * sizeof(addrxlat_addr_t))
+		addr >>= pf->fieldsz[0];
+	return &tlb->entries[(addr & (nsets - 1)) * TLB_WAYS];
+}
+
+/** Translate an address using page tables and a TLB.
+ * @param      step     Step state.
+ * @param      methidx  Translation method index in @c step->sys.
+ * @param[out] mask     Page offset mask of the translated page.
+ * @returns             Error status.
+ *
+ * The step state must be initialized like for @ref addrxlat_walk,
+ * and @c step->meth must be a page table method. If the translation
+ * is not found in the translation lookaside buffer, the page tables
+ * are walked and the result is added to the buffer.
+ *
+ * On a hit, only @c step->base is set.
+ */
+addrxlat_status
+tlb_walk(addrxlat_step_t *step, addrxlat_sys_meth_t methidx,
+	 addrxlat_addr_t *mask)
+{
+	struct tlb *tlb = &step->ctx->tlb;
+	struct tlb_entry *entries, *set, *e, tmp;
+	addrxlat_addr_t addr;
+	addrxlat_status status;
+	unsigned i;
+
+	addr = step->base.addr;
+	set = tlb_set(tlb, step, addr);
+	if (!set)
+		return walk_pgt(step, mask);
+	entries = tlb->entries;
+
+	for (i = 0; i < TLB_WAYS; ++i) {
+		e = &set[i];
+		if (e->meth == methidx && (addr & ~e->mask) == e->page) {
+			step->base.as = e->as;
+			step->base.addr = e->target + (addr & e->mask);
+			*mask = e->mask;
+			++tlb->hits;
+			if (i) {
+				tmp = *e;
+				memmove(set + 1, set, i * sizeof(*set));
+				set[0] = tmp;
+			}
+			return ADDRXLAT_OK;
+		}
+	}
+
+	++tlb->misses;
+	status = walk_pgt(step, mask);
+	if (status != ADDRXLAT_OK)
+		return status;
+
+	/* Nested translations may have flushed the buffer. */
+	if (tlb->entries != entries ||
+	    tlb->sys != step->sys || tlb->gen != step->sys->gen)
+		return ADDRXLAT_OK;
+
+	memmove(set + 1, set, (TLB_WAYS - 1) * sizeof(*set));
+	set[0].page = addr & ~*mask;
+	set[0].mask = *mask;
+	set[0].target = step->base.addr - (addr & *mask);
+	set[0].meth = methidx;
+	set[0].as = step->base.as;
+	return ADDRXLAT_OK;
+}
+
 /** Get the (string) name of an address space.
  * @param as  Address space.
  * @returns   The (human-readable) name of the address space.
@@ -413,3 +619,63 @@ addrxlat_strerror(addrxlat_status status)
 	default:			return "Unknown error";
 	}
 }
+
+/** Get the paging-structure cache slot for the current step.
+ * @param step  Step state.
+ * @returns     Cache entry, or @c NULL if the cache cannot be used.
+ *
+ * Only upper-level page table entries (i.e. when @c step->remain is
+ * greater than one) are cached.
+ */
+static struct pwc_entry *
+pwc_slot(const addrxlat_step_t *step)
+{
+	struct tlb *tlb = &step->ctx->tlb;
+	size_t slot;
+
+	if (step->remain < 2 || step->remain > ADDRXLAT_FIELDS_MAX ||
+	    !tlb_prepare(tlb, step->sys))
+		return NULL;
+
+	slot = step->base.addr;
+	if (step->elemsz)
+		slot /= step->elemsz;
+	slot %= PWC_SLOTS;
+	return &tlb->pwc[(step->remain - 2) * PWC_SLOTS + slot];
+}
+
+/** Look up a page table entry in the paging-structure cache.
+ * @param step  Step state.
+ * @returns     Non-zero if found.
+ *
+ * If the page table entry at @c step->base is found in the cache with
+ * the same size (@c step->elemsz), it is stored in @c step->raw.pte.
+ */
+int
+pwc_lookup(addrxlat_step_t *step)
+{
+	struct pwc_entry *e = pwc_slot(step);
+
+	if (!e || e->addr.as != step->base.as ||
+	    e->addr.addr != step->base.addr ||
+	    e->elemsz != step->elemsz)
+		return 0;
+
+	step->raw.pte = e->pte;
+	return 1;
+}
+
+/** Add a page table entry to the paging-structure cache.
+ * @param step  Step state with the entry value in @c step->raw.pte.
+ */
+void
+pwc_insert(const addrxlat_step_t *step)
+{
+	struct pwc_entry *e = pwc_slot(step);
+
+	if (e) {
+		e->addr = step->base;
+		e->elemsz = step->elemsz;
+		e->pte = step->raw.pte;
+	}
+}
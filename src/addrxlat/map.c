@@ -64,6 +64,8 @@ addrxlat_map_decref(addrxlat_map_t *map)
 		map_clear(map);
 		if (map->ranges)
 			free(map->ranges);
+		if (map->starts)
+			free(map->starts);
 		free(map);
 	}
 	return refcnt;
@@ -81,6 +83,28 @@ addrxlat_map_ranges(const addrxlat_map_t *map)
 	return map->ranges;
 }
 
+/** Update range start addresses.
+ * @param map  Address translation map.
+ * @param idx  Index of the first modified range.
+ *
+ * Recalculate @c map->starts for all ranges starting at index @p idx.
+ */
+static void
+update_starts(addrxlat_map_t *map, size_t idx)
+{
+	addrxlat_addr_t addr;
+
+	if (!idx) {
+		map->starts[0] = 0;
+		idx = 1;
+	}
+	addr = map->starts[idx - 1];
+	while (idx < map->n) {
+		addr += map->ranges[idx - 1].endoff + 1;
+		map->starts[idx++] = addr;
+	}
+}
+
 DEFINE_ALIAS(map_set);
 
 addrxlat_status
@@ -91,7 +115,7 @@ addrxlat_map_set(addrxlat_map_t *map, addrxlat_addr_t addr,
 	addrxlat_addr_t raddr, rend;
 	addrxlat_addr_t end;
 	addrxlat_addr_t extend;
-	size_t left;
+	size_t left, idx;
 	int delta;
 
 	end = addr + range->endoff;
@@ -163,10 +187,22 @@ addrxlat_map_set(addrxlat_map_t *map, addrxlat_addr_t addr,
 	/* (re-)allocate if growing */
 	if (delta > 0) {
 		size_t newn = delta + (map ? map->n : 0);
-		addrxlat_range_t *newranges =
-			realloc(map->ranges, newn * sizeof(newranges[0]));
+		addrxlat_addr_t *newstarts;
+		addrxlat_range_t *newranges;
+
+		newranges = realloc(map->ranges, newn * sizeof(newranges[0]));
 		if (!newranges)
 			return ADDRXLAT_ERR_NOMEM;
+		if (first) {
+			first = &newranges[first - map->ranges];
+			last = &newranges[last - map->ranges];
+		}
+		map->ranges = newranges;
+
+		newstarts = realloc(map->starts, newn * sizeof(newstarts[0]));
+		if (!newstarts)
+			return ADDRXLAT_ERR_NOMEM;
+		map->starts = newstarts;
 
 		if (!first) {
 			map->n = 1;
@@ -175,11 +211,7 @@ addrxlat_map_set(addrxlat_map_t *map, addrxlat_addr_t addr,
 			first->meth = ADDRXLAT_SYS_METH_NONE;
 			++left;
 			--delta;
-		} else {
-			first = &newranges[first - map->ranges];
-			last = &newranges[last - map->ranges];
 		}
-		map->ranges = newranges;
 	}
 
 	if (delta) {
@@ -189,6 +221,7 @@ addrxlat_map_set(addrxlat_map_t *map, addrxlat_addr_t addr,
 	}
 
 	/* resize adjacent regions if necessary */
+	idx = first - map->ranges;
 	if (raddr != addr) {
 		first->endoff = addr - raddr - 1;
 		++first;
@@ -200,24 +233,87 @@ addrxlat_map_set(addrxlat_map_t *map, addrxlat_addr_t addr,
 
 	first->endoff = range->endoff + extend;
 	first->meth = range->meth;
+
+	update_starts(map, idx);
 	return ADDRXLAT_OK;
 }
 
+/** Find the range which contains an address.
+ * @param map   Address translation map.
+ * @param addr  Address to be searched.
+ * @returns     Index of the range, or @c map->n if not found.
+ */
+static size_t
+find_range(const addrxlat_map_t *map, addrxlat_addr_t addr)
+{
+	size_t lo, hi, mid;
+
+	if (!map->n)
+		return 0;
+
+	/* find the last range which starts at or below addr */
+	lo = 0;
+	hi = map->n;
+	while (hi - lo > 1) {
+		mid = lo + (hi - lo) / 2;
+		if (map->starts[mid] <= addr)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	return addr - map->starts[lo] <= map->ranges[lo].endoff
+		? lo
+		: map->n;
+}
+
 DEFINE_ALIAS(map_search);
 
 addrxlat_sys_meth_t
 addrxlat_map_search(const addrxlat_map_t *map, addrxlat_addr_t addr)
 {
-	const addrxlat_range_t *r = map->ranges;
-	addrxlat_addr_t raddr = 0;
-	size_t left = map->n;
-
-	while (left-- > 0) {
-		if (addr <= raddr + r->endoff)
-			return r->meth;
-		raddr += r->endoff + 1;
-		++r;
+	size_t idx = find_range(map, addr);
+	return idx < map->n
+		? map->ranges[idx].meth
+		: ADDRXLAT_SYS_METH_NONE;
+}
+
+/** Find the translation method and its extent for an address.
+ * @param      map     Address translation map.
+ * @param      addr    Address to be searched.
+ * @param[out] endoff  Offset of the end of the range from @p addr.
+ * @returns            Translation method, or @ref ADDRXLAT_SYS_METH_NONE.
+ *
+ * Like @ref addrxlat_map_search, but also get the last address
+ * (relative to @p addr) which is translated by the same method.
+ * If @p addr is not mapped, @p endoff is set to the end of the gap
+ * before the next range.
+ */
+addrxlat_sys_meth_t
+map_search_endoff(const addrxlat_map_t *map, addrxlat_addr_t addr,
+		  addrxlat_addr_t *endoff)
+{
+	size_t idx = find_range(map, addr);
+	size_t lo, hi, mid;
+
+	if (idx < map->n) {
+		*endoff = map->starts[idx] + map->ranges[idx].endoff - addr;
+		return map->ranges[idx].meth;
+	}
+
+	/* find the first range which starts above addr */
+	lo = 0;
+	hi = map->n;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (map->starts[mid] <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
 	}
+	*endoff = lo < map->n
+		? map->starts[lo] - addr - 1
+		: ADDRXLAT_ADDR_MAX - addr;
 	return ADDRXLAT_SYS_METH_NONE;
 }
 
@@ -236,10 +332,12 @@ addrxlat_map_copy(const addrxlat_map_t *map)
 		return ret;
 
 	ret->ranges = malloc(map->n * sizeof(ret->ranges[0]));
-	if (!ret->ranges) {
+	ret->starts = malloc(map->n * sizeof(ret->starts[0]));
+	if (!ret->ranges || !ret->starts) {
 		internal_map_decref(ret);
 		return NULL;
 	}
+	memcpy(ret->starts, map->starts, map->n * sizeof(ret->starts[0]));
 
 	q = map->ranges;
 	r = ret->ranges;
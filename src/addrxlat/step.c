@@ -332,6 +332,42 @@ next_step_pgt(addrxlat_step_t *step)
 	};
 }
 
+/** Find a lookup table element using a sorted index.
+ * @param lidx    Lookup table index.
+ * @param endoff  Max address offset inside each object.
+ * @param addr    Address to be translated.
+ * @returns       Matching element, or @c NULL if not found.
+ *
+ * If more than one element matches, the one which comes first
+ * in the lookup table is returned, just like a linear search would.
+ */
+static const addrxlat_lookup_elem_t *
+search_lookup_idx(const struct lookup_idx *lidx, addrxlat_addr_t endoff,
+		  addrxlat_addr_t addr)
+{
+	const struct lookup_ent *ent = lidx->ent;
+	size_t lo, hi, mid, best;
+
+	/* Find the first entry which starts above @c addr. */
+	lo = 0;
+	hi = lidx->nelem;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (ent[mid].orig <= addr)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* All matching entries immediately precede it. */
+	best = lidx->nelem;
+	while (lo-- > 0 && addr - ent[lo].orig <= endoff)
+		if (ent[lo].idx < best)
+			best = ent[lo].idx;
+
+	return best < lidx->nelem ? &lidx->tbl[best] : NULL;
+}
+
 /** Initialize step state for table lookup.
  * @param step  Step state.
  * @param addr  Address to be translated.
@@ -341,22 +377,33 @@ static addrxlat_status
 first_step_lookup(addrxlat_step_t *step, addrxlat_addr_t addr)
 {
 	const addrxlat_param_lookup_t *lookup = &step->meth->param.lookup;
+	const addrxlat_lookup_elem_t *elem;
+	const struct lookup_idx *lidx;
 	size_t i;
 
-	for (i = 0; i < lookup->nelem; ++i) {
-		const addrxlat_lookup_elem_t *elem = &lookup->tbl[i];
-		if (elem->orig <= addr &&
-		    addr <= elem->orig + lookup->endoff) {
-			step->base.as = step->meth->target_as;
-			step->base.addr = elem->dest;
-			step->remain = 1;
-			step->elemsz = 1;
-			step->idx[0] = addr - elem->orig;
-			return ADDRXLAT_OK;
+	lidx = sys_lookup_idx(step->sys, step->meth);
+	if (lidx) {
+		elem = search_lookup_idx(lidx, lookup->endoff, addr);
+		if (elem)
+			goto found;
+	} else {
+		for (i = 0; i < lookup->nelem; ++i) {
+			elem = &lookup->tbl[i];
+			if (elem->orig <= addr &&
+			    addr <= elem->orig + lookup->endoff)
+				goto found;
 		}
 	}
 
 	return set_error(step->ctx, ADDRXLAT_ERR_NOTPRESENT, "Not mapped");
+
+ found:
+	step->base.as = step->meth->target_as;
+	step->base.addr = elem->dest;
+	step->remain = 1;
+	step->elemsz = 1;
+	step->idx[0] = addr - elem->orig;
+	return ADDRXLAT_OK;
 }
 
 /** Initialize step state for memory array lookup.
@@ -511,20 +558,26 @@ addrxlat_step(addrxlat_step_t *step)
 	return next_step(step);
 }
 
-DEFINE_ALIAS(walk);
-
-addrxlat_status
-addrxlat_walk(addrxlat_step_t *step)
+/** Perform a complete address translation.
+ * @param      step  Step state.
+ * @param[out] last  Value of @c step->remain in the last step.
+ * @returns          Error status.
+ *
+ * This is the common implementation of @ref addrxlat_walk and
+ * @ref walk_pgt.
+ */
+static addrxlat_status
+do_walk(addrxlat_step_t *step, unsigned short *last)
 {
 	addrxlat_status status;
 
-	clear_error(step->ctx);
-
 	status = first_step(step, step->base.addr);
 	if (status != ADDRXLAT_OK)
 		return status;
 
+	*last = step->remain;
 	while (--step->remain) {
+		*last = step->remain;
 		step->base.addr += step->idx[step->remain] * step->elemsz;
 		status = next_step(step);
 		if (status != ADDRXLAT_OK)
@@ -537,6 +590,47 @@ addrxlat_walk(addrxlat_step_t *step)
 	return ADDRXLAT_OK;
 }
 
+DEFINE_ALIAS(walk);
+
+addrxlat_status
+addrxlat_walk(addrxlat_step_t *step)
+{
+	unsigned short last;
+
+	clear_error(step->ctx);
+	return do_walk(step, &last);
+}
+
+/** Translate an address using page tables and get the page size.
+ * @param      step  Step state.
+ * @param[out] mask  Page offset mask of the translated page.
+ * @returns          Error status.
+ *
+ * This function works like @ref addrxlat_walk, but the translation
+ * method must be @ref ADDRXLAT_PGT. The page offset mask is based on
+ * the last level of paging which was used, so it is correct also for
+ * huge pages.
+ */
+addrxlat_status
+walk_pgt(addrxlat_step_t *step, addrxlat_addr_t *mask)
+{
+	const addrxlat_paging_form_t *pf = &step->meth->param.pgt.pf;
+	unsigned short i, last, bits;
+	addrxlat_status status;
+
+	status = do_walk(step, &last);
+	if (status != ADDRXLAT_OK)
+		return status;
+
+	bits = 0;
+	for (i = 0; i < last && i < pf->nfields; ++i)
+		bits += pf->fieldsz[i];
+	*mask = bits < 8 * sizeof(addrxlat_addr_t)
+		? ADDR_MASK(bits)
+		: ADDRXLAT_ADDR_MAX;
+	return ADDRXLAT_OK;
+}
+
 /** Get the page size for a given paging form.
  * @param pf  Paging form.
  * @returns   Page size.
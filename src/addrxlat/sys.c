@@ -29,10 +29,93 @@
 */
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "addrxlat-priv.h"
 
+/** Last assigned translation system generation number. */
+static unsigned long last_sys_gen;
+
+/** Mark a translation system as modified.
+ * @param sys  Translation system.
+ *
+ * Assign a new generation number to @p sys. This invalidates all
+ * translation lookaside buffer entries which refer to it.
+ */
+void
+sys_changed(addrxlat_sys_t *sys)
+{
+	sys->gen = __atomic_add_fetch(&last_sys_gen, 1, __ATOMIC_RELAXED);
+}
+
+static int
+lookup_ent_cmp(const void *a, const void *b)
+{
+	const struct lookup_ent *ea = a, *eb = b;
+
+	if (ea->orig != eb->orig)
+		return ea->orig < eb->orig ? -1 : 1;
+	return ea->idx < eb->idx ? -1 : ea->idx > eb->idx;
+}
+
+/** Rebuild the lookup table index of a translation method.
+ * @param sys  Translation system.
+ * @param idx  Translation method index.
+ *
+ * If the method is not an @ref ADDRXLAT_LOOKUP method, the index
+ * is only freed. If the index cannot be allocated, lookups fall
+ * back to a linear search.
+ */
+static void
+index_lookup(addrxlat_sys_t *sys, addrxlat_sys_meth_t idx)
+{
+	const addrxlat_param_lookup_t *lookup = &sys->meth[idx].param.lookup;
+	struct lookup_idx *lidx = &sys->lookup[idx];
+	size_t i;
+
+	free(lidx->ent);
+	lidx->ent = NULL;
+	if (sys->meth[idx].kind != ADDRXLAT_LOOKUP || !lookup->nelem)
+		return;
+
+	lidx->ent = malloc(lookup->nelem * sizeof(*lidx->ent));
+	if (!lidx->ent)
+		return;
+	lidx->tbl = lookup->tbl;
+	lidx->nelem = lookup->nelem;
+	for (i = 0; i < lookup->nelem; ++i) {
+		lidx->ent[i].orig = lookup->tbl[i].orig;
+		lidx->ent[i].idx = i;
+	}
+	qsort(lidx->ent, lidx->nelem, sizeof(*lidx->ent), lookup_ent_cmp);
+}
+
+/** Get the lookup table index of a translation method.
+ * @param sys   Translation system (may be @c NULL).
+ * @param meth  Translation method.
+ * @returns     Up-to-date lookup table index, or @c NULL.
+ *
+ * An index is available only for @ref ADDRXLAT_LOOKUP methods
+ * stored in @p sys.
+ */
+const struct lookup_idx *
+sys_lookup_idx(const addrxlat_sys_t *sys, const addrxlat_meth_t *meth)
+{
+	const struct lookup_idx *lidx;
+
+	if (!sys || meth < sys->meth ||
+	    meth >= sys->meth + ADDRXLAT_SYS_METH_NUM)
+		return NULL;
+
+	lidx = &sys->lookup[meth - sys->meth];
+	if (!lidx->ent ||
+	    lidx->tbl != meth->param.lookup.tbl ||
+	    lidx->nelem != meth->param.lookup.nelem)
+		return NULL;
+	return lidx;
+}
+
 addrxlat_sys_t *
 addrxlat_sys_new(void)
 {
@@ -41,6 +124,7 @@ addrxlat_sys_new(void)
 	ret = calloc(1, sizeof(addrxlat_sys_t));
 	if (ret) {
 		ret->refcnt = 1;
+		sys_changed(ret);
 	}
 	return ret;
 }
@@ -71,7 +155,11 @@ addrxlat_sys_decref(addrxlat_sys_t *sys)
 {
 	unsigned long refcnt = --sys->refcnt;
 	if (!refcnt) {
+		unsigned i;
+
 		sys_cleanup(sys);
+		for (i = 0; i < ADDRXLAT_SYS_METH_NUM; ++i)
+			free(sys->lookup[i].ent);
 		free(sys);
 	}
 	return refcnt;
@@ -84,6 +172,7 @@ addrxlat_sys_os_init(addrxlat_sys_t *sys, addrxlat_ctx_t *ctx,
 	struct os_init_data ctl;
 	sys_arch_fn *arch_fn;
 	addrxlat_status status;
+	unsigned i;
 
 	clear_error(ctx);
 
@@ -104,6 +193,9 @@ addrxlat_sys_os_init(addrxlat_sys_t *sys, addrxlat_ctx_t *ctx,
 
 	sys_cleanup(sys);
 
+	/* Do not cache translations until the system is complete. */
+	sys->gen = 0;
+
 	ctl.sys = sys;
 	ctl.ctx = ctx;
 	ctl.osdesc = osdesc;
@@ -112,7 +204,11 @@ addrxlat_sys_os_init(addrxlat_sys_t *sys, addrxlat_ctx_t *ctx,
 	if (status != ADDRXLAT_OK)
 		return status;
 
-	return arch_fn(&ctl);
+	status = arch_fn(&ctl);
+	for (i = 0; i < ADDRXLAT_SYS_METH_NUM; ++i)
+		index_lookup(sys, i);
+	sys_changed(sys);
+	return status;
 }
 
 void
@@ -124,6 +220,7 @@ addrxlat_sys_set_map(addrxlat_sys_t *sys, addrxlat_sys_map_t idx,
 	if (sys->map[idx])
 		internal_map_decref(sys->map[idx]);
 	sys->map[idx] = map;
+	sys_changed(sys);
 }
 
 addrxlat_map_t *
@@ -137,6 +234,8 @@ addrxlat_sys_set_meth(addrxlat_sys_t *sys,
 		      addrxlat_sys_meth_t idx, const addrxlat_meth_t *meth)
 {
 	sys->meth[idx] = *meth;
+	index_lookup(sys, idx);
+	sys_changed(sys);
 }
 
 const addrxlat_meth_t *
@@ -402,13 +501,91 @@ struct inflight {
 	struct inflight *next;
 };
 
+/** Get the extent of a completed translation.
+ * @param step  Step state after a successful walk.
+ * @returns     Offset of the last contiguously translated address.
+ *
+ * The result is relative to the translated address. Page tables are
+ * not handled here; their extent is given by the page size.
+ * The extent of custom translations is not known, so zero is
+ * returned for them.
+ */
+static addrxlat_addr_t
+walk_endoff(const addrxlat_step_t *step)
+{
+	const addrxlat_meth_t *meth = step->meth;
+
+	switch (meth->kind) {
+	case ADDRXLAT_LOOKUP:
+		return meth->param.lookup.endoff - step->idx[0];
+
+	case ADDRXLAT_MEMARR:
+		return (meth->param.memarr.shift < 8 * sizeof(addrxlat_addr_t)
+			? ADDR_MASK(meth->param.memarr.shift)
+			: ADDRXLAT_ADDR_MAX) - step->idx[0];
+
+	default:
+		return 0;
+	}
+}
+
+/** Get the extent of a failed translation.
+ * @param meth  Translation method.
+ * @param addr  Address which could not be translated.
+ * @returns     Offset of the last address which may fail the same way.
+ *
+ * A page table walk fails in the same way for the whole page (of the
+ * smallest size), and a memory array lookup fails for all addresses
+ * which share the array element. Nothing is known about other methods,
+ * so zero is returned for them.
+ */
+static addrxlat_addr_t
+fail_endoff(const addrxlat_meth_t *meth, addrxlat_addr_t addr)
+{
+	addrxlat_addr_t mask;
+	unsigned shift;
+
+	switch (meth->kind) {
+	case ADDRXLAT_PGT:
+		if (!meth->param.pgt.pf.nfields)
+			return 0;
+		shift = meth->param.pgt.pf.fieldsz[0];
+		break;
+
+	case ADDRXLAT_MEMARR:
+		shift = meth->param.memarr.shift;
+		break;
+
+	default:
+		return 0;
+	}
+
+	mask = shift < 8 * sizeof(addrxlat_addr_t)
+		? ADDR_MASK(shift)
+		: ADDRXLAT_ADDR_MAX;
+	return mask - (addr & mask);
+}
+
+/** Translate an address and get the extent of the translation.
+ * @param      ctl     Control structure.
+ * @param      paddr   Address to be translated.
+ * @param      chain   Translation chain.
+ * @param[out] endoff  Offset of the last contiguously translated address.
+ * @returns            Error status.
+ *
+ * All addresses from @p paddr up to @p paddr + @p endoff are translated
+ * by the same methods, i.e. they map to a contiguous target range.
+ * Maps and methods which are skipped before a successful translation
+ * also limit the extent, because they may apply to a later address.
+ */
 static addrxlat_status
 do_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr,
-      const struct xlat_chain *chain)
+      const struct xlat_chain *chain, addrxlat_addr_t *endoff)
 {
 	unsigned i, j;
 	addrxlat_fulladdr_t lastbase;
 	addrxlat_step_t step;
+	addrxlat_addr_t rangeoff, mask;
 	addrxlat_status status;
 
 	step.ctx = ctl->ctx;
@@ -431,7 +608,10 @@ do_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr,
 				continue;
 
 			clear_error(ctl->ctx);
-			methidx = internal_map_search(map, paddr->addr);
+			methidx = map_search_endoff(map, paddr->addr,
+						    &rangeoff);
+			if (*endoff > rangeoff)
+				*endoff = rangeoff;
 			if (methidx == ADDRXLAT_SYS_METH_NONE)
 				continue;
 
@@ -448,8 +628,16 @@ do_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr,
 
 			step.meth = meth;
 			step.base.addr = paddr->addr;
-			status = internal_walk(&step);
+			if (meth->kind == ADDRXLAT_PGT) {
+				status = tlb_walk(&step, methidx, &mask);
+				rangeoff = mask - (paddr->addr & mask);
+			} else {
+				status = internal_walk(&step);
+				rangeoff = walk_endoff(&step);
+			}
 			if (status == ADDRXLAT_OK) {
+				if (*endoff > rangeoff)
+					*endoff = rangeoff;
 				if (ctl->caps & ADDRXLAT_CAPS(step.base.as))
 					return ctl->op(ctl->data, &step.base);
 				lastbase = step.base;
@@ -458,23 +646,34 @@ do_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr,
 			} else if (status != ADDRXLAT_ERR_NOMETH &&
 				   status != ADDRXLAT_ERR_NODATA)
 				return status;
+
+			rangeoff = fail_endoff(meth, paddr->addr);
+			if (*endoff > rangeoff)
+				*endoff = rangeoff;
 		}
 	}
 
 	return set_error(ctl->ctx, ADDRXLAT_ERR_NOMETH, "No way to translate");
 }
 
-DEFINE_ALIAS(op);
-
-addrxlat_status
-addrxlat_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr)
+/** Perform an operation on a translated address.
+ * @param      ctl     Control structure.
+ * @param      paddr   Address (in any address space).
+ * @param[out] endoff  Offset of the last contiguously translated address.
+ * @returns            Error status.
+ *
+ * This is the common implementation of @ref addrxlat_op and
+ * @ref addrxlat_op_range. The error string is not cleared.
+ */
+static addrxlat_status
+op_endoff(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr,
+	  addrxlat_addr_t *endoff)
 {
 	struct inflight inflight, *pif;
 	const struct xlat_chain *chain;
 	addrxlat_status status;
 
-	clear_error(ctl->ctx);
-
+	*endoff = ADDRXLAT_ADDR_MAX;
 	if (ctl->caps & ADDRXLAT_CAPS(paddr->as))
 		return ctl->op(ctl->data, paddr);
 
@@ -522,12 +721,23 @@ addrxlat_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr)
 	inflight.next = ctl->ctx->inflight;
 	ctl->ctx->inflight = &inflight;
 
-	status = do_op(ctl, paddr, chain);
+	status = do_op(ctl, paddr, chain, endoff);
 
 	ctl->ctx->inflight = inflight.next;
 	return status;
 }
 
+DEFINE_ALIAS(op);
+
+addrxlat_status
+addrxlat_op(const addrxlat_op_ctl_t *ctl, const addrxlat_fulladdr_t *paddr)
+{
+	addrxlat_addr_t endoff;
+
+	clear_error(ctl->ctx);
+	return op_endoff(ctl, paddr, &endoff);
+}
+
 static addrxlat_status
 storeaddr(void *data, const addrxlat_fulladdr_t *paddr)
 {
@@ -551,3 +761,189 @@ addrxlat_fulladdr_conv(addrxlat_fulladdr_t *faddr, addrxlat_addrspace_t as,
 	opctl.caps = ADDRXLAT_CAPS(as);
 	return internal_op(&opctl, faddr);
 }
+
+/** Pending run of contiguously translated addresses.
+ * @sa addrxlat_op_range
+ */
+struct xlat_run {
+	addrxlat_fulladdr_t src;	/**< First source address. */
+	addrxlat_fulladdr_t dst;	/**< First translated address. */
+	addrxlat_addr_t len;		/**< Length of the run in bytes. */
+};
+
+/** Pass a pending run to the range operation callback.
+ * @param ctl  Control structure.
+ * @param run  Pending run.
+ * @returns    Error status.
+ */
+static addrxlat_status
+flush_run(const addrxlat_op_range_ctl_t *ctl, struct xlat_run *run)
+{
+	addrxlat_addr_t len = run->len;
+
+	if (!len)
+		return ADDRXLAT_OK;
+	run->len = 0;
+	return ctl->op(ctl->data, &run->src, &run->dst, len);
+}
+
+DEFINE_ALIAS(op_range);
+
+addrxlat_status
+addrxlat_op_range(const addrxlat_op_range_ctl_t *ctl,
+		  const addrxlat_fulladdr_t *addr, addrxlat_addr_t len)
+{
+	addrxlat_op_ctl_t opctl;
+	addrxlat_fulladdr_t src, dst;
+	struct xlat_run run;
+	addrxlat_addr_t endoff;
+	addrxlat_status status, cbstatus;
+
+	clear_error(ctl->ctx);
+
+	opctl.ctx = ctl->ctx;
+	opctl.sys = ctl->sys;
+	opctl.op = storeaddr;
+	opctl.data = &dst;
+	opctl.caps = ctl->caps;
+
+	src = *addr;
+	run.len = 0;
+	while (len) {
+		status = op_endoff(&opctl, &src, &endoff);
+		if (status != ADDRXLAT_OK) {
+			/* Process what was translated before the failure. */
+			cbstatus = flush_run(ctl, &run);
+			return cbstatus != ADDRXLAT_OK ? cbstatus : status;
+		}
+		if (endoff > len - 1)
+			endoff = len - 1;
+
+		if (run.len && dst.as == run.dst.as &&
+		    dst.addr == run.dst.addr + run.len) {
+			run.len += endoff + 1;
+		} else {
+			status = flush_run(ctl, &run);
+			if (status != ADDRXLAT_OK)
+				return status;
+			run.src = src;
+			run.dst = dst;
+			run.len = endoff + 1;
+		}
+
+		src.addr += endoff + 1;
+		len -= endoff + 1;
+	}
+
+	return flush_run(ctl, &run);
+}
+
+/** Element of a sorted translation batch.
+ * @sa addrxlat_op_batch
+ */
+struct batch_elem {
+	addrxlat_fulladdr_t addr; /**< Address to be translated. */
+	size_t idx;		  /**< Index in the input array. */
+};
+
+static int
+batch_elem_cmp(const void *a, const void *b)
+{
+	const struct batch_elem *ea = a, *eb = b;
+
+	if (ea->addr.as != eb->addr.as)
+		return ea->addr.as < eb->addr.as ? -1 : 1;
+	if (ea->addr.addr != eb->addr.addr)
+		return ea->addr.addr < eb->addr.addr ? -1 : 1;
+	return ea->idx < eb->idx ? -1 : ea->idx > eb->idx;
+}
+
+/** Translate one element of a batch.
+ * @param opctl   Control structure (with @ref storeaddr as callback).
+ * @param addr    Address to be translated.
+ * @param result  Translated address.
+ * @returns       Error status.
+ */
+static addrxlat_status
+batch_one(addrxlat_op_ctl_t *opctl, const addrxlat_fulladdr_t *addr,
+	  addrxlat_fulladdr_t *result)
+{
+	addrxlat_addr_t endoff;
+	addrxlat_status status;
+
+	opctl->data = result;
+	status = op_endoff(opctl, addr, &endoff);
+	if (status != ADDRXLAT_OK) {
+		result->addr = 0;
+		result->as = ADDRXLAT_NOADDR;
+	}
+	return status;
+}
+
+DEFINE_ALIAS(op_batch);
+
+addrxlat_status
+addrxlat_op_batch(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys,
+		  unsigned long caps, size_t n,
+		  const addrxlat_fulladdr_t *addrs,
+		  addrxlat_fulladdr_t *results, addrxlat_status *status)
+{
+	addrxlat_op_ctl_t opctl;
+	addrxlat_fulladdr_t addr, firstaddr, tmp;
+	struct batch_elem *elems;
+	size_t i, idx, first;
+
+	clear_error(ctx);
+
+	opctl.ctx = ctx;
+	opctl.sys = sys;
+	opctl.op = storeaddr;
+	opctl.caps = caps;
+
+	/* Translate in address order, so consecutive walks share
+	 * the cached upper-level page table entries. If the array
+	 * cannot be allocated, translate in the original order.
+	 */
+	elems = n <= SIZE_MAX / sizeof(*elems)
+		? malloc(n * sizeof(*elems))
+		: NULL;
+	if (elems) {
+		for (i = 0; i < n; ++i) {
+			elems[i].addr = addrs[i];
+			elems[i].idx = i;
+		}
+		qsort(elems, n, sizeof(*elems), batch_elem_cmp);
+	}
+
+	first = n;
+	firstaddr.addr = 0;
+	firstaddr.as = ADDRXLAT_NOADDR;
+	for (i = 0; i < n; ++i) {
+		if (elems) {
+			addr = elems[i].addr;
+			idx = elems[i].idx;
+		} else {
+			addr = addrs[i];
+			idx = i;
+		}
+
+		status[idx] = batch_one(&opctl, &addr, &results[idx]);
+		if (status[idx] != ADDRXLAT_OK) {
+			if (idx < first) {
+				first = idx;
+				firstaddr = addr;
+			}
+			clear_error(ctx);
+		}
+	}
+	free(elems);
+
+	if (first == n)
+		return ADDRXLAT_OK;
+
+	/* Translate the first failed element again to get its error
+	 * message. Note that @p addrs may be the same as @p results.
+	 */
+	batch_one(&opctl, &firstaddr, &tmp);
+	return status[first];
+}
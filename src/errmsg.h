@@ -82,6 +82,20 @@ err_str(const kdump_errmsg_t *err)
 	return *(char* const*)err;
 }
 
+/** Remove messages which were added after a given point.
+ * @param err  Error string object.
+ * @param len  Length of the error string at that point.
+ *
+ * New messages are always added in front of the existing error string,
+ * so the previous string can be restored by skipping them.
+ */
+static inline void
+err_truncate(kdump_errmsg_t *err, size_t len)
+{
+	if (err->str)
+		err->str += strlen(err->str) - len;
+}
+
 /* This declaration may not be available by default. */
 extern int vsnprintf(char *, size_t, const char *, va_list);
 
@@ -0,0 +1,169 @@
+/** @internal @file src/kdumpfile/bench-bitmap.c
+ * @brief Benchmark raw bitmap functions.
+ */
+/* Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+/** Size of the bitmap used for benchmarks (in bytes).
+ * This corresponds to a 1 TiB dump with 4 KiB pages.
+ */
+#define BENCH_SIZE	(32 << 20)
+
+/** Distance between isolated bits in benchmark bitmaps (in bytes). */
+#define BENCH_STRIDE	(1 << 20)
+
+/** Number of benchmark iterations. */
+#define BENCH_LOOPS	4
+
+static double
+elapsed(const struct timespec *start, const struct timespec *end)
+{
+	return (end->tv_sec - start->tv_sec) +
+		(end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/** Scan a sparse bitmap with an implementation.
+ * @returns Throughput in MiB/s.
+ */
+static double
+bench_skip(const struct skip_bytes_impl *impl,
+	   const unsigned char *buf, unsigned char fill)
+{
+	struct timespec start, end;
+	const unsigned char *p;
+	unsigned long n;
+	int i;
+
+	n = 0;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCH_LOOPS; ++i) {
+		p = buf;
+		while ((p = impl->fn(p, buf + BENCH_SIZE, fill)) <
+		       buf + BENCH_SIZE) {
+			++p;
+			++n;
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (n != BENCH_LOOPS * (BENCH_SIZE / BENCH_STRIDE))
+		printf("%s: found %lu bytes, expected %lu\n",
+		       impl->name, n,
+		       (unsigned long)BENCH_LOOPS *
+		       (BENCH_SIZE / BENCH_STRIDE));
+
+	return (double)BENCH_LOOPS * BENCH_SIZE / (1 << 20) /
+		elapsed(&start, &end);
+}
+
+/** Fill a bitmap with single bits and compare to a bit loop.
+ */
+static void
+bench_fill(unsigned char *buf)
+{
+	struct timespec start, end;
+	size_t idx;
+	int i;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (i = 0; i < BENCH_LOOPS; ++i) {
+		set_bits(buf, 3, ((size_t)BENCH_SIZE << 3) - 5);
+		clear_bits(buf, 5, ((size_t)BENCH_SIZE << 3) - 3);
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("set_bits/clear_bits: %.1f MiB/s\n",
+	       2.0 * BENCH_LOOPS * BENCH_SIZE / (1 << 20) /
+	       elapsed(&start, &end));
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (idx = 3; idx <= ((size_t)BENCH_SIZE << 3) - 5; ++idx)
+		buf[idx >> 3] |= 1 << (idx & 7);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	printf("bit loop: %.1f MiB/s\n",
+	       (double)BENCH_SIZE / (1 << 20) / elapsed(&start, &end));
+}
+
+/** Run all benchmarks.
+ * @returns Zero on success, -1 if the bitmap cannot be allocated.
+ */
+static int
+bench_all(void)
+{
+	const struct skip_bytes_impl *impl;
+	unsigned char *buf;
+	size_t off;
+
+	buf = malloc(BENCH_SIZE);
+	if (!buf) {
+		perror("Cannot allocate benchmark bitmap");
+		return -1;
+	}
+
+	for (impl = skip_bytes_impls; impl->name; ++impl) {
+		double zero, ones;
+
+		if (impl->supported && !impl->supported()) {
+			printf("%s: not supported by this CPU\n", impl->name);
+			continue;
+		}
+
+		memset(buf, 0x00, BENCH_SIZE);
+		for (off = BENCH_STRIDE - 1; off < BENCH_SIZE;
+		     off += BENCH_STRIDE)
+			buf[off] = 0x10;
+		zero = bench_skip(impl, buf, 0x00);
+
+		memset(buf, 0xff, BENCH_SIZE);
+		for (off = BENCH_STRIDE - 1; off < BENCH_SIZE;
+		     off += BENCH_STRIDE)
+			buf[off] = 0xef;
+		ones = bench_skip(impl, buf, 0xff);
+
+		printf("%s: %.1f MiB/s (clear), %.1f MiB/s (set)\n",
+		       impl->name, zero, ones);
+	}
+
+	bench_fill(buf);
+
+	free(buf);
+	return 0;
+}
+
+int
+main(int argc, char **argv)
+{
+	return bench_all() ? EXIT_FAILURE : EXIT_SUCCESS;
+}
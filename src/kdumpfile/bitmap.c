@@ -35,6 +35,10 @@
 #include <string.h>
 #include <stdlib.h>
 
+#ifdef HAVE_X86_SIMD
+#include <immintrin.h>
+#endif
+
 /** Maximum length of the static error message. */
 #define ERRBUF	80
 
@@ -86,6 +90,252 @@ clear_bits(unsigned char *buf, size_t start, size_t end)
 		buf[startbyte] &= startmask | ~endmask;
 }
 
+/** Skip bytes equal to @p fill one at a time.
+ * @param p     First byte to check.
+ * @param end   End of the buffer.
+ * @param fill  Byte value to skip (@c 0x00 or @c 0xff).
+ * @returns     Pointer to the first byte not equal to @p fill,
+ *              or @p end if there is no such byte.
+ *
+ * This is the reference implementation.
+ */
+static const unsigned char *
+skip_bytes_byte(const unsigned char *p, const unsigned char *end,
+		unsigned char fill)
+{
+	while (p < end && *p == fill)
+		++p;
+	return p;
+}
+
+/** Skip bytes equal to @p fill one machine word at a time.
+ * @param p     First byte to check.
+ * @param end   End of the buffer.
+ * @param fill  Byte value to skip (@c 0x00 or @c 0xff).
+ * @returns     Pointer to the first byte not equal to @p fill,
+ *              or @p end if there is no such byte.
+ */
+static const unsigned char *
+skip_bytes_word(const unsigned char *p, const unsigned char *end,
+		unsigned char fill)
+{
+	const unsigned long pattern = fill ? ~0UL : 0UL;
+	unsigned long word;
+
+	while (p < end && ((uintptr_t)p & (sizeof(word) - 1))) {
+		if (*p != fill)
+			return p;
+		++p;
+	}
+
+	while ((size_t)(end - p) >= sizeof(word)) {
+		memcpy(&word, p, sizeof(word));
+		if (word != pattern)
+			break;
+		p += sizeof(word);
+	}
+
+	return skip_bytes_byte(p, end, fill);
+}
+
+#ifdef HAVE_X86_SIMD
+
+static int
+have_sse2(void)
+{
+	return __builtin_cpu_supports("sse2");
+}
+
+/** Skip bytes equal to @p fill using SSE2 instructions.
+ * @param p     First byte to check.
+ * @param end   End of the buffer.
+ * @param fill  Byte value to skip (@c 0x00 or @c 0xff).
+ * @returns     Pointer to the first byte not equal to @p fill,
+ *              or @p end if there is no such byte.
+ */
+__attribute__((target("sse2")))
+static const unsigned char *
+skip_bytes_sse2(const unsigned char *p, const unsigned char *end,
+		unsigned char fill)
+{
+	const __m128i pattern = _mm_set1_epi8(fill);
+	__m128i a, b, c, d;
+
+	/* Four vectors per iteration; AND for 0xff, OR for 0x00. */
+	while (end - p >= 4 * 16) {
+		a = _mm_loadu_si128((const __m128i *)p);
+		b = _mm_loadu_si128((const __m128i *)(p + 16));
+		c = _mm_loadu_si128((const __m128i *)(p + 32));
+		d = _mm_loadu_si128((const __m128i *)(p + 48));
+		if (fill) {
+			a = _mm_and_si128(a, b);
+			c = _mm_and_si128(c, d);
+			a = _mm_and_si128(a, c);
+		} else {
+			a = _mm_or_si128(a, b);
+			c = _mm_or_si128(c, d);
+			a = _mm_or_si128(a, c);
+		}
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, pattern)) != 0xffff)
+			break;
+		p += 4 * 16;
+	}
+
+	while (end - p >= 16) {
+		a = _mm_loadu_si128((const __m128i *)p);
+		if (_mm_movemask_epi8(_mm_cmpeq_epi8(a, pattern)) != 0xffff)
+			break;
+		p += 16;
+	}
+
+	return skip_bytes_byte(p, end, fill);
+}
+
+static int
+have_avx2(void)
+{
+	return __builtin_cpu_supports("avx2");
+}
+
+/** Skip bytes equal to @p fill using AVX2 instructions.
+ * @param p     First byte to check.
+ * @param end   End of the buffer.
+ * @param fill  Byte value to skip (@c 0x00 or @c 0xff).
+ * @returns     Pointer to the first byte not equal to @p fill,
+ *              or @p end if there is no such byte.
+ */
+__attribute__((target("avx2")))
+static const unsigned char *
+skip_bytes_avx2(const unsigned char *p, const unsigned char *end,
+		unsigned char fill)
+{
+	const __m256i pattern = _mm256_set1_epi8(fill);
+	__m256i a, b, c, d;
+
+	/* Four vectors per iteration; AND for 0xff, OR for 0x00. */
+	while (end - p >= 4 * 32) {
+		a = _mm256_loadu_si256((const __m256i *)p);
+		b = _mm256_loadu_si256((const __m256i *)(p + 32));
+		c = _mm256_loadu_si256((const __m256i *)(p + 64));
+		d = _mm256_loadu_si256((const __m256i *)(p + 96));
+		if (fill) {
+			a = _mm256_and_si256(a, b);
+			c = _mm256_and_si256(c, d);
+			a = _mm256_and_si256(a, c);
+		} else {
+			a = _mm256_or_si256(a, b);
+			c = _mm256_or_si256(c, d);
+			a = _mm256_or_si256(a, c);
+		}
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, pattern)) != -1)
+			break;
+		p += 4 * 32;
+	}
+
+	while (end - p >= 32) {
+		a = _mm256_loadu_si256((const __m256i *)p);
+		if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, pattern)) != -1)
+			break;
+		p += 32;
+	}
+
+	return skip_bytes_sse2(p, end, fill);
+}
+
+#endif	/* HAVE_X86_SIMD */
+
+/** All byte skipping implementations, from the slowest to the fastest.
+ * The list is terminated by an entry with a @c NULL name.
+ */
+const struct skip_bytes_impl skip_bytes_impls[] = {
+	{ "byte", NULL, skip_bytes_byte },
+	{ "word", NULL, skip_bytes_word },
+#ifdef HAVE_X86_SIMD
+	{ "sse2", have_sse2, skip_bytes_sse2 },
+	{ "avx2", have_avx2, skip_bytes_avx2 },
+#endif
+	{ NULL, NULL, NULL }
+};
+
+static skip_bytes_fn select_skip_bytes;
+
+/** Byte skipping function used by the bitmap scanners.
+ * This is set to the fastest supported implementation on first use.
+ */
+static skip_bytes_fn *skip_bytes = select_skip_bytes;
+
+static const unsigned char *
+select_skip_bytes(const unsigned char *p, const unsigned char *end,
+		  unsigned char fill)
+{
+	const struct skip_bytes_impl *impl;
+	skip_bytes_fn *best = skip_bytes_byte;
+
+	for (impl = skip_bytes_impls; impl->name; ++impl)
+		if (!impl->supported || impl->supported())
+			best = impl->fn;
+
+	/* Concurrent callers may race here, but they store the same value. */
+	skip_bytes = best;
+	return best(p, end, fill);
+}
+
+/** Find the next set bit in a raw bitmap.
+ * @param buf   Raw bitmap.
+ * @param size  Size of the bitmap in bytes.
+ * @param idx   Starting bit index.
+ * @returns     Index of the first set bit at or after @p idx, or
+ *              <code>size * 8</code> if there is none. If @p idx
+ *              is beyond the end of the bitmap, it is returned as is.
+ */
+size_t
+skip_clear_bits(const unsigned char *buf, size_t size, size_t idx)
+{
+	const unsigned char *p = buf + (idx >> 3);
+	const unsigned char *end = buf + size;
+	unsigned bits;
+
+	if (p >= end)
+		return idx;
+
+	bits = *p >> (idx & 7);
+	if (bits)
+		return idx + ffs(bits) - 1;
+
+	p = skip_bytes(p + 1, end, 0x00);
+	if (p >= end)
+		return size << 3;
+	return ((size_t)(p - buf) << 3) + ffs(*p) - 1;
+}
+
+/** Find the next clear bit in a raw bitmap.
+ * @param buf   Raw bitmap.
+ * @param size  Size of the bitmap in bytes.
+ * @param idx   Starting bit index.
+ * @returns     Index of the first clear bit at or after @p idx, or
+ *              <code>size * 8</code> if there is none. If @p idx
+ *              is beyond the end of the bitmap, it is returned as is.
+ */
+size_t
+skip_set_bits(const unsigned char *buf, size_t size, size_t idx)
+{
+	const unsigned char *p = buf + (idx >> 3);
+	const unsigned char *end = buf + size;
+	unsigned bits;
+
+	if (p >= end)
+		return idx;
+
+	bits = (unsigned char)~*p >> (idx & 7);
+	if (bits)
+		return idx + ffs(bits) - 1;
+
+	p = skip_bytes(p + 1, end, 0xff);
+	if (p >= end)
+		return size << 3;
+	return ((size_t)(p - buf) << 3) + ffs((unsigned char)~*p) - 1;
+}
+
 /** Allocate a new bitmap object.
  * @param ops  Bitmap operations.
  * @returns    New bitmap, or @c NULL on allocation error.
@@ -130,33 +380,263 @@ kdump_bmp_get_err(const kdump_bmp_t *bmp)
 	return err_str(&bmp->err);
 }
 
+/** Add a run of set bits to a run iteration.
+ * @param st     Run iteration state.
+ * @param start  First index of the run.
+ * @param end    Last index of the run.
+ * @returns      Non-zero if the caller should stop the iteration.
+ *
+ * Runs must be added in ascending order of their start index. They
+ * may overlap or be adjacent to each other; such runs are merged.
+ * A run is passed to the user callback only after it is known to
+ * be maximal, i.e. when a following run does not extend it, or when
+ * the iteration is finished with @ref bmp_run_flush.
+ */
+int
+bmp_run_add(struct bmp_run_state *st, kdump_addr_t start, kdump_addr_t end)
+{
+	if (st->stopped || start > st->last)
+		return 1;
+	if (end < st->first)
+		return 0;
+
+	if (start < st->first)
+		start = st->first;
+	if (end > st->last)
+		end = st->last;
+
+	if (st->pending) {
+		if (start <= st->end || start - 1 == st->end) {
+			if (end > st->end)
+				st->end = end;
+			return st->end == st->last;
+		}
+
+		st->pending = false;
+		if (st->fn(st->data, st->start, st->end)) {
+			st->stopped = true;
+			return 1;
+		}
+	}
+
+	st->start = start;
+	st->end = end;
+	st->pending = true;
+	return end == st->last;
+}
+
+/** Pass the last pending run (if any) to the user callback.
+ * @param st  Run iteration state.
+ */
+static void
+bmp_run_flush(struct bmp_run_state *st)
+{
+	if (st->pending && !st->stopped) {
+		st->pending = false;
+		if (st->fn(st->data, st->start, st->end))
+			st->stopped = true;
+	}
+}
+
+/** Iterate over runs using the find_set and find_clear methods.
+ * @param bmp  Bitmap object.
+ * @param st   Run iteration state.
+ * @returns    Error status.
+ *
+ * This is the fallback for bitmaps which do not implement the
+ * @c iter_runs method.
+ */
+static kdump_status
+find_runs(kdump_bmp_t *bmp, struct bmp_run_state *st)
+{
+	kdump_addr_t idx, end;
+	kdump_status status;
+
+	idx = st->first;
+	for (;;) {
+		status = bmp->ops->find_set(&bmp->err, bmp, &idx);
+		if (status == KDUMP_ERR_NODATA) {
+			err_clear(&bmp->err);
+			return KDUMP_OK;
+		}
+		if (status != KDUMP_OK || idx > st->last)
+			return status;
+
+		end = idx;
+		status = bmp->ops->find_clear(&bmp->err, bmp, &end);
+		if (status == KDUMP_ERR_NODATA) {
+			err_clear(&bmp->err);
+			end = 0;
+		} else if (status != KDUMP_OK)
+			return status;
+
+		/* A clear bit at zero means that the run wraps around. */
+		if (bmp_run_add(st, idx, end - 1) || end == 0)
+			return KDUMP_OK;
+		idx = end;
+	}
+}
+
+/** Iterate over runs of set bits.
+ * @param bmp    Bitmap object.
+ * @param first  First index in the bitmap.
+ * @param last   Last index in the bitmap.
+ * @param fn     Callback function.
+ * @param data   Callback data.
+ * @returns      Error status.
+ */
+static kdump_status
+iter_runs(kdump_bmp_t *bmp, kdump_addr_t first, kdump_addr_t last,
+	  kdump_bmp_run_fn *fn, void *data)
+{
+	struct bmp_run_state st;
+	kdump_status status;
+
+	st.first = first;
+	st.last = last;
+	st.fn = fn;
+	st.data = data;
+	st.pending = false;
+	st.stopped = false;
+
+	if (first > last)
+		return KDUMP_OK;
+
+	status = bmp->ops->iter_runs
+		? bmp->ops->iter_runs(&bmp->err, bmp, &st)
+		: find_runs(bmp, &st);
+	if (status == KDUMP_OK)
+		bmp_run_flush(&st);
+	return status;
+}
+
+/** Raw bitmap for @ref runs_get_bits. */
+struct raw_bits {
+	unsigned char *raw;	/**< Raw bitmap buffer. */
+	kdump_addr_t first;	/**< Index of the first bit in @c raw. */
+};
+
+static int
+set_run_bits(void *data, kdump_addr_t first, kdump_addr_t last)
+{
+	struct raw_bits *rb = data;
+	set_bits(rb->raw, first - rb->first, last - rb->first);
+	return 0;
+}
+
+/** Get raw bits using the iter_runs method. */
+static kdump_status
+runs_get_bits(kdump_bmp_t *bmp, kdump_addr_t first, kdump_addr_t last,
+	      unsigned char *raw)
+{
+	struct raw_bits rb;
+
+	memset(raw, 0, ((last - first) >> 3) + 1);
+	rb.raw = raw;
+	rb.first = first;
+	return iter_runs(bmp, first, last, set_run_bits, &rb);
+}
+
+/** Result of @ref get_first_run. */
+struct first_run {
+	kdump_addr_t first;	/**< First index of the run. */
+	kdump_addr_t last;	/**< Last index of the run. */
+	bool found;		/**< A run was found. */
+};
+
+static int
+get_first_run(void *data, kdump_addr_t first, kdump_addr_t last)
+{
+	struct first_run *run = data;
+	run->first = first;
+	run->last = last;
+	run->found = true;
+	return 1;
+}
+
+/** Find a set bit using the iter_runs method. */
+static kdump_status
+runs_find_set(kdump_bmp_t *bmp, kdump_addr_t *idx)
+{
+	struct first_run run;
+	kdump_status status;
+
+	run.found = false;
+	status = iter_runs(bmp, *idx, KDUMP_ADDR_MAX, get_first_run, &run);
+	if (status != KDUMP_OK)
+		return status;
+	if (!run.found)
+		return status_err(&bmp->err, KDUMP_ERR_NODATA,
+				  "No such bit not found");
+	*idx = run.first;
+	return KDUMP_OK;
+}
+
+/** Find a zero bit using the iter_runs method. */
+static kdump_status
+runs_find_clear(kdump_bmp_t *bmp, kdump_addr_t *idx)
+{
+	struct first_run run;
+	kdump_status status;
+
+	run.found = false;
+	status = iter_runs(bmp, *idx, KDUMP_ADDR_MAX, get_first_run, &run);
+	if (status != KDUMP_OK)
+		return status;
+	if (run.found && run.first == *idx) {
+		if (run.last == KDUMP_ADDR_MAX)
+			return status_err(&bmp->err, KDUMP_ERR_NODATA,
+					  "No such bit not found");
+		*idx = run.last + 1;
+	}
+	return KDUMP_OK;
+}
+
 kdump_status
 kdump_bmp_get_bits(kdump_bmp_t *bmp,
 		   kdump_addr_t first, kdump_addr_t last, unsigned char *raw)
 {
 	err_clear(&bmp->err);
-	if (!bmp->ops->get_bits)
-		return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
-				  "Function not implemented");
-	return bmp->ops->get_bits(&bmp->err, bmp, first, last, raw);
+	if (bmp->ops->get_bits)
+		return bmp->ops->get_bits(&bmp->err, bmp, first, last, raw);
+	if (bmp->ops->iter_runs)
+		return runs_get_bits(bmp, first, last, raw);
+	return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
+			  "Function not implemented");
 }
 
 kdump_status
 kdump_bmp_find_set(kdump_bmp_t *bmp, kdump_addr_t *idx)
 {
 	err_clear(&bmp->err);
-	if (!bmp->ops->find_set)
-		return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
-				  "Function not implemented");
-	return bmp->ops->find_set(&bmp->err, bmp, idx);
+	if (bmp->ops->find_set)
+		return bmp->ops->find_set(&bmp->err, bmp, idx);
+	if (bmp->ops->iter_runs)
+		return runs_find_set(bmp, idx);
+	return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
+			  "Function not implemented");
 }
 
 kdump_status
 kdump_bmp_find_clear(kdump_bmp_t *bmp, kdump_addr_t *idx)
 {
 	err_clear(&bmp->err);
-	if (!bmp->ops->find_clear)
+	if (bmp->ops->find_clear)
+		return bmp->ops->find_clear(&bmp->err, bmp, idx);
+	if (bmp->ops->iter_runs)
+		return runs_find_clear(bmp, idx);
+	return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
+			  "Function not implemented");
+}
+
+kdump_status
+kdump_bmp_iter_runs(kdump_bmp_t *bmp, kdump_addr_t first, kdump_addr_t last,
+		    kdump_bmp_run_fn *fn, void *data)
+{
+	err_clear(&bmp->err);
+	if (!bmp->ops->iter_runs &&
+	    !(bmp->ops->find_set && bmp->ops->find_clear))
 		return status_err(&bmp->err, KDUMP_ERR_NOTIMPL,
 				  "Function not implemented");
-	return bmp->ops->find_clear(&bmp->err, bmp, idx);
+	return iter_runs(bmp, first, last, fn, data);
 }
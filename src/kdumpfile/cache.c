@@ -33,6 +33,7 @@
 #include "kdumpfile-priv.h"
 
 #include <stdlib.h>
+#include <stddef.h>
 #include <limits.h>
 
 /**  Simple cache.
@@ -47,33 +48,22 @@
  * Cached entries have a non-NULL data pointer. Ghost entries do not have
  * any data, so their data pointer is NULL.
  *
- * The cache is implemented as a circular list. This allows to move around
- * entries without copying much data even if the cache is large.
- * The list is organized as follows:
+ * Each section is a circular doubly linked list with a sentinel entry,
+ * stored after the 2 * @c cap real entries (see @ref cache_list). The
+ * MRU entry is next to the sentinel, and the LRU entry is previous to
+ * the sentinel. Entries which are being read (in-flight entries) are
+ * kept on a separate list. This allows to move entries between lists
+ * without copying much data even if the cache is large.
  *
- *               <-- ngprobe --> <- nprobe -> <- nprec -> <--- ngprec --->
- *     +--------+---------------+------------+-----------+----------------+
- *     | unused | ghost probed  |   probed   | precious  | ghost precious |
- *     +--------+---------------+------------+-----------+----------------+
- *             ^               ^            ^             ^                ^
- *             eprobe          gprobe     split       gprec            eprec
+ * All entries that are not unused are also linked from a hash table,
+ * so a key can be found without walking the lists. The hash table uses
+ * open addressing with linear probing. It is kept at most half full,
+ * because there are never more than 2 * @c cap keyed entries.
  *
- *
- * Only the @ref split index and the four sizes are stored in the structure.
- * During a search, the remaining pointers are found as a side effect, and
- * they are stored in @ref cache_search.
- *
- * Note that any section may be empty; some pointers will share the same
- * value in such case.
- *
- * Also note that since the list is circular, unused entries are in fact
- * between ghost probed and ghost precious lists. This part of the cache
- * is usually empty; it's used only after a flush or when an entry is
- * discarded.
+ * The unused pool is usually empty; it's used only after a flush or
+ * when an entry is discarded.
  */
 struct cache {
-	unsigned split;		 /**< Split point between probed and precious
-				  *   entries (index of MRU probed entry) */
 	unsigned nprec;		 /**< Number of cached precious entries */
 	unsigned ngprec;	 /**< Number of ghost precious entries */
 	unsigned nprobe;	 /**< Number of cached probe entries */
@@ -82,9 +72,11 @@ struct cache {
 	unsigned nprobetotal;	 /**< Total number of probe list entries,
 				  *   including ghost and in-flight entries */
 	unsigned cap;		 /**< Total cache capacity */
-	unsigned inflight;	 /**< Index of first in-flight entry */
 	unsigned ninflight;	 /**< Number of in-flight entries */
 
+	unsigned hbits;		 /**< Hash table size (log2) */
+	unsigned *hash;		 /**< Hash table (entry indices) */
+
 	kdump_attr_value_t hits;   /**< Cache hits */
 	kdump_attr_value_t misses; /**< Cache misses */
 
@@ -97,23 +89,123 @@ struct cache {
 	struct cache_entry ce[]; /**< Cache entries */
 };
 
-/**  Temporary information needed during a cache search.
- * This is grouped in a structure to avoid passing an inordinate number
- * of parameters among the various helper functions.
- */
-struct cache_search {
-	unsigned gprec;		/**< Index of MRU precious ghost entry */
-	unsigned eprec;		/**< End of precious entries; this is the
-				 *   index of the first unused entry. */
-	unsigned uprec;		/**< Index of LRU unused precious entry. */
-	unsigned nuprec;	/**< Number of unused precious entries. */
-	unsigned gprobe;	/**< Index of MRU probed ghost entry */
-	unsigned eprobe;	/**< End of probed entries; this is the
-				 *   index of the first unused entry. */
-	unsigned uprobe;	/**< Index of LRU unused probed entry. */
-	unsigned nuprobe;	/**< Number of unused probed entries. */
+/**  Cache lists.
+ * The sentinel entry of each list is stored in the cache entry array
+ * just after the real entries.
+ */
+enum cache_list {
+	cl_unused,		/**< Unused pool */
+	cl_gprobe,		/**< Ghost probe list */
+	cl_probe,		/**< Probed list */
+	cl_prec,		/**< Precious list */
+	cl_gprec,		/**< Ghost precious list */
+	cl_inflight,		/**< In-flight entries */
+
+	NR_CACHE_LISTS		/**< Total number of cache lists */
 };
 
+/** Invalid cache entry index.
+ * This value marks a free slot in the hash table.
+ */
+#define CACHE_NOIDX	(~0U)
+
+/**  Get the sentinel index of a list.
+ * @param cache  Cache object.
+ * @param list   Cache list.
+ * @returns      Index of the list sentinel entry.
+ */
+static inline unsigned
+list_head(const struct cache *cache, enum cache_list list)
+{
+	return 2 * cache->cap + list;
+}
+
+/**  Get the LRU entry of a list.
+ * @param cache  Cache object.
+ * @param list   Cache list.
+ * @returns      Index of the LRU entry, or the sentinel if the list is empty.
+ */
+static inline unsigned
+list_lru(const struct cache *cache, enum cache_list list)
+{
+	return cache->ce[list_head(cache, list)].prev;
+}
+
+/**  Get the home slot of a key in the hash table.
+ * @param cache  Cache object.
+ * @param key    Cache key.
+ * @returns      Hash table index.
+ */
+static inline unsigned
+key_slot(const struct cache *cache, cache_key_t key)
+{
+	return fold_hash(key ^ (key >> 32), cache->hbits);
+}
+
+/**  Find a key in the hash table.
+ * @param cache  Cache object.
+ * @param key    Cache key.
+ * @returns      Entry index, or @ref CACHE_NOIDX if not found.
+ */
+static unsigned
+hash_find(const struct cache *cache, cache_key_t key)
+{
+	unsigned mask = (1U << cache->hbits) - 1;
+	unsigned slot, idx;
+
+	for (slot = key_slot(cache, key); ; slot = (slot + 1) & mask) {
+		idx = cache->hash[slot];
+		if (idx == CACHE_NOIDX || cache->ce[idx].key == key)
+			return idx;
+	}
+}
+
+/**  Add an entry to the hash table.
+ * @param cache  Cache object.
+ * @param idx    Entry index.
+ */
+static void
+hash_add(struct cache *cache, unsigned idx)
+{
+	unsigned mask = (1U << cache->hbits) - 1;
+	unsigned slot = key_slot(cache, cache->ce[idx].key);
+
+	while (cache->hash[slot] != CACHE_NOIDX)
+		slot = (slot + 1) & mask;
+	cache->hash[slot] = idx;
+}
+
+/**  Remove an entry from the hash table.
+ * @param cache  Cache object.
+ * @param idx    Entry index.
+ *
+ * Entries which follow the removed one in the same probe sequence are
+ * shifted back, so that no tombstones are needed.
+ */
+static void
+hash_remove(struct cache *cache, unsigned idx)
+{
+	unsigned mask = (1U << cache->hbits) - 1;
+	unsigned slot, next, home;
+
+	slot = key_slot(cache, cache->ce[idx].key);
+	while (cache->hash[slot] != idx)
+		slot = (slot + 1) & mask;
+
+	next = slot;
+	for (;;) {
+		next = (next + 1) & mask;
+		if (cache->hash[next] == CACHE_NOIDX)
+			break;
+		home = key_slot(cache, cache->ce[cache->hash[next]].key);
+		if (((next - home) & mask) >= ((next - slot) & mask)) {
+			cache->hash[slot] = cache->hash[next];
+			slot = next;
+		}
+	}
+	cache->hash[slot] = CACHE_NOIDX;
+}
+
 /**  Add an entry to the list after a given point.
  * @param cache   Cache object.
  * @param entry   Cache entry to be added.
@@ -170,19 +262,43 @@ remove_entry(struct cache *cache, struct cache_entry *entry)
 	prev->next = entry->next;
 }
 
-/**  Add an entry to the inflight list.
+/**  Move an entry to the MRU position of a list.
  *
  * @param cache  Cache object.
- * @param entry  Cache entry to be removed.
- * @param idx    Cache entry index.
+ * @param entry  Cache entry to be moved.
+ * @param idx    Index of @ref entry.
+ * @param list   Target list.
  */
 static void
-add_inflight(struct cache *cache, struct cache_entry *entry, unsigned idx)
+move_entry(struct cache *cache, struct cache_entry *entry, unsigned idx,
+	   enum cache_list list)
 {
-	if (cache->ninflight++)
-		add_entry_before(cache, entry, idx, cache->inflight);
-	else
-		cache->inflight = entry->next = entry->prev = idx;
+	remove_entry(cache, entry);
+	add_entry_after(cache, entry, idx, list_head(cache, list));
+	entry->list = list;
+}
+
+/**  Find the LRU unused entry in a list.
+ *
+ * @param cache  Cache object.
+ * @param list   Cache list.
+ * @returns      Index of the LRU entry with a zero reference count,
+ *               or @ref CACHE_NOIDX if all entries are in use.
+ *
+ * Only entries which are in use are skipped, so this is fast unless
+ * most entries in the list are referenced.
+ */
+static unsigned
+find_unused(struct cache *cache, enum cache_list list)
+{
+	unsigned head = list_head(cache, list);
+	unsigned idx;
+
+	for (idx = cache->ce[head].prev; idx != head;
+	     idx = cache->ce[idx].prev)
+		if (cache->ce[idx].refcnt == 0)
+			return idx;
+	return CACHE_NOIDX;
 }
 
 /**  Ensure that a locked in-flight entry goes to the precious list.
@@ -211,31 +327,20 @@ static void
 reuse_cached_entry(struct cache *cache, struct cache_entry *entry,
 		   unsigned idx)
 {
-	if (cache->split != idx && cache->split != entry->prev) {
-		remove_entry(cache, entry);
-		add_entry_after(cache, entry, idx, cache->split);
-	}
-
-	cache->split = entry->prev;
-
+	move_entry(cache, entry, idx, cl_prec);
 	++cache->hits.number;
 }
 
 /**  Evict an entry from the probe list.
  * @param cache  Cache object.
- * @param cs     Cache search info.
+ * @param idx    Index of the LRU unused probed entry.
  * @returns      The evicted entry.
  */
 static struct cache_entry *
-evict_probe(struct cache *cache, struct cache_search *cs)
-{
-	struct cache_entry *entry = &cache->ce[cs->uprobe];
-	if (entry->prev != cs->gprobe) {
-		if (cs->uprobe == cache->split)
-			cache->split = entry->prev;
-		remove_entry(cache, entry);
-		add_entry_after(cache, entry, cs->uprobe, cs->gprobe);
-	}
+evict_probe(struct cache *cache, unsigned idx)
+{
+	struct cache_entry *entry = &cache->ce[idx];
+	move_entry(cache, entry, idx, cl_gprobe);
 	--cache->nprobe;
 	++cache->ngprobe;
 	return entry;
@@ -243,27 +348,62 @@ evict_probe(struct cache *cache, struct cache_search *cs)
 
 /**  Evict an entry from the precious list.
  * @param cache  Cache object.
- * @param cs     Cache search info.
+ * @param idx    Index of the LRU unused precious entry.
  * @returns      The evicted entry.
  */
 static struct cache_entry *
-evict_prec(struct cache *cache, struct cache_search *cs)
+evict_prec(struct cache *cache, unsigned idx)
 {
-	struct cache_entry *entry = &cache->ce[cs->uprec];
-	if (entry->next != cs->gprec) {
-		remove_entry(cache, entry);
-		add_entry_before(cache, entry, cs->uprec, cs->gprec);
-	}
+	struct cache_entry *entry = &cache->ce[idx];
+	move_entry(cache, entry, idx, cl_gprec);
 	--cache->nprec;
 	++cache->ngprec;
 	return entry;
 }
 
+/**  Evict an unused entry and take over its data.
+ *
+ * @param cache        Cache object.
+ * @param entry        Entry which receives the data.
+ * @param probe_first  Non-zero to prefer eviction from the probe list.
+ *
+ * The evicted entry is taken from the preferred list if it contains
+ * an unused entry, otherwise from the other list. If all cached entries
+ * are in use, the data buffer of an entry in the unused pool is taken.
+ */
+static void
+steal_data(struct cache *cache, struct cache_entry *entry, int probe_first)
+{
+	struct cache_entry *evict;
+	unsigned probe, prec;
+
+	probe = find_unused(cache, cl_probe);
+	prec = find_unused(cache, cl_prec);
+	if (probe == CACHE_NOIDX && prec == CACHE_NOIDX) {
+		evict = &cache->ce[list_head(cache, cl_unused)];
+		do
+			evict = &cache->ce[evict->next];
+		while (!evict->data);
+		entry->data = evict->data;
+		evict->data = NULL;
+		return;
+	}
+
+	if (prec == CACHE_NOIDX || (probe_first && probe != CACHE_NOIDX))
+		evict = evict_probe(cache, probe);
+	else
+		evict = evict_prec(cache, prec);
+	if (cache->entry_cleanup)
+		cache->entry_cleanup(cache->cleanup_data, evict);
+
+	entry->data = evict->data;
+	evict->data = NULL;
+}
+
 /**  Re-initialize an entry for different data.
  *
  * @param cache  Cache object.
  * @param entry  Entry to be reinitialized.
- * @param cs     Cache search info.
  *
  * Evict an entry from the cache and use its data pointer for @ref entry.
  * The evicted entry is taken either from the probe list or from the
@@ -274,67 +414,55 @@ evict_prec(struct cache *cache, struct cache_search *cs)
  * @sa reuse_ghost_entry
  */
 static void
-reinit_entry(struct cache *cache, struct cache_entry *entry,
-	     struct cache_search *cs)
+reinit_entry(struct cache *cache, struct cache_entry *entry)
 {
-	struct cache_entry *evict;
 	int delta = cache->dprobe - cache->nprobe;
-
-	if (delta <= 0 && cs->nuprobe == 0)
-		delta = 1;
-	else if (delta > 0 && cs->nuprec == 0)
-		delta = 0;
-
-	if (delta <= 0)
-		evict = evict_probe(cache, cs);
-	else
-		evict = evict_prec(cache, cs);
-	if (cache->entry_cleanup)
-		cache->entry_cleanup(cache->cleanup_data, evict);
-
-	entry->data = evict->data;
-	evict->data = NULL;
+	steal_data(cache, entry, delta <= 0);
 }
 
 /**  Get a cache entry for a given missed key.
  *
  * @param cache  Cache object.
  * @param key    Requested key.
- * @param cs     Cache search info.
  * @returns      A new cache entry.
  */
 static struct cache_entry *
-get_missed_entry(struct cache *cache, cache_key_t key,
-		 struct cache_search *cs)
+get_missed_entry(struct cache *cache, cache_key_t key)
 {
 	struct cache_entry *entry;
 	unsigned idx;
 
 	++cache->nprobetotal;
-	idx = cs->eprobe;
-	entry = &cache->ce[idx];
-	if (entry->next == cs->eprec) {
+	idx = cache->ce[list_head(cache, cl_unused)].next;
+	if (idx == list_head(cache, cl_unused)) {
 		if (cache->nprobetotal > cache->cap) {
-			idx = entry->next;
-			entry = &cache->ce[idx];
-			if (cache->ngprobe)
+			if (cache->ngprobe) {
+				idx = list_lru(cache, cl_gprobe);
 				--cache->ngprobe;
-			else
+			} else {
+				idx = list_lru(cache, cl_probe);
 				--cache->nprobe;
+			}
 			--cache->nprobetotal;
-		} else if (cache->ngprec)
-			   --cache->ngprec;
+		} else {
+			idx = list_lru(cache, cl_gprec);
+			--cache->ngprec;
+		}
 	}
 
-	if (!entry->data)
-		reinit_entry(cache, entry, cs);
+	entry = &cache->ce[idx];
+	remove_entry(cache, entry);
+	if (entry->list != cl_unused)
+		hash_remove(cache, idx);
 
-	if (cache->split == idx)
-		cache->split = entry->prev;
+	if (!entry->data)
+		reinit_entry(cache, entry);
 
-	remove_entry(cache, entry);
-	add_inflight(cache, entry, idx);
+	add_entry_before(cache, entry, idx, list_head(cache, cl_inflight));
+	entry->list = cl_inflight;
+	++cache->ninflight;
 	entry->key = key;
+	hash_add(cache, idx);
 	entry->state = cs_probe;
 
 	return entry;
@@ -345,7 +473,6 @@ get_missed_entry(struct cache *cache, cache_key_t key,
  * @param cache  Cache object.
  * @param entry  Ghost entry to be reused.
  * @param idx    Index of @ref entry.
- * @param cs     Cache search info.
  *
  * Same as @ref reinit_entry, but designed for ghost entries.
  * This function is used for pages that will be added to the precious list,
@@ -355,121 +482,71 @@ get_missed_entry(struct cache *cache, cache_key_t key,
  */
 static void
 reuse_ghost_entry(struct cache *cache, struct cache_entry *entry,
-		  unsigned idx, struct cache_search *cs)
+		  unsigned idx)
 {
-	struct cache_entry *evict;
 	int delta = cache->dprobe - cache->nprobe;
 
-	if (delta < 0 && cs->nuprobe == 0)
-		delta = 0;
-	else if (delta >= 0 && cs->nuprec == 0)
-		delta = -1;
-
-	if (delta < 0)
-		evict = evict_probe(cache, cs);
-	else
-		evict = evict_prec(cache, cs);
-	if (cache->entry_cleanup)
-		cache->entry_cleanup(cache->cleanup_data, evict);
-
-	entry->data = evict->data;
-	evict->data = NULL;
-
-	if (cache->split == idx)
-		cache->split = entry->prev;
+	steal_data(cache, entry, delta < 0);
 
 	remove_entry(cache, entry);
-	add_inflight(cache, entry, idx);
+	add_entry_before(cache, entry, idx, list_head(cache, cl_inflight));
+	entry->list = cl_inflight;
+	++cache->ninflight;
 	entry->state = cs_precious;
 }
 
 /**  Get the ghost entry for a given key.
  *
  * @param cache  Cache object.
- * @param key    Key to be searched.
- * @param cs     Cache search info.
- * @returns      Ghost entry, or @c NULL if not found.
+ * @param entry  Ghost entry found in the hash table.
+ * @param idx    Index of @ref entry.
  *
- * If no entry is found (function returns @c NULL), the @c epreca and
- * @c eprobe fields in @ref cs are updated. Otherwise (if an entry is
- * found), their values are undefined.
+ * Adapt the desired number of probed entries and reuse the ghost entry.
  */
-static struct cache_entry *
-get_ghost_entry(struct cache *cache, cache_key_t key,
-		struct cache_search *cs)
+static void
+get_ghost_entry(struct cache *cache, struct cache_entry *entry,
+		unsigned idx)
 {
-	struct cache_entry *entry;
-	unsigned n, idx;
-
-	/* Search precious ghost entries */
-	n = cache->ngprec;
-	idx = cs->gprec;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			int delta = cache->ngprobe > cache->ngprec
-				? cache->ngprobe / cache->ngprec
-				: 1;
-			if (cache->dprobe > delta)
-				cache->dprobe -= delta;
-			else
-				cache->dprobe = 0;
-			--cache->ngprec;
-			reuse_ghost_entry(cache, entry, idx, cs);
-			return entry;
-		}
-		idx = entry->next;
-	}
-	cs->eprec = idx;
-
-	/* Search probed ghost entries */
-	n = cache->ngprobe;
-	idx = cs->gprobe;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			int delta = cache->ngprec > cache->ngprobe
-				? cache->ngprec / cache->ngprobe
-				: 1;
-			if (cache->dprobe + delta < cache->cap)
-				cache->dprobe += delta;
-			else
-				cache->dprobe = cache->cap;
-			--cache->ngprobe;
-			--cache->nprobetotal;
-			reuse_ghost_entry(cache, entry, idx, cs);
-			return entry;
-		}
-		idx = entry->prev;
+	int delta;
+
+	if (entry->list == cl_gprec) {
+		delta = cache->ngprobe > cache->ngprec
+			? cache->ngprobe / cache->ngprec
+			: 1;
+		if (cache->dprobe > delta)
+			cache->dprobe -= delta;
+		else
+			cache->dprobe = 0;
+		--cache->ngprec;
+	} else {
+		delta = cache->ngprec > cache->ngprobe
+			? cache->ngprec / cache->ngprobe
+			: 1;
+		if (cache->dprobe + delta < cache->cap)
+			cache->dprobe += delta;
+		else
+			cache->dprobe = cache->cap;
+		--cache->ngprobe;
+		--cache->nprobetotal;
 	}
-	cs->eprobe = idx;
-
-	return NULL;
+	reuse_ghost_entry(cache, entry, idx);
 }
 
-/**  Get the in-flight entry for a given key.
+/**  Check whether all cache entries are in use.
  *
  * @param cache  Cache object.
- * @param key    Key to be searched.
- * @returns      In-flight entry, or @c NULL if there is none.
+ * @returns      Non-zero if there is no entry that can be reused.
+ *
+ * Every data buffer is owned by a cached, in-flight or unused entry.
+ * If none of them is owned by an unused entry, the cache is full
+ * unless there is an unreferenced cached entry.
  */
-static struct cache_entry *
-get_inflight_entry(struct cache *cache, cache_key_t key)
+static int
+cache_full(struct cache *cache)
 {
-	struct cache_entry *entry;
-	unsigned idx, n;
-
-	idx = cache->inflight;
-	for (n = cache->ninflight; n; --n) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			make_precious(cache, entry);
-			return entry;
-		}
-		idx = entry->next;
-	}
-
-	return NULL;
+	return cache->nprec + cache->nprobe + cache->ninflight >= cache->cap &&
+		find_unused(cache, cl_prec) == CACHE_NOIDX &&
+		find_unused(cache, cl_probe) == CACHE_NOIDX;
 }
 
 /**  Search the cache for an entry.
@@ -481,64 +558,33 @@ get_inflight_entry(struct cache *cache, cache_key_t key)
 static struct cache_entry *
 cache_get_entry_noref(struct cache *cache, cache_key_t key)
 {
-	struct cache_search cs;
 	struct cache_entry *entry;
-	unsigned n, idx;
-
-	cs.nuprec = 0;
-	cs.nuprobe = 0;
-
-	/* Search precious entries */
-	n = cache->nprec;
-	idx = cache->ce[cache->split].next;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			reuse_cached_entry(cache, entry, idx);
-			return entry;
-		}
-		if (entry->refcnt == 0) {
-			cs.uprec = idx;
-			++cs.nuprec;
-		}
-		idx = entry->next;
-	}
-	cs.gprec = idx;
-
-	/* Search probed entries */
-	n = cache->nprobe;
-	idx = cache->split;
-	while (n--) {
-		entry = &cache->ce[idx];
-		if (entry->key == key) {
-			--cache->nprobe;
-			++cache->nprec;
-			--cache->nprobetotal;
-			reuse_cached_entry(cache, entry, idx);
-			return entry;
-		}
-		if (entry->refcnt == 0) {
-			cs.uprobe = idx;
-			++cs.nuprobe;
-		}
-		idx = entry->prev;
-	}
-	cs.gprobe = idx;
+	unsigned idx;
 
-	entry = get_inflight_entry(cache, key);
+	idx = hash_find(cache, key);
+	entry = (idx != CACHE_NOIDX) ? &cache->ce[idx] : NULL;
 
-	if (!entry) {
-		unsigned inuse = (cache->nprec - cs.nuprec) +
-			(cache->nprobe - cs.nuprobe) +
-			cache->ninflight;
-		if (inuse >= cache->cap)
-			return NULL;
+	if (entry && entry->list == cl_prec) {
+		reuse_cached_entry(cache, entry, idx);
+		return entry;
+	}
+
+	if (entry && entry->list == cl_probe) {
+		--cache->nprobe;
+		++cache->nprec;
+		--cache->nprobetotal;
+		reuse_cached_entry(cache, entry, idx);
+		return entry;
 	}
 
-	if (!entry)
-		entry = get_ghost_entry(cache, key, &cs);
-	if (!entry)
-		entry = get_missed_entry(cache, key, &cs);
+	if (entry && entry->list == cl_inflight)
+		make_precious(cache, entry);
+	else if (cache_full(cache))
+		return NULL;
+	else if (entry)
+		get_ghost_entry(cache, entry, idx);
+	else
+		entry = get_missed_entry(cache, key);
 
 	++cache->misses.number;
 
@@ -588,20 +634,16 @@ cache_insert(struct cache *cache, struct cache_entry *entry)
 		return;
 
 	idx = entry - cache->ce;
-	if (cache->ninflight--) {
-		if (cache->inflight == idx)
-			cache->inflight = entry->next;
-		remove_entry(cache, entry);
-	}
-	add_entry_after(cache, entry, idx, cache->split);
+	--cache->ninflight;
 
 	switch (entry->state) {
 	case cs_probe:
+		move_entry(cache, entry, idx, cl_probe);
 		++cache->nprobe;
-		cache->split = idx;
 		break;
 
 	case cs_precious:
+		move_entry(cache, entry, idx, cl_prec);
 		++cache->nprec;
 		break;
 
@@ -638,7 +680,7 @@ cache_put_entry(struct cache *cache, struct cache_entry *entry)
 void
 cache_discard(struct cache *cache, struct cache_entry *entry)
 {
-	unsigned n, idx, eprobe;
+	unsigned idx;
 
 	if (--entry->refcnt)
 		return;
@@ -648,21 +690,25 @@ cache_discard(struct cache *cache, struct cache_entry *entry)
 		--cache->nprobetotal;
 
 	idx = entry - cache->ce;
-	if (cache->ninflight--) {
-		if (cache->inflight == idx)
-			cache->inflight = entry->next;
-		remove_entry(cache, entry);
-	}
-
-	n = cache->nprobe + cache->ngprobe;
-	eprobe = cache->split;
-	while (n--)
-		eprobe = cache->ce[eprobe].prev;
+	--cache->ninflight;
+	hash_remove(cache, idx);
+	move_entry(cache, entry, idx, cl_unused);
+}
 
-	if (eprobe == cache->split)
-		cache->split = idx;
+/**  Clean up all entries in a list.
+ *
+ * @param cache  Cache object.
+ * @param list   Cache list.
+ */
+static void
+cleanup_list(struct cache *cache, enum cache_list list)
+{
+	unsigned head = list_head(cache, list);
+	unsigned idx;
 
-	add_entry_after(cache, entry, idx, eprobe);
+	for (idx = cache->ce[head].next; idx != head;
+	     idx = cache->ce[idx].next)
+		cache->entry_cleanup(cache->cleanup_data, &cache->ce[idx]);
 }
 
 /**  Clean up all cache entries.
@@ -674,29 +720,11 @@ cache_discard(struct cache *cache, struct cache_entry *entry)
 static void
 cleanup_entries(struct cache *cache)
 {
-	unsigned n, idx;
-	struct cache_entry *entry;
-
 	if (!cache->entry_cleanup)
 		return;
 
-	/* Clean up precious entries */
-	n = cache->nprec;
-	idx = cache->ce[cache->split].next;
-	while (n--) {
-		entry = &cache->ce[idx];
-		cache->entry_cleanup(cache->cleanup_data, entry);
-		idx = entry->next;
-	}
-
-	/* Clean up probed entries */
-	n = cache->nprobe;
-	idx = cache->split;
-	while (n--) {
-		entry = &cache->ce[idx];
-		cache->entry_cleanup(cache->cleanup_data, entry);
-		idx = entry->prev;
-	}
+	cleanup_list(cache, cl_prec);
+	cleanup_list(cache, cl_probe);
 }
 
 /**  Flush all cache entries.
@@ -711,17 +739,25 @@ cache_flush(struct cache *cache)
 	cleanup_entries(cache);
 
 	n = 2 * cache->cap;
-	for (i = 0; i < n; ++i) {
+	for (i = 0; i < n + NR_CACHE_LISTS; ++i) {
 		struct cache_entry *entry = &cache->ce[i];
-		entry->next = (i > 0) ? (i - 1) : (n - 1);
-		entry->prev = (i < n - 1) ? (i + 1) : 0;
+		entry->next = entry->prev = i;
 		entry->refcnt = 0;
-		entry->data = i < cache->cap
-			? cache->data + i * cache->elemsize
-			: NULL;
+		entry->loading = 0;
+		entry->data = NULL;
 	}
+	for (i = 0; i < n; ++i) {
+		struct cache_entry *entry = &cache->ce[i];
+		add_entry_before(cache, entry, i,
+				 list_head(cache, cl_unused));
+		entry->list = cl_unused;
+		if (i < cache->cap)
+			entry->data = cache->data + i * cache->elemsize;
+	}
+
+	for (i = 0; i < 1U << cache->hbits; ++i)
+		cache->hash[i] = CACHE_NOIDX;
 
-	cache->split = 0;
 	cache->nprec = 0;
 	cache->ngprec = 0;
 	cache->nprobe = 0;
@@ -745,7 +781,7 @@ cache_alloc(unsigned n, size_t size)
 	struct cache *cache;
 
 	cache = malloc(sizeof(struct cache) +
-		       2 * n * sizeof(struct cache_entry));
+		       (2 * n + NR_CACHE_LISTS) * sizeof(struct cache_entry));
 	if (!cache)
 		return cache;
 
@@ -755,9 +791,20 @@ cache_alloc(unsigned n, size_t size)
 	cache->misses.number = 0;
 	cache->entry_cleanup = NULL;
 
+	/* Keep the hash table at most half full. */
+	cache->hbits = 1;
+	while ((1UL << cache->hbits) < 4UL * n)
+		++cache->hbits;
+	cache->hash = malloc(sizeof(unsigned) << cache->hbits);
+	if (!cache->hash) {
+		free(cache);
+		return NULL;
+	}
+
 	if (cache->elemsize) {
 		cache->data = malloc(cache->cap * cache->elemsize);
 		if (!cache->data) {
+			free(cache->hash);
 			free(cache);
 			return NULL;
 		}
@@ -799,6 +846,7 @@ cache_free(struct cache *cache)
 	cleanup_entries(cache);
 	if (cache->data != cache)
 		free(cache->data);
+	free(cache->hash);
 	free(cache);
 }
 
@@ -818,38 +866,428 @@ get_cache_size(kdump_ctx_t *ctx)
 		: DEFAULT_CACHE_SIZE;
 }
 
+/**  Get the configured number of page cache shards.
+ * @param ctx  Dump file object.
+ * @returns    Number of cache shards.
+ *
+ * Get the number of shards from "cache.shards" attribute. If not set,
+ * return @ref DEFAULT_CACHE_SHARDS.
+ */
+unsigned
+get_cache_shards(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_shards);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? attr_value(attr)->number
+		: DEFAULT_CACHE_SHARDS;
+}
+
+/**  Get the configured number of per-context page cache slots.
+ * @param ctx  Dump file object.
+ * @returns    Number of per-context page cache slots.
+ *
+ * Get the number of slots from "cache.l1_size" attribute. If not set,
+ * return @ref DEFAULT_CACHE_L1_SIZE.
+ */
+unsigned
+get_cache_l1_size(kdump_ctx_t *ctx)
+{
+	struct attr_data *attr = gattr(ctx, GKI_cache_l1_size);
+	return attr_isset(attr) && attr_revalidate(ctx, attr) == KDUMP_OK
+		? attr_value(attr)->number
+		: DEFAULT_CACHE_L1_SIZE;
+}
+
+/**  Drop all pages from the per-context page cache.
+ * @param ctx  Dump file object.
+ *
+ * The references to idle shared page cache entries are released, so
+ * this must be called before the page cache shards are retired.
+ * Slots which are still in use are detached; their reference is
+ * dropped by @ref page_l1_put_detached after the last user is gone.
+ */
+void
+page_l1_flush(kdump_ctx_t *ctx)
+{
+	struct page_l1_slot *slot;
+	struct page_l1_detached *d;
+
+	for (slot = ctx->l1; slot < ctx->l1 + ctx->l1size; ++slot) {
+		if (!slot->shard)
+			continue;
+		if (!slot->users)
+			cache_shard_put(slot->shard, slot->ce);
+		else if ((d = malloc(sizeof *d))) {
+			d->key = slot->key;
+			d->shard = slot->shard;
+			d->ce = slot->ce;
+			d->users = slot->users;
+			d->next = ctx->l1_detached;
+			ctx->l1_detached = d;
+		}
+		/* Without memory, the reference is leaked, so pages
+		 * which are still in use are never freed. */
+		slot->shard = NULL;
+		slot->users = 0;
+	}
+}
+
+/**  Drop the reference held by a detached per-context slot.
+ * @param ctx  Dump file object.
+ * @param pd   Link to the detached slot in @c ctx->l1_detached.
+ *
+ * The slot is removed from the list and freed.
+ */
+static void
+page_l1_drop_detached(kdump_ctx_t *ctx, struct page_l1_detached **pd)
+{
+	struct page_l1_detached *d = *pd;
+
+	*pd = d->next;
+	if (get_cache_shard(ctx->shared, d->key) == d->shard)
+		cache_shard_put(d->shard, d->ce);
+	else
+		put_retired_entry(ctx->shared, d->shard->cache, d->ce);
+	free(d);
+}
+
+/**  Put a page from a detached per-context slot.
+ * @param ctx  Dump file object.
+ * @param ce   Cache entry of the page.
+ * @returns    Non-zero if @p ce was found in a detached slot.
+ */
+int
+page_l1_put_detached(kdump_ctx_t *ctx, struct cache_entry *ce)
+{
+	struct page_l1_detached **pd, *d;
+
+	for (pd = &ctx->l1_detached; (d = *pd); pd = &d->next) {
+		if (d->ce != ce)
+			continue;
+		if (!--d->users)
+			page_l1_drop_detached(ctx, pd);
+		return 1;
+	}
+	return 0;
+}
+
+/**  Free the per-context page cache.
+ * @param ctx  Dump file object.
+ *
+ * All references to shared page cache entries are dropped, including
+ * those held for pages which have not been put yet.
+ */
+void
+page_l1_free(kdump_ctx_t *ctx)
+{
+	page_l1_flush(ctx);
+	while (ctx->l1_detached)
+		page_l1_drop_detached(ctx, &ctx->l1_detached);
+	free(ctx->l1);
+	ctx->l1 = NULL;
+	ctx->l1size = 0;
+}
+
+/**  Drop all pages from the page cache of all dump file objects.
+ * @param shared  Dump file shared data.
+ *
+ * The shared data must be locked for writing by the caller.
+ */
+void
+flush_all_page_l1(struct kdump_shared *shared)
+{
+	kdump_ctx_t *ctx;
+
+	list_for_each_entry(ctx, &shared->ctx, list)
+		page_l1_flush(ctx);
+}
+
+/**  Resize the per-context page cache.
+ * @param ctx   Dump file object.
+ * @param size  New number of slots.
+ * @returns     Zero on success, -1 on allocation failure.
+ *
+ * All pages are dropped from the per-context page cache, even if its
+ * size does not change.
+ */
+int
+page_l1_resize(kdump_ctx_t *ctx, unsigned size)
+{
+	struct page_l1_slot *l1;
+
+	page_l1_flush(ctx);
+	if (size == ctx->l1size)
+		return 0;
+
+	l1 = NULL;
+	if (size && !(l1 = calloc(size, sizeof *l1)))
+		return -1;
+
+	free(ctx->l1);
+	ctx->l1 = l1;
+	ctx->l1size = size;
+	return 0;
+}
+
+/**  Drop a reference to a page cache entry.
+ * @param shard  Page cache shard.
+ * @param entry  Cache entry.
+ *
+ * Threads which are waiting for the shard are woken up.
+ */
+void
+cache_shard_put(struct cache_shard *shard, struct cache_entry *entry)
+{
+	mutex_lock(&shard->lock);
+	cache_put_entry(shard->cache, entry);
+	cache_shard_wake(shard);
+	mutex_unlock(&shard->lock);
+}
+
+/**  Free page cache shards.
+ * @param shards  Array of cache shards.
+ * @param n       Number of elements in @p shards.
+ */
+void
+free_cache_shards(struct cache_shard *shards, unsigned n)
+{
+	unsigned i;
+
+	for (i = 0; i < n; ++i) {
+		cond_destroy(&shards[i].cond);
+		mutex_destroy(&shards[i].lock);
+		cache_free(shards[i].cache);
+	}
+	free(shards);
+}
+
+/**  Page cache shards which were replaced while still in use.
+ */
+struct retired_shards {
+	struct retired_shards *next; /**< Next retired shard array. */
+	struct cache_shard *shards;  /**< Array of cache shards. */
+	unsigned n;		     /**< Number of elements in @c shards. */
+	unsigned long nref;	     /**< Remaining entry references. */
+};
+
+/**  Count references to all entries in a cache.
+ * @param cache  Cache object.
+ * @returns      Sum of reference counts of all cache entries.
+ */
+static unsigned long
+cache_nref(const struct cache *cache)
+{
+	unsigned long nref = 0;
+	unsigned i;
+
+	for (i = 0; i < 2 * cache->cap; ++i)
+		nref += cache->ce[i].refcnt;
+	return nref;
+}
+
+/**  Retire the page cache shards.
+ * @param shared  Dump file shared data.
+ *
+ * Drop all pages from the per-context page caches and remove the
+ * page cache shards from @p shared. If any page is still in use,
+ * the shards are kept until the last reference is dropped with
+ * @ref put_retired_entry. Otherwise, they are freed immediately.
+ *
+ * The shared data must be locked for writing by the caller.
+ */
+void
+retire_cache_shards(struct kdump_shared *shared)
+{
+	struct retired_shards *rs;
+	unsigned long nref;
+	unsigned i;
+
+	flush_all_page_l1(shared);
+
+	nref = 0;
+	for (i = 0; i < shared->ncache; ++i)
+		nref += cache_nref(shared->cache[i].cache);
+
+	if (!nref)
+		free_cache_shards(shared->cache, shared->ncache);
+	else if ((rs = malloc(sizeof *rs))) {
+		rs->shards = shared->cache;
+		rs->n = shared->ncache;
+		rs->nref = nref;
+		mutex_lock(&shared->cache_lock);
+		rs->next = shared->retired;
+		shared->retired = rs;
+		mutex_unlock(&shared->cache_lock);
+	}
+	/* Without memory, the shards are leaked, so pages which are
+	 * still in use are never freed. */
+
+	shared->cache = NULL;
+	shared->ncache = 0;
+}
+
+/**  Drop a reference to an entry in retired page cache shards.
+ * @param shared  Dump file shared data.
+ * @param cache   Cache object.
+ * @param entry   Cache entry.
+ * @returns       Non-zero if @p cache belongs to retired shards.
+ *
+ * The retired shards are freed when their last reference is dropped.
+ */
+int
+put_retired_entry(struct kdump_shared *shared, struct cache *cache,
+		  struct cache_entry *entry)
+{
+	struct retired_shards *rs, **prev;
+	unsigned i;
+
+	mutex_lock(&shared->cache_lock);
+	for (prev = &shared->retired; (rs = *prev); prev = &rs->next)
+		for (i = 0; i < rs->n; ++i)
+			if (rs->shards[i].cache == cache)
+				goto found;
+	mutex_unlock(&shared->cache_lock);
+	return 0;
+
+ found:
+	cache_put_entry(cache, entry);
+	if (!--rs->nref) {
+		*prev = rs->next;
+		free_cache_shards(rs->shards, rs->n);
+		free(rs);
+	}
+	mutex_unlock(&shared->cache_lock);
+	return 1;
+}
+
+/**  Free all retired page cache shards.
+ * @param shared  Dump file shared data.
+ *
+ * This is called when the shared data is freed, so any remaining
+ * references are stale.
+ */
+void
+free_retired_shards(struct kdump_shared *shared)
+{
+	struct retired_shards *rs;
+
+	while ((rs = shared->retired)) {
+		shared->retired = rs->next;
+		free_cache_shards(rs->shards, rs->n);
+		free(rs);
+	}
+}
+
 /**  Re-allocate a cache with default parameters.
  * @param ctx  Dump file object.
  * @returns    Error status.
  *
  * This function can be used as the @c realloc_caches method if
  * the cache is organized as @c cache.size elements of @c arch.page_size
- * bytes each.
+ * bytes each. The elements are split evenly among @c cache.shards
+ * page cache shards. The first shards get one more element if the
+ * size is not a multiple of the number of shards. There are never
+ * more shards than elements (unless the cache size is zero).
  */
 kdump_status
 def_realloc_caches(kdump_ctx_t *ctx)
 {
 	unsigned cache_size = get_cache_size(ctx);
-	struct cache *cache;
+	unsigned nshards = get_cache_shards(ctx);
+	unsigned shard_size, i;
+	struct cache_shard *shards;
 
-	cache = cache_alloc(cache_size, get_page_size(ctx));
-	if (!cache)
-		return set_error(ctx, KDUMP_ERR_SYSTEM,
-				 "Cannot allocate cache (%u * %zu bytes)",
-				 cache_size, get_page_size(ctx));
+	if (nshards > cache_size)
+		nshards = cache_size ? cache_size : 1;
 
-	set_attr(ctx, gattr(ctx, GKI_cache_hits),
-		 ATTR_INDIRECT, &cache->hits);
-	set_attr(ctx, gattr(ctx, GKI_cache_misses),
-		 ATTR_INDIRECT, &cache->misses);
+	shards = calloc(nshards, sizeof *shards);
+	if (!shards)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate %u cache shards", nshards);
+
+	for (i = 0; i < nshards; ++i) {
+		shard_size = cache_size / nshards + (i < cache_size % nshards);
+		shards[i].cache = cache_alloc(shard_size, get_page_size(ctx));
+		if (!shards[i].cache) {
+			free_cache_shards(shards, i);
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot allocate cache (%u * %zu bytes)",
+					 shard_size, get_page_size(ctx));
+		}
+		if (mutex_init(&shards[i].lock, NULL)) {
+			cache_free(shards[i].cache);
+			free_cache_shards(shards, i);
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot initialize cache lock");
+		}
+		if (cond_init(&shards[i].cond, NULL)) {
+			mutex_destroy(&shards[i].lock);
+			cache_free(shards[i].cache);
+			free_cache_shards(shards, i);
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot initialize cache condition");
+		}
+	}
 
 	if (ctx->shared->cache)
-		cache_free(ctx->shared->cache);
-	ctx->shared->cache = cache;
+		retire_cache_shards(ctx->shared);
+	ctx->shared->cache = shards;
+	ctx->shared->ncache = nshards;
+
+	set_attr_number(ctx, gattr(ctx, GKI_cache_hits), ATTR_INVALID, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_cache_misses), ATTR_INVALID, 0);
 
 	return KDUMP_OK;
 }
 
+/**  Sum up a cache statistics counter over all page cache shards.
+ * @param ctx   Dump file object.
+ * @param attr  Statistics attribute.
+ * @param off   Offset of the counter in @c struct cache.
+ * @returns     Error status.
+ *
+ * The attribute is left invalid, so it is summed up again every time
+ * its value is requested.
+ */
+static kdump_status
+cache_stat_revalidate(kdump_ctx_t *ctx, struct attr_data *attr, size_t off)
+{
+	struct kdump_shared *shared = ctx->shared;
+	kdump_attr_value_t val;
+	unsigned i;
+
+	val.number = 0;
+	for (i = 0; i < shared->ncache; ++i) {
+		struct cache_shard *shard = &shared->cache[i];
+		mutex_lock(&shard->lock);
+		val.number += ((kdump_attr_value_t *)
+			       ((char *)shard->cache + off))->number;
+		mutex_unlock(&shard->lock);
+	}
+	return set_attr(ctx, attr, ATTR_INVALID, &val);
+}
+
+static kdump_status
+cache_hits_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return cache_stat_revalidate(ctx, attr, offsetof(struct cache, hits));
+}
+
+const struct attr_ops cache_hits_ops = {
+	.revalidate = cache_hits_revalidate,
+};
+
+static kdump_status
+cache_misses_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return cache_stat_revalidate(ctx, attr,
+				     offsetof(struct cache, misses));
+}
+
+const struct attr_ops cache_misses_ops = {
+	.revalidate = cache_misses_revalidate,
+};
+
 static kdump_status
 cache_size_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
 		    kdump_attr_value_t *val)
@@ -872,3 +1310,42 @@ const struct attr_ops cache_size_ops = {
 	.pre_set = cache_size_pre_hook,
 	.post_set = cache_size_post_hook,
 };
+
+static kdump_status
+cache_shards_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+		      kdump_attr_value_t *val)
+{
+	if (val->number == 0)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Number of cache shards must be positive");
+	if (val->number > UINT_MAX)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Too many cache shards (max %u)", UINT_MAX);
+	return KDUMP_OK;
+}
+
+const struct attr_ops cache_shards_ops = {
+	.pre_set = cache_shards_pre_hook,
+	.post_set = cache_size_post_hook,
+};
+
+static kdump_status
+cache_l1_size_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	unsigned size = attr_value(attr)->number;
+	kdump_ctx_t *other;
+
+	/* Resize all contexts which share this attribute. */
+	list_for_each_entry(other, &ctx->shared->ctx, list)
+		if (other->dict == ctx->dict && !other->ra.worker &&
+		    page_l1_resize(other, size))
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot allocate %u page cache slots",
+					 size);
+	return KDUMP_OK;
+}
+
+const struct attr_ops cache_l1_size_ops = {
+	.pre_set = cache_size_pre_hook,
+	.post_set = cache_l1_size_post_hook,
+};
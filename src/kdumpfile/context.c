@@ -99,6 +99,7 @@ alloc_shared(void)
 void
 shared_free(struct kdump_shared *shared)
 {
+	readahead_stop(shared);
 	rwlock_unlock(&shared->lock);
 
 	if (shared->ops && shared->ops->cleanup)
@@ -106,7 +107,8 @@ shared_free(struct kdump_shared *shared)
 	if (shared->arch_ops && shared->arch_ops->cleanup)
 		shared->arch_ops->cleanup(shared);
 	if (shared->cache)
-		cache_free(shared->cache);
+		free_cache_shards(shared->cache, shared->ncache);
+	free_retired_shards(shared);
 	if (shared->fcache)
 		fcache_decref(shared->fcache);
 	mutex_destroy(&shared->cache_lock);
@@ -151,6 +153,7 @@ shared_decref(struct kdump_shared *shared)
 kdump_ctx_t *
 kdump_new(void)
 {
+	struct attr_flags statflags;
 	kdump_ctx_t *ctx;
 
 	ctx = alloc_ctx();
@@ -173,6 +176,13 @@ kdump_new(void)
 
 	set_attr_number(ctx, gattr(ctx, GKI_cache_size),
 			ATTR_PERSIST, DEFAULT_CACHE_SIZE);
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_tlb_size),
+			ATTR_PERSIST, ADDRXLAT_TLB_DEFAULT_SIZE);
+
+	statflags = ATTR_PERSIST;
+	statflags.invalid = 1;
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_tlb_hits), statflags, 0);
+	set_attr_number(ctx, gattr(ctx, GKI_xlat_tlb_misses), statflags, 0);
 
 	return ctx;
 
@@ -204,8 +214,16 @@ clone_xlat_attrs(kdump_ctx_t *dest, const kdump_ctx_t *orig)
 	return true;
 }
 
+/**  Clone a dump file object.
+ * @param orig   Dump file object to be cloned.
+ * @param flags  What should be private to the clone.
+ * @returns      The new dump file object, or @c NULL on failure.
+ *
+ * This is the internal version of @ref kdump_clone. The caller must
+ * hold the shared lock for writing.
+ */
 kdump_ctx_t *
-kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
+clone_locked(const kdump_ctx_t *orig, unsigned long flags)
 {
 	kdump_ctx_t *ctx;
 	int slot;
@@ -214,23 +232,18 @@ kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
 	if (!ctx)
 		return ctx;
 
-	rwlock_rdlock(&orig->shared->lock);
 	for (slot = 0; slot < PER_CTX_SLOTS; ++slot) {
 		size_t sz = orig->shared->per_ctx_size[slot];
 		if (!sz)
 			continue;
-		if (! (ctx->data[slot] = malloc(sz)) ) {
-			while (slot-- > 0)
-				if (orig->shared->per_ctx_size[slot])
-					free(ctx->data[slot]);
-			addrxlat_ctx_decref(ctx->xlatctx);
-			free(ctx);
-			return NULL;
-		}
+		if (! (ctx->data[slot] = calloc(1, sz)) )
+			goto err_data;
 	}
-	rwlock_unlock(&orig->shared->lock);
+	if (page_l1_resize(ctx, orig->l1size))
+		goto err_l1;
+	addrxlat_ctx_set_tlb_size(ctx->xlatctx,
+				  addrxlat_ctx_get_tlb_size(orig->xlatctx));
 
-	rwlock_wrlock(&orig->shared->lock);
 	ctx->shared = orig->shared;
 	shared_incref_locked(ctx->shared);
 	list_add(&ctx->list, &orig->shared->ctx);
@@ -256,8 +269,6 @@ kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
 	}
 	list_add(&ctx->xlat_list, &ctx->xlat->ctx);
 
-	rwlock_unlock(&orig->shared->lock);
-
 	return ctx;
 
  err_xlat:
@@ -267,11 +278,33 @@ kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
  err_shared:
 	list_del(&ctx->list);
 	shared_decref_locked(ctx->shared);
-	rwlock_unlock(&orig->shared->lock);
+	free(ctx->l1);
+	slot = PER_CTX_SLOTS;
+	goto err_data;
+
+ err_l1:
+	slot = PER_CTX_SLOTS;
+ err_data:
+	while (slot-- > 0)
+		if (orig->shared->per_ctx_size[slot])
+			per_ctx_release(orig->shared, ctx, slot);
+	addrxlat_ctx_decref(ctx->xlatctx);
+	err_cleanup(&ctx->err);
 	free(ctx);
 	return NULL;
 }
 
+kdump_ctx_t *
+kdump_clone(const kdump_ctx_t *orig, unsigned long flags)
+{
+	kdump_ctx_t *ctx;
+
+	rwlock_wrlock(&orig->shared->lock);
+	ctx = clone_locked(orig, flags);
+	rwlock_unlock(&orig->shared->lock);
+	return ctx;
+}
+
 const char *
 kdump_get_err(kdump_ctx_t *ctx)
 {
@@ -315,6 +348,9 @@ kdump_get_addrxlat(kdump_ctx_t *ctx,
  * @param sz      Size of per-context data.
  * @returns       Per-context slot number, or -1 on error.
  *
+ * The data is zero-initialized in every context, including contexts
+ * which are cloned later. No cleanup function is set for the new slot.
+ *
  * On error, @c errno is set to:
  * - @c EAGAIN  All slots are already in use.
  * - @c ENOMEM  Memory allocation failure.
@@ -334,10 +370,11 @@ per_ctx_alloc(struct kdump_shared *shared, size_t sz)
 		return -1;
 	}
 	shared->per_ctx_size[slot] = sz;
+	shared->per_ctx_cleanup[slot] = NULL;
 
 	/* Allocate memory. */
 	list_for_each_entry(ctx, &shared->ctx, list)
-		if (! (ctx->data[slot] = malloc(sz)) ) {
+		if (! (ctx->data[slot] = calloc(1, sz)) ) {
 			while (ctx->list.prev != &shared->ctx) {
 				ctx = list_entry(ctx->list.prev,
 						 kdump_ctx_t, list);
@@ -360,8 +397,24 @@ per_ctx_free(struct kdump_shared *shared, int slot)
 	kdump_ctx_t *ctx;
 
 	list_for_each_entry(ctx, &shared->ctx, list)
-		free(ctx->data[slot]);
+		per_ctx_release(shared, ctx, slot);
 	shared->per_ctx_size[slot] = 0;
+	shared->per_ctx_cleanup[slot] = NULL;
+}
+
+/**  Release per-context data of a single context.
+ * @param shared  Dump file shared data.
+ * @param ctx     Dump file object.
+ * @param slot    Per-context slot number.
+ *
+ * Call the cleanup function of the slot (if any) and free the data.
+ */
+void
+per_ctx_release(struct kdump_shared *shared, kdump_ctx_t *ctx, int slot)
+{
+	if (shared->per_ctx_cleanup[slot])
+		shared->per_ctx_cleanup[slot](ctx->data[slot]);
+	free(ctx->data[slot]);
 }
 
 const char *
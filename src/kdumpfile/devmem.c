@@ -396,6 +396,15 @@ devmem_probe(kdump_ctx_t *ctx)
 
 	set_addrspace_caps(ctx->xlat, ADDRXLAT_CAPS(ADDRXLAT_KPHYSADDR));
 
+	/* Page tables of a running system may change at any time,
+	 * so cached translations (and page table entries) go stale.
+	 */
+	ret = set_attr_number(ctx, gattr(ctx, GKI_xlat_tlb_size),
+			      ATTR_DEFAULT, 0);
+	if (ret != KDUMP_OK)
+		return set_error(ctx, ret,
+				 "Cannot disable translation lookaside buffer");
+
 #if defined(__x86_64__)
 	ret = set_arch_name(ctx, KDUMP_ARCH_X86_64);
 #elif defined(__i386__)
@@ -42,6 +42,9 @@
 #if USE_SNAPPY
 # include <snappy-c.h>
 #endif
+#if USE_ZSTD
+# include <zstd.h>
+#endif
 
 #define SIG_LEN	8
 
@@ -149,29 +152,63 @@ struct page_desc {
 	uint64_t	page_flags;	/**< Page flags. */
 };
 
+/** Decoded page descriptor. */
+struct pd_entry {
+	uint64_t	offset;		/**< File offset of page data. */
+	uint32_t	size;		/**< Size of this dump page. */
+	uint32_t	flags;		/**< Flags. */
+};
+
 /** PFN region mapping. */
 struct pfn_rgn {
 	kdump_pfn_t pfn;	/**< Starting PFN. */
 	kdump_pfn_t cnt;	/**< Number of pages in this region. */
-	off_t pos;		/**< File position of the first descriptor. */
+	kdump_pfn_t idx;	/**< Index of the first descriptor. */
 };
 
-/** Region mapping allocation increment.
- * For optimal performance, this should be a power of two.
+/** Maximum size of a page bitmap chunk.
+ * The bitmap is read and converted to PFN regions in chunks of this
+ * size, or of the file cache mmap window if that is smaller. Both are
+ * powers of two, and chunks are aligned to their size in the file, so
+ * each of them can be mapped with a single file cache entry.
  */
-#define RGN_ALLOC_INC	1024
+#define BITMAP_CHUNK_MAX	((size_t)4 << 20)
+
+/** Maximum number of threads used to convert the page bitmap. */
+#define BITMAP_THREADS	8
+
+/** Log2 of the number of page descriptors in a descriptor block. */
+#define PD_BLOCK_SHIFT	8
+
+/** Number of page descriptors in a descriptor block. */
+#define PD_BLOCK_SIZE	((kdump_pfn_t)1 << PD_BLOCK_SHIFT)
+
+/** Number of decoded descriptor blocks kept in memory. */
+#define PD_CACHE_BLOCKS	256
 
 struct disk_dump_priv {
 	struct pfn_rgn *pfn_rgn; /**< PFN region map. */
 	size_t pfn_rgn_num;	 /**< Number of elements in the map. */
 
+	off_t pd_off;		/**< File offset of the descriptor table. */
+	kdump_pfn_t pd_num;	/**< Number of page descriptors. */
+
+	/** Decoded descriptor blocks, allocated on first use. */
+	struct cache *pd_cache;
+	mutex_t pd_mutex;	/**< Protects @c pd_cache. */
+	cond_t pd_cond;		/**< Signalled when a block load ends. */
+	unsigned pd_nwait;	/**< Number of threads waiting for a load. */
+
 	/** Overridden methods for arch.page_size attribute. */
 	struct attr_override page_size_override;
 	int cbuf_slot;		/**< Compressed data per-context slot. */
+	int zlib_slot;		/**< Per-context zlib stream slot. */
+	int zstd_slot;		/**< Per-context zstd context slot. */
 };
 
 struct setup_data {
 	kdump_ctx_t *ctx;
+	uint32_t status;
 	off_t note_off;
 	size_t note_sz;
 };
@@ -180,38 +217,146 @@ struct setup_data {
 #define DUMP_DH_COMPRESSED_ZLIB	0x1	/* page is compressed with zlib */
 #define DUMP_DH_COMPRESSED_LZO	0x2	/* page is compressed with lzo */
 #define DUMP_DH_COMPRESSED_SNAPPY 0x4	/* page is compressed with snappy */
+#define DUMP_DH_COMPRESSED_ZSTD	0x20	/* page is compressed with zstd */
 
 /* Any compression flag */
 #define DUMP_DH_COMPRESSED	( 0	\
 	| DUMP_DH_COMPRESSED_ZLIB	\
 	| DUMP_DH_COMPRESSED_LZO	\
 	| DUMP_DH_COMPRESSED_SNAPPY	\
+	| DUMP_DH_COMPRESSED_ZSTD	\
 		)
 
 static void diskdump_cleanup(struct kdump_shared *shared);
 
-/** Add a new PFN region.
+/** Page bitmap chunk conversion data. */
+struct rgn_chunk {
+	const unsigned char *bitmap; /**< Bitmap data. */
+	size_t size;		/**< Size of the bitmap chunk in bytes. */
+	kdump_pfn_t pfn;	/**< PFN of the first bit in the chunk. */
+	struct pfn_rgn *rgn;	/**< PFN regions found in the chunk. */
+	size_t num;		/**< Number of elements in @c rgn. */
+	bool nomem;		/**< Set if @c rgn cannot be allocated. */
+	struct fcache_chunk fch; /**< File cache chunk with the data. */
+};
+
+/** Convert a page bitmap chunk to PFN regions.
+ * @param arg  Bitmap chunk (@c struct rgn_chunk).
+ * @returns    Always @c NULL.
+ *
+ * The bitmap is scanned twice: first to count the regions, then to
+ * store them in an array of exactly the right size. Region indices
+ * are left unset and must be assigned by the caller.
+ */
+static void *
+bitmap_chunk_rgn(void *arg)
+{
+	struct rgn_chunk *rc = arg;
+	struct pfn_rgn *rgn;
+	size_t nbits = rc->size * 8;
+	size_t idx, next;
+
+	rc->num = 0;
+	idx = 0;
+	while ((idx = skip_clear_bits(rc->bitmap, rc->size, idx)) < nbits) {
+		idx = skip_set_bits(rc->bitmap, rc->size, idx);
+		++rc->num;
+	}
+	if (!rc->num)
+		return NULL;
+
+	rc->rgn = malloc(rc->num * sizeof(struct pfn_rgn));
+	if (!rc->rgn) {
+		rc->nomem = true;
+		return NULL;
+	}
+
+	rgn = rc->rgn;
+	idx = 0;
+	while ((idx = skip_clear_bits(rc->bitmap, rc->size, idx)) < nbits) {
+		next = skip_set_bits(rc->bitmap, rc->size, idx);
+		rgn->pfn = rc->pfn + idx;
+		rgn->cnt = next - idx;
+		++rgn;
+		idx = next;
+	}
+	return NULL;
+}
+
+/** Convert page bitmap chunks to PFN regions.
+ * @param rc  Array of bitmap chunks.
+ * @param n   Number of elements in @c rc.
+ *
+ * The first chunk is converted by the calling thread; all other
+ * chunks are converted in parallel by new threads if possible.
+ */
+static void
+convert_bitmap_chunks(struct rgn_chunk *rc, unsigned n)
+{
+	thread_t tid[BITMAP_THREADS];
+	bool started[BITMAP_THREADS];
+	unsigned i;
+
+	for (i = 1; i < n; ++i)
+		started[i] = !thread_create(&tid[i], bitmap_chunk_rgn, &rc[i]);
+	bitmap_chunk_rgn(&rc[0]);
+	for (i = 1; i < n; ++i) {
+		if (started[i])
+			thread_join(tid[i], NULL);
+		else
+			bitmap_chunk_rgn(&rc[i]);
+	}
+}
+
+/** Append the PFN regions of a bitmap chunk.
  * @param ctx  Dump file context.
- * @param rgn  PFN region.
+ * @param rc   Converted bitmap chunk.
  * @returns    Error status.
+ *
+ * The region map is grown by exactly the number of regions in the
+ * chunk. A region which continues from the previous chunk is merged
+ * with the last region in the map.
  */
 static kdump_status
-add_pfn_rgn(kdump_ctx_t *ctx, const struct pfn_rgn *rgn)
+add_pfn_rgns(kdump_ctx_t *ctx, const struct rgn_chunk *rc)
 {
 	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
+	const struct pfn_rgn *src, *end;
+	struct pfn_rgn *last, *rgn;
+	size_t num;
 
-	if (ddp->pfn_rgn_num % RGN_ALLOC_INC == 0) {
-		size_t num = ddp->pfn_rgn_num + RGN_ALLOC_INC;
-		struct pfn_rgn *rgn =
-			realloc(ddp->pfn_rgn, num * sizeof(struct pfn_rgn));
-		if (!rgn)
-			return set_error(ctx, KDUMP_ERR_SYSTEM,
-					 "Cannot allocate space for"
-					 " %zu PFN region mappings", num);
-		ddp->pfn_rgn = rgn;
-	}
+	if (rc->nomem)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate space for"
+				 " %zu PFN region mappings", rc->num);
+	if (!rc->num)
+		return KDUMP_OK;
 
-	ddp->pfn_rgn[ddp->pfn_rgn_num++] = *rgn;
+	num = ddp->pfn_rgn_num + rc->num;
+	rgn = realloc(ddp->pfn_rgn, num * sizeof(struct pfn_rgn));
+	if (!rgn)
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot allocate space for"
+				 " %zu PFN region mappings", num);
+	ddp->pfn_rgn = rgn;
+
+	src = rc->rgn;
+	end = src + rc->num;
+	last = ddp->pfn_rgn_num
+		? &ddp->pfn_rgn[ddp->pfn_rgn_num - 1]
+		: NULL;
+	if (last && last->pfn + last->cnt == src->pfn) {
+		last->cnt += src->cnt;
+		++src;
+	}
+	while (src < end) {
+		rgn = &ddp->pfn_rgn[ddp->pfn_rgn_num++];
+		rgn->pfn = src->pfn;
+		rgn->cnt = src->cnt;
+		rgn->idx = last ? last->idx + last->cnt : 0;
+		last = rgn;
+		++src;
+	}
 	return KDUMP_OK;
 }
 
@@ -240,13 +385,128 @@ find_pfn_rgn(struct disk_dump_priv *ddp, kdump_pfn_t pfn)
 		: NULL;
 }
 
-static off_t
-pfn_to_pdpos(struct disk_dump_priv *ddp, unsigned long pfn)
+static kdump_pfn_t
+pfn_to_pdidx(struct disk_dump_priv *ddp, kdump_pfn_t pfn)
 {
 	const struct pfn_rgn *rgn = find_pfn_rgn(ddp, pfn);
 	return rgn && pfn >= rgn->pfn
-		? rgn->pos + (pfn - rgn->pfn) * sizeof(struct page_desc)
-		: (off_t) -1;
+		? rgn->idx + (pfn - rgn->pfn)
+		: (kdump_pfn_t) -1;
+}
+
+/** Read and decode a block of page descriptors.
+ * @param ctx    Dump file object.
+ * @param blk    Block number.
+ * @param block  Buffer for @ref PD_BLOCK_SIZE decoded descriptors.
+ * @returns      Error status.
+ */
+static kdump_status
+read_pd_block(kdump_ctx_t *ctx, kdump_pfn_t blk, struct pd_entry *block)
+{
+	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
+	kdump_pfn_t first = blk << PD_BLOCK_SHIFT;
+	const struct page_desc *pd;
+	struct fcache_chunk fch;
+	kdump_status ret;
+	size_t i, num;
+	off_t pos;
+
+	num = ddp->pd_num - first < PD_BLOCK_SIZE
+		? ddp->pd_num - first
+		: PD_BLOCK_SIZE;
+	pos = ddp->pd_off + first * sizeof(struct page_desc);
+
+	mutex_lock(&ctx->shared->cache_lock);
+	ret = fcache_get_chunk(ctx->shared->fcache, &fch,
+			       num * sizeof(struct page_desc), pos);
+	if (ret != KDUMP_OK) {
+		mutex_unlock(&ctx->shared->cache_lock);
+		return set_error(ctx, ret,
+				 "Cannot read page descriptors at %llu",
+				 (unsigned long long) pos);
+	}
+
+	pd = (const struct page_desc *) fch.data;
+	for (i = 0; i < num; ++i, ++pd) {
+		block[i].offset = dump64toh(ctx, pd->offset);
+		block[i].size = dump32toh(ctx, pd->size);
+		block[i].flags = dump32toh(ctx, pd->flags);
+	}
+
+	fcache_put_chunk(&fch);
+	mutex_unlock(&ctx->shared->cache_lock);
+	return KDUMP_OK;
+}
+
+/** Get a decoded page descriptor.
+ * @param ctx  Dump file object.
+ * @param idx  Descriptor index.
+ * @param pd   Page descriptor, filled in on success.
+ * @returns    Error status.
+ *
+ * Descriptors are decoded in blocks of @ref PD_BLOCK_SIZE entries,
+ * and the most recently used blocks are kept in a small cache.
+ * A block is read without holding @c pd_mutex; other threads which
+ * need the same block wait until the read is finished.
+ */
+static kdump_status
+get_page_desc(kdump_ctx_t *ctx, kdump_pfn_t idx, struct pd_entry *pd)
+{
+	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
+	struct cache_entry *entry;
+	struct pd_entry *block;
+	kdump_status ret;
+
+	mutex_lock(&ddp->pd_mutex);
+
+	if (!ddp->pd_cache) {
+		ddp->pd_cache = cache_alloc(
+			PD_CACHE_BLOCKS, PD_BLOCK_SIZE * sizeof(struct pd_entry));
+		if (!ddp->pd_cache) {
+			mutex_unlock(&ddp->pd_mutex);
+			return set_error(ctx, KDUMP_ERR_SYSTEM,
+					 "Cannot allocate page descriptor cache");
+		}
+	}
+
+	entry = cache_get_entry(ddp->pd_cache, idx >> PD_BLOCK_SHIFT);
+	if (!entry) {
+		mutex_unlock(&ddp->pd_mutex);
+		return set_error(ctx, KDUMP_ERR_BUSY,
+				 "Page descriptor cache is full");
+	}
+
+	/* Wait for another thread which is reading the same block. */
+	while (!cache_entry_valid(entry) && entry->loading) {
+		++ddp->pd_nwait;
+		cond_wait(&ddp->pd_cond, &ddp->pd_mutex);
+		--ddp->pd_nwait;
+	}
+
+	block = entry->data;
+	if (!cache_entry_valid(entry)) {
+		entry->loading = 1;
+		mutex_unlock(&ddp->pd_mutex);
+
+		ret = read_pd_block(ctx, idx >> PD_BLOCK_SHIFT, block);
+
+		mutex_lock(&ddp->pd_mutex);
+		entry->loading = 0;
+		if (ddp->pd_nwait)
+			cond_broadcast(&ddp->pd_cond);
+		if (ret != KDUMP_OK) {
+			cache_discard(ddp->pd_cache, entry);
+			mutex_unlock(&ddp->pd_mutex);
+			return ret;
+		}
+		cache_insert(ddp->pd_cache, entry);
+	}
+
+	*pd = block[idx & (PD_BLOCK_SIZE - 1)];
+	cache_put_entry(ddp->pd_cache, entry);
+
+	mutex_unlock(&ddp->pd_mutex);
+	return KDUMP_OK;
 }
 
 static kdump_status
@@ -344,6 +604,27 @@ diskdump_find_clear(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
 	return KDUMP_OK;
 }
 
+static kdump_status
+diskdump_iter_runs(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
+		   struct bmp_run_state *st)
+{
+	struct kdump_shared *shared = bmp->priv;
+	struct disk_dump_priv *ddp;
+	const struct pfn_rgn *rgn, *end;
+
+	rwlock_rdlock(&shared->lock);
+	ddp = shared->fmtdata;
+	rgn = find_pfn_rgn(ddp, st->first);
+	if (rgn) {
+		end = ddp->pfn_rgn + ddp->pfn_rgn_num;
+		while (rgn < end &&
+		       !bmp_run_add(st, rgn->pfn, rgn->pfn + rgn->cnt - 1))
+			++rgn;
+	}
+	rwlock_unlock(&shared->lock);
+	return KDUMP_OK;
+}
+
 static void
 diskdump_bmp_cleanup(const kdump_bmp_t *bmp)
 {
@@ -355,6 +636,7 @@ static const struct kdump_bmp_ops diskdump_bmp_ops = {
 	.get_bits = diskdump_get_bits,
 	.find_set = diskdump_find_set,
 	.find_clear = diskdump_find_clear,
+	.iter_runs = diskdump_iter_runs,
 	.cleanup = diskdump_bmp_cleanup,
 };
 
@@ -363,8 +645,8 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
 	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
 	kdump_pfn_t pfn;
-	struct page_desc pd;
-	off_t pd_pos;
+	struct pd_entry pd = { };
+	kdump_pfn_t pd_idx;
 	void *buf;
 	kdump_status ret;
 
@@ -372,8 +654,8 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	if (pfn >= get_max_pfn(ctx))
 		return set_error(ctx, KDUMP_ERR_NODATA, "Out-of-bounds PFN");
 
-	pd_pos = pfn_to_pdpos(ddp, pfn);
-	if (pd_pos == (off_t)-1) {
+	pd_idx = pfn_to_pdidx(ddp, pfn);
+	if (pd_idx == (kdump_pfn_t)-1) {
 		if (get_zero_excluded(ctx)) {
 			memset(pio->chunk.data, 0, get_page_size(ctx));
 			return KDUMP_OK;
@@ -381,18 +663,9 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 		return set_error(ctx, KDUMP_ERR_NODATA, "Excluded page");
 	}
 
-	mutex_lock(&ctx->shared->cache_lock);
-	ret = fcache_pread(ctx->shared->fcache, &pd, sizeof pd, pd_pos);
-	mutex_unlock(&ctx->shared->cache_lock);
+	ret = get_page_desc(ctx, pd_idx, &pd);
 	if (ret != KDUMP_OK)
-		return set_error(ctx, ret,
-				 "Cannot read page descriptor at %llu",
-				 (unsigned long long) pd_pos);
-
-	pd.offset = dump64toh(ctx, pd.offset);
-	pd.size = dump32toh(ctx, pd.size);
-	pd.flags = dump32toh(ctx, pd.flags);
-	pd.page_flags = dump64toh(ctx, pd.page_flags);
+		return ret;
 
 	if (pd.flags & DUMP_DH_COMPRESSED) {
 		if (pd.size > MAX_PAGE_SIZE)
@@ -418,7 +691,8 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 				 (unsigned long long) pd.offset);
 
 	if (pd.flags & DUMP_DH_COMPRESSED_ZLIB) {
-		ret = uncompress_page_gzip(ctx, pio->chunk.data, buf, pd.size);
+		ret = uncompress_page_gzip(ctx, ddp->zlib_slot,
+					   pio->chunk.data, buf, pd.size);
 		if (ret != KDUMP_OK)
 			return ret;
 	} else if (pd.flags & DUMP_DH_COMPRESSED_LZO) {
@@ -458,15 +732,65 @@ diskdump_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 		return set_error(ctx, KDUMP_ERR_NOTIMPL,
 				 "Unsupported compression method: %s",
 				 "snappy");
+#endif
+	} else if (pd.flags & DUMP_DH_COMPRESSED_ZSTD) {
+#if USE_ZSTD
+		ZSTD_DCtx *dctx, **pdctx;
+		size_t retlen;
+
+		pdctx = ddp->zstd_slot >= 0
+			? ctx->data[ddp->zstd_slot]
+			: NULL;
+		dctx = pdctx ? *pdctx : NULL;
+		if (!dctx) {
+			dctx = ZSTD_createDCtx();
+			if (!dctx)
+				return set_error(ctx, KDUMP_ERR_SYSTEM,
+						 "Cannot allocate zstd context");
+			if (pdctx)
+				*pdctx = dctx;
+		}
+		retlen = ZSTD_decompressDCtx(dctx, pio->chunk.data,
+					     get_page_size(ctx),
+					     buf, pd.size);
+		if (!pdctx)
+			ZSTD_freeDCtx(dctx);
+		if (ZSTD_isError(retlen))
+			return set_error(ctx, KDUMP_ERR_CORRUPT,
+					 "Decompression failed: %s",
+					 ZSTD_getErrorName(retlen));
+		if (retlen != get_page_size(ctx))
+			return set_error(ctx, KDUMP_ERR_CORRUPT,
+					 "Wrong uncompressed size: %lu",
+					 (unsigned long) retlen);
+#else
+		return set_error(ctx, KDUMP_ERR_NOTIMPL,
+				 "Unsupported compression method: %s",
+				 "zstd");
 #endif
 	}
 
 	return KDUMP_OK;
 }
 
+#if USE_ZSTD
+/**  Free a per-context zstd decompression context.
+ * @param data  Per-context data (pointer to a @c ZSTD_DCtx pointer).
+ */
+static void
+zstd_dctx_cleanup(void *data)
+{
+	ZSTD_DCtx **pdctx = data;
+
+	if (*pdctx)
+		ZSTD_freeDCtx(*pdctx);
+}
+#endif
+
 static kdump_status
 diskdump_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
+	readahead_page(ctx, pio);
 	return cache_get_page(ctx, pio, diskdump_read_page);
 }
 
@@ -554,63 +878,20 @@ read_notes(kdump_ctx_t *ctx, off_t off, size_t size)
 	return ret;
 }
 
-static kdump_pfn_t
-skip_clear(unsigned char *bitmap, size_t size, kdump_pfn_t pfn)
-{
-	unsigned char *bp = bitmap + (pfn >> 3);
-	int lead;
-
-	if (bp >= bitmap + size)
-		return pfn;
-
-	lead = ffs(*bp >> (pfn & 7));
-	if (lead)
-		return pfn + lead - 1;
-
-	pfn = (pfn | 7) + 1;
-	++bp;
-	while (bp < bitmap + size && *bp == 0x00)
-		pfn += 8, ++bp;
-	if (bp < bitmap + size)
-		pfn += ffs(*bp) - 1;
-
-	return pfn;
-}
-
-static kdump_pfn_t
-skip_set(unsigned char *bitmap, size_t size, kdump_pfn_t pfn)
-{
-	unsigned char *bp = bitmap + (pfn >> 3);
-	int lead;
-
-	if (bp >= bitmap + size)
-		return pfn;
-
-	lead = ffs(~((signed char)*bp >> (pfn & 7)));
-	if (lead)
-		return pfn + lead - 1;
-
-	pfn = (pfn | 7) + 1;
-	++bp;
-	while (bp < bitmap + size && *bp == 0xff)
-		pfn += 8, ++bp;
-	if (bp < bitmap + size)
-		pfn += ffs(~(signed char)*bp) - 1;
-
-	return pfn;
-}
-
 static kdump_status
 read_bitmap(kdump_ctx_t *ctx, int32_t sub_hdr_size,
 	    int32_t bitmap_blocks)
 {
+	struct disk_dump_priv *ddp = ctx->shared->fmtdata;
 	off_t off = (1 + sub_hdr_size) * get_page_size(ctx);
 	off_t descoff;
 	size_t bitmapsize;
 	kdump_pfn_t max_bitmap_pfn;
-	kdump_pfn_t pfn;
-	struct pfn_rgn rgn;
-	struct fcache_chunk fch;
+	struct rgn_chunk rc[BITMAP_THREADS];
+	off_t pos, endpos;
+	size_t chunk;
+	unsigned nthreads, n, i;
+	long ncpus;
 	kdump_status ret;
 
 	descoff = off + bitmap_blocks * get_page_size(ctx);
@@ -628,32 +909,67 @@ read_bitmap(kdump_ctx_t *ctx, int32_t sub_hdr_size,
 	if (get_max_pfn(ctx) > max_bitmap_pfn)
 		set_max_pfn(ctx, max_bitmap_pfn);
 
-	ret = fcache_get_chunk(ctx->shared->fcache, &fch, bitmapsize, off);
-	if (ret != KDUMP_OK)
-		return set_error(ctx, ret,
-				 "Cannot read %zu bytes of page bitmap"
-				 " at %llu",
-				 bitmapsize, (unsigned long long) off);
-
-	rgn.pos = descoff;
-	pfn = 0;
-	while (pfn < max_bitmap_pfn) {
-		rgn.pfn = skip_clear(fch.data, bitmapsize, pfn);
-		pfn = skip_set(fch.data, bitmapsize, rgn.pfn);
-		rgn.cnt = pfn - rgn.pfn;
-		if (rgn.cnt) {
-			ret = add_pfn_rgn(ctx, &rgn);
-			if (ret != KDUMP_OK)
-				goto out;
-			rgn.pos += rgn.cnt * sizeof(struct page_desc);
+	ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+	nthreads = (ncpus > BITMAP_THREADS
+		    ? BITMAP_THREADS
+		    : (ncpus > 1 ? ncpus : 1));
+
+	chunk = ctx->shared->fcache->mmapsz;
+	if (chunk > BITMAP_CHUNK_MAX)
+		chunk = BITMAP_CHUNK_MAX;
+
+	ddp->pd_off = descoff;
+	ret = KDUMP_OK;
+	pos = off;
+	endpos = off + bitmapsize;
+	while (ret == KDUMP_OK && pos < endpos) {
+		/* Map the next batch of chunks. */
+		for (n = 0; n < nthreads && pos < endpos; ++n) {
+			size_t size = chunk - pos % chunk;
+			if (size > endpos - pos)
+				size = endpos - pos;
+
+			ret = fcache_get_chunk(ctx->shared->fcache,
+					       &rc[n].fch, size, pos);
+			if (ret != KDUMP_OK) {
+				set_error(ctx, ret,
+					  "Cannot read %zu bytes of page bitmap"
+					  " at %llu",
+					  size, (unsigned long long) pos);
+				break;
+			}
+			rc[n].bitmap = rc[n].fch.data;
+			rc[n].size = size;
+			rc[n].pfn = (kdump_pfn_t)(pos - off) * 8;
+			rc[n].rgn = NULL;
+			rc[n].num = 0;
+			rc[n].nomem = false;
+			pos += size;
+		}
+
+		if (ret == KDUMP_OK)
+			convert_bitmap_chunks(rc, n);
+
+		/* Merge the results in file order. */
+		for (i = 0; i < n; ++i) {
+			if (ret == KDUMP_OK)
+				ret = add_pfn_rgns(ctx, &rc[i]);
+			free(rc[i].rgn);
+			fcache_put_chunk(&rc[i].fch);
 		}
 	}
 
-	ret = KDUMP_OK;
+	if (ret != KDUMP_OK)
+		return ret;
 
- out:
-	fcache_put_chunk(&fch);
-	return ret;
+	if (ddp->pfn_rgn_num) {
+		const struct pfn_rgn *last =
+			&ddp->pfn_rgn[ddp->pfn_rgn_num - 1];
+		ddp->pd_num = last->idx + last->cnt;
+	} else
+		ddp->pd_num = 0;
+
+	return KDUMP_OK;
 }
 
 static kdump_status
@@ -737,6 +1053,7 @@ do_header_32(struct setup_data *sdp, struct disk_dump_header_32 *dh,
 
 	set_byte_order(ctx, byte_order);
 	set_ptr_size(ctx, 4);
+	sdp->status = dump32toh(ctx, dh->status);
 
 	ret = read_sub_hdr_32(sdp, dump32toh(ctx, dh->header_version));
 	if (ret != KDUMP_OK)
@@ -820,6 +1137,7 @@ do_header_64(struct setup_data *sdp, struct disk_dump_header_64 *dh,
 
 	set_byte_order(ctx, byte_order);
 	set_ptr_size(ctx, 8);
+	sdp->status = dump32toh(ctx, dh->status);
 
 	ret = read_sub_hdr_64(sdp, dump32toh(ctx, dh->header_version));
 	if (ret != KDUMP_OK)
@@ -872,10 +1190,31 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 		return set_error(ctx, KDUMP_ERR_SYSTEM,
 				 "Cannot allocate diskdump private data");
 
+	if (mutex_init(&ddp->pd_mutex, NULL)) {
+		free(ddp);
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot initialize diskdump data mutex");
+	}
+	if (cond_init(&ddp->pd_cond, NULL)) {
+		mutex_destroy(&ddp->pd_mutex);
+		free(ddp);
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot initialize diskdump data condition");
+	}
+
 	attr_add_override(gattr(ctx, GKI_page_size),
 			  &ddp->page_size_override);
 	ddp->page_size_override.ops.post_set = diskdump_realloc_compressed;
 	ddp->cbuf_slot = -1;
+	ddp->zlib_slot = -1;
+#if USE_ZSTD
+	ddp->zstd_slot = per_ctx_alloc(ctx->shared, sizeof(ZSTD_DCtx *));
+	if (ddp->zstd_slot >= 0)
+		ctx->shared->per_ctx_cleanup[ddp->zstd_slot] =
+			zstd_dctx_cleanup;
+#else
+	ddp->zstd_slot = -1;
+#endif
 
 	ctx->shared->fmtdata = ddp;
 
@@ -899,6 +1238,14 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 	if (ret != KDUMP_OK)
 		goto err_cleanup;
 
+	/* Dumps written before compression flags were added to the
+	 * header can only contain zlib-compressed pages.
+	 * Failure is not fatal; a temporary stream is used instead.
+	 */
+	if ((sd.status & DUMP_DH_COMPRESSED_ZLIB) ||
+	    !(sd.status & DUMP_DH_COMPRESSED))
+		ddp->zlib_slot = per_ctx_alloc_zlib(ctx->shared);
+
 	bmp = kdump_bmp_new(&diskdump_bmp_ops);
 	if (!bmp) {
 		ret = set_error(ctx, KDUMP_ERR_SYSTEM,
@@ -965,8 +1312,16 @@ diskdump_cleanup(struct kdump_shared *shared)
 	if (ddp) {
 		if (ddp->pfn_rgn)
 			free(ddp->pfn_rgn);
+		if (ddp->pd_cache)
+			cache_free(ddp->pd_cache);
+		cond_destroy(&ddp->pd_cond);
+		mutex_destroy(&ddp->pd_mutex);
 		if (ddp->cbuf_slot >= 0)
 			per_ctx_free(shared, ddp->cbuf_slot);
+		if (ddp->zlib_slot >= 0)
+			per_ctx_free(shared, ddp->zlib_slot);
+		if (ddp->zstd_slot >= 0)
+			per_ctx_free(shared, ddp->zstd_slot);
 		free(ddp);
 		shared->fmtdata = NULL;
 	}
@@ -61,6 +61,19 @@ struct load_segment {
 	kdump_paddr_t phys;
 	kdump_addr_t memsz;
 	kdump_vaddr_t virt;
+
+	/** Highest end address of this and all preceding segments.
+	 * This is the end of @c phys in @c load_sorted and the end
+	 * of @c virt in @c load_vsorted. It is not used elsewhere.
+	 */
+	kdump_addr_t max_end;
+};
+
+/** Per-context cache of the last found LOAD segments.
+ */
+struct load_cache {
+	struct load_segment *load;  /**< Last hit in @c load_sorted. */
+	struct load_segment *vload; /**< Last hit in @c load_vsorted. */
 };
 
 struct section {
@@ -111,11 +124,12 @@ struct elfdump_priv {
 
 	int num_load_sorted;
 	struct load_segment *load_sorted;
-	struct load_segment *last_load;
 
 	int num_load_vsorted;
 	struct load_segment *load_vsorted;
-	struct load_segment  *last_vload;
+
+	/** Per-context slot for @ref load_cache, or -1. */
+	int load_cache_slot;
 
 	int num_note_segments;
 	struct load_segment *note_segments;
@@ -165,64 +179,116 @@ mach2arch(unsigned mach, int elfclass)
 	}
 }
 
+/**  Find the first segment which ends above an address.
+ * @param segs	Sorted LOAD segments.
+ * @param n	Number of elements in @c segs.
+ * @param addr	Requested address.
+ * @returns	Index of the segment, or @c n if none.
+ *
+ * The search uses the @c max_end field, so it works even if some
+ * segments overlap.
+ */
+static int
+find_load_end(const struct load_segment *segs, int n, kdump_addr_t addr)
+{
+	int lo, hi, mid;
+
+	lo = 0;
+	hi = n;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (segs[mid].max_end > addr)
+			hi = mid;
+		else
+			lo = mid + 1;
+	}
+	return lo;
+}
+
 /**  Find the LOAD segment that is closest to a physical address.
  * @param edp	 ELF dump private data.
+ * @param lc	 Last-hit cache (may be @c NULL).
  * @param paddr	 Requested physical address.
  * @param dist	 Maximum allowed distance from @c paddr.
  * @returns	 Pointer to the closest LOAD segment, or @c NULL if none.
  */
 static struct load_segment *
-find_closest_load(struct elfdump_priv *edp, kdump_paddr_t paddr,
-		  unsigned long dist)
+find_closest_load(struct elfdump_priv *edp, struct load_cache *lc,
+		  kdump_paddr_t paddr, unsigned long dist)
 {
+	struct load_segment *pls;
 	int i;
 
-	if (edp->last_load &&
-	    paddr >= edp->last_load->phys &&
-	    paddr < edp->last_load->phys + edp->last_load->memsz)
-		return edp->last_load;
+	if (lc && lc->load &&
+	    paddr >= lc->load->phys &&
+	    paddr < lc->load->phys + lc->load->memsz)
+		return lc->load;
 
-	for (i = 0; i < edp->num_load_sorted; i++) {
-		struct load_segment *pls = &edp->load_sorted[i];
-		if (paddr >= pls->phys + pls->memsz)
-			continue;
-		if (paddr >= pls->phys || pls->phys - paddr < dist)
-			return edp->last_load = pls;
-	}
-	return NULL;
+	i = find_load_end(edp->load_sorted, edp->num_load_sorted, paddr);
+	if (i >= edp->num_load_sorted)
+		return NULL;
+
+	/* All following segments start even further. */
+	pls = &edp->load_sorted[i];
+	if (paddr < pls->phys && pls->phys - paddr >= dist)
+		return NULL;
+
+	if (lc)
+		lc->load = pls;
+	return pls;
 }
 
 /**  Find the LOAD segment that is closest to a virtual address.
  * @param edp	 ELF dump private data.
+ * @param lc	 Last-hit cache (may be @c NULL).
  * @param vaddr	 Requested virtual address.
  * @param dist	 Maximum allowed distance from @c vaddr.
  * @returns	 Pointer to the closest LOAD segment, or @c NULL if none.
  */
 static struct load_segment *
-find_closest_vload(struct elfdump_priv *edp, kdump_vaddr_t vaddr,
-		   unsigned long dist)
+find_closest_vload(struct elfdump_priv *edp, struct load_cache *lc,
+		   kdump_vaddr_t vaddr, unsigned long dist)
 {
+	struct load_segment *pls;
 	int i;
 
-	if (edp->last_vload &&
-	    vaddr >= edp->last_vload->virt &&
-	    vaddr < edp->last_vload->virt + edp->last_vload->memsz)
-		return edp->last_vload;
+	if (lc && lc->vload &&
+	    vaddr >= lc->vload->virt &&
+	    vaddr < lc->vload->virt + lc->vload->memsz)
+		return lc->vload;
 
-	for (i = 0; i < edp->num_load_vsorted; i++) {
-		struct load_segment *pls = &edp->load_vsorted[i];
-		if (vaddr >= pls->virt + pls->memsz)
-			continue;
-		if (vaddr >= pls->virt || pls->virt - vaddr < dist)
-			return edp->last_load = pls;
-	}
-	return NULL;
+	i = find_load_end(edp->load_vsorted, edp->num_load_vsorted, vaddr);
+	if (i >= edp->num_load_vsorted)
+		return NULL;
+
+	/* All following segments start even further. */
+	pls = &edp->load_vsorted[i];
+	if (vaddr < pls->virt && pls->virt - vaddr >= dist)
+		return NULL;
+
+	if (lc)
+		lc->vload = pls;
+	return pls;
+}
+
+/**  Get the LOAD segment cache of a dump file object.
+ * @param ctx  Dump file object.
+ * @returns    Per-context LOAD segment cache, or @c NULL.
+ */
+static inline struct load_cache *
+get_load_cache(kdump_ctx_t *ctx)
+{
+	struct elfdump_priv *edp = ctx->shared->fmtdata;
+	return edp->load_cache_slot >= 0
+		? ctx->data[edp->load_cache_slot]
+		: NULL;
 }
 
 static kdump_status
 elf_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
 	struct elfdump_priv *edp = ctx->shared->fmtdata;
+	struct load_cache *lc = get_load_cache(ctx);
 	kdump_addr_t addr;
 	struct load_segment *pls;
 	kdump_addr_t loadaddr;
@@ -238,8 +304,8 @@ elf_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	endp = p + get_page_size(ctx);
 	while (p < endp) {
 		pls = (pio->addr.as == ADDRXLAT_KVADDR
-		       ? find_closest_vload(edp, addr, endp - p)
-		       : find_closest_load(edp, addr, endp - p));
+		       ? find_closest_vload(edp, lc, addr, endp - p)
+		       : find_closest_load(edp, lc, addr, endp - p));
 		if (!pls) {
 			memset(p, 0, endp - p);
 			break;
@@ -291,6 +357,7 @@ static kdump_status
 elf_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
 	struct elfdump_priv *edp = ctx->shared->fmtdata;
+	struct load_cache *lc = get_load_cache(ctx);
 	struct load_segment *pls;
 	kdump_paddr_t addr, loadaddr;
 	size_t sz;
@@ -298,8 +365,8 @@ elf_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 
 	sz = get_page_size(ctx);
 	pls = (pio->addr.as == ADDRXLAT_KVADDR
-	       ? find_closest_vload(edp, pio->addr.addr, sz)
-	       : find_closest_load(edp, pio->addr.addr, sz));
+	       ? find_closest_vload(edp, lc, pio->addr.addr, sz)
+	       : find_closest_load(edp, lc, pio->addr.addr, sz));
 	if (!pls) {
 		addrxlat_status status;
 		kdump_status ret;
@@ -318,7 +385,7 @@ elf_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 		if (status != ADDRXLAT_OK)
 			return addrxlat2kdump(ctx, status);
 
-		pls = find_closest_load(edp, pio->addr.addr, sz);
+		pls = find_closest_load(edp, lc, pio->addr.addr, sz);
 		if (!pls)
 			return set_error(ctx, KDUMP_ERR_NODATA,
 					 "Page not found");
@@ -352,7 +419,7 @@ elf_get_bits(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
 	rwlock_rdlock(&shared->lock);
 	edp = shared->fmtdata;
 
-	pls = find_closest_load(edp, pfn_to_addr(shared, first),
+	pls = find_closest_load(edp, NULL, pfn_to_addr(shared, first),
 				pfn_to_addr(shared, last - first + 1));
 	if (!pls) {
 		memset(bits, 0, ((last - first) >> 3) + 1);
@@ -399,7 +466,7 @@ elf_find_set(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
 
 	rwlock_rdlock(&shared->lock);
 	edp = shared->fmtdata;
-	pls = find_closest_load(edp, pfn_to_addr(shared, *idx),
+	pls = find_closest_load(edp, NULL, pfn_to_addr(shared, *idx),
 				KDUMP_ADDR_MAX);
 	if (!pls) {
 		rwlock_unlock(&shared->lock);
@@ -423,7 +490,7 @@ elf_find_clear(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
 
 	rwlock_rdlock(&shared->lock);
 	edp = shared->fmtdata;
-	pls = find_closest_load(edp, pfn_to_addr(shared, *idx),
+	pls = find_closest_load(edp, NULL, pfn_to_addr(shared, *idx),
 				KDUMP_ADDR_MAX);
 	if (pls)
 		while (pls < &edp->load_sorted[edp->num_load_sorted] &&
@@ -436,6 +503,33 @@ elf_find_clear(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
 	return KDUMP_OK;
 }
 
+static kdump_status
+elf_iter_runs(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
+	      struct bmp_run_state *st)
+{
+	struct kdump_shared *shared = bmp->priv;
+	struct elfdump_priv *edp;
+	const struct load_segment *pls, *end;
+
+	rwlock_rdlock(&shared->lock);
+	edp = shared->fmtdata;
+	pls = find_closest_load(edp, NULL, pfn_to_addr(shared, st->first),
+				KDUMP_ADDR_MAX);
+	if (pls) {
+		end = &edp->load_sorted[edp->num_load_sorted];
+		for ( ; pls < end; ++pls) {
+			if (!pls->memsz)
+				continue;
+			if (bmp_run_add(st, addr_to_pfn(shared, pls->phys),
+					addr_to_pfn(shared, pls->phys +
+						    pls->memsz - 1)))
+				break;
+		}
+	}
+	rwlock_unlock(&shared->lock);
+	return KDUMP_OK;
+}
+
 static void
 elf_bmp_cleanup(const kdump_bmp_t *bmp)
 {
@@ -447,6 +541,7 @@ static const struct kdump_bmp_ops elf_bmp_ops = {
 	.get_bits = elf_get_bits,
 	.find_set = elf_find_set,
 	.find_clear = elf_find_clear,
+	.iter_runs = elf_iter_runs,
 	.cleanup = elf_bmp_cleanup,
 };
 
@@ -528,11 +623,25 @@ pfn2idx_map_add(struct pfn2idx_map *map, struct pfn2idx_range *range,
 	return KDUMP_OK;
 }
 
+/** Get the first PFN of a PFN-to-index range.
+ * @param r  PFN range.
+ * @returns  Lowest PFN in the range.
+ *
+ * Note that @c r->pfn is the last added PFN, i.e. the highest PFN
+ * of an ascending range, but the lowest PFN of a descending range.
+ */
+static inline kdump_pfn_t
+pfn2idx_range_first(const struct pfn2idx_range *r)
+{
+	return r->len >= 0 ? r->pfn - r->len + 1 : r->pfn;
+}
+
 static int
 pfn2idx_range_cmp(const void *a, const void *b)
 {
-	const struct pfn2idx_range *ra = a, *rb = b;
-	return ra->pfn != rb->pfn ? (ra->pfn > rb->pfn ? 1 : -1) : 0;
+	kdump_pfn_t pa = pfn2idx_range_first(a);
+	kdump_pfn_t pb = pfn2idx_range_first(b);
+	return pa != pb ? (pa > pb ? 1 : -1) : 0;
 }
 
 static int
@@ -562,25 +671,39 @@ pfn2idx_map_end(struct pfn2idx_map *map, struct pfn2idx_range *range)
 static uint_fast64_t
 pfn2idx_map_search(struct pfn2idx_map *map, kdump_pfn_t pfn)
 {
-	size_t i;
-	for (i = 0; i < map->nranges; ++i) {
-		struct pfn2idx_range *r = &map->ranges[i];
+	const struct pfn2idx_range *r;
+	const struct pfn2idx *single;
+	struct pfn2idx key;
+	size_t lo, hi, mid;
+
+	/* Find the first range which starts above @c pfn. */
+	lo = 0;
+	hi = map->nranges;
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (pfn2idx_range_first(&map->ranges[mid]) <= pfn)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	/* Only the range before it may contain @c pfn. */
+	if (lo > 0) {
+		r = &map->ranges[lo - 1];
 		if (r->len >= 0) {
-			if (pfn < r->pfn - r->len + 1)
-				break;
 			if (pfn <= r->pfn)
 				return r->idx + pfn - r->pfn;
 		} else {
-			if (pfn < r->pfn)
-				break;
 			if (pfn <= r->pfn - r->len - 1)
 				return r->idx + r->pfn - pfn;
 		}
 	}
 
-	for (i = 0; i < map->nsingles && pfn <= map->singles[i].pfn; ++i)
-		if (map->singles[i].pfn == pfn)
-			return map->singles[i].idx;
+	key.pfn = pfn;
+	single = bsearch(&key, map->singles, map->nsingles,
+			 sizeof *map->singles, pfn2idx_single_cmp);
+	if (single)
+		return single->idx;
 
 	return IDX_NONE;
 }
@@ -1198,7 +1321,7 @@ static int
 seg_virt_cmp(const void *a, const void *b)
 {
 	const struct load_segment *la = a, *lb = b;
-	return la->phys != lb->phys ? (la->phys < lb->phys ? -1 : 1) : 0;
+	return la->virt != lb->virt ? (la->virt < lb->virt ? -1 : 1) : 0;
 }
 
 static kdump_status
@@ -1207,6 +1330,7 @@ open_common(kdump_ctx_t *ctx)
 	struct elfdump_priv *edp = ctx->shared->fmtdata;
 	struct fcache_chunk fch;
 	kdump_pfn_t max_pfn;
+	kdump_addr_t end;
 	unsigned long as_caps;
 	kdump_bmp_t *bmp;
 	kdump_status ret;
@@ -1290,6 +1414,26 @@ open_common(kdump_ctx_t *ctx)
 	qsort(edp->load_vsorted, edp->num_load_segments,
 	      sizeof(struct load_segment), seg_virt_cmp);
 
+	/* Prepare for binary search. */
+	end = 0;
+	for (i = 0; i < edp->num_load_sorted; ++i) {
+		struct load_segment *seg = edp->load_sorted + i;
+		if (end < seg->phys + seg->memsz)
+			end = seg->phys + seg->memsz;
+		seg->max_end = end;
+	}
+	end = 0;
+	for (i = 0; i < edp->num_load_vsorted; ++i) {
+		struct load_segment *seg = edp->load_vsorted + i;
+		if (end < seg->virt + seg->memsz)
+			end = seg->virt + seg->memsz;
+		seg->max_end = end;
+	}
+
+	/* Failure is not fatal; lookups are just not cached. */
+	edp->load_cache_slot = per_ctx_alloc(ctx->shared,
+					     sizeof(struct load_cache));
+
 	free(edp->load_segments);
 	edp->load_segments = edp->note_segments = NULL;
 
@@ -1369,6 +1513,7 @@ do_probe(kdump_ctx_t *ctx, void *hdr)
 	if (!edp)
 		return set_error(ctx, KDUMP_ERR_SYSTEM,
 				 "Cannot allocate ELF dump private data");
+	edp->load_cache_slot = -1;
 	ctx->shared->fmtdata = edp;
 
 	switch (eheader[EI_DATA]) {
@@ -1431,6 +1576,8 @@ elf_cleanup(struct kdump_shared *shared)
 	struct elfdump_priv *edp = shared->fmtdata;
 
 	if (edp) {
+		if (edp->load_cache_slot >= 0)
+			per_ctx_free(shared, edp->load_cache_slot);
 		if (edp->load_sorted)
 			free(edp->load_sorted);
 		if (edp->load_segments)
@@ -238,6 +238,27 @@ struct arch_ops {
 	void (*cleanup)(struct kdump_shared *);
 };
 
+/**  Bitmap run iteration state.
+ *
+ * Runs reported by the format-specific code are clipped to the
+ * requested range, and adjacent or overlapping runs are merged
+ * before they are passed to the user callback.
+ */
+struct bmp_run_state {
+	kdump_addr_t first;	/**< First requested index. */
+	kdump_addr_t last;	/**< Last requested index. */
+	kdump_bmp_run_fn *fn;	/**< User callback. */
+	void *data;		/**< User callback data. */
+
+	kdump_addr_t start;	/**< Start of the pending run. */
+	kdump_addr_t end;	/**< End of the pending run (inclusive). */
+	bool pending;		/**< A run is pending. */
+	bool stopped;		/**< Iteration should stop. */
+};
+
+INTERNAL_DECL(int, bmp_run_add,
+	      (struct bmp_run_state *st, kdump_addr_t start, kdump_addr_t end));
+
 struct kdump_bmp_ops {
 	/** Get raw bits. */
 	kdump_status (*get_bits)(
@@ -252,6 +273,14 @@ struct kdump_bmp_ops {
 	kdump_status (*find_clear)(
 		kdump_errmsg_t *err, const kdump_bmp_t *bmp, kdump_addr_t *idx);
 
+	/** Iterate over runs of set bits.
+	 * Implementations call @ref bmp_run_add for each run in
+	 * ascending order and stop as soon as it returns non-zero.
+	 */
+	kdump_status (*iter_runs)(
+		kdump_errmsg_t *err, const kdump_bmp_t *bmp,
+		struct bmp_run_state *st);
+
 	/** Clean up any private data. */
 	void (*cleanup)(const kdump_bmp_t *bmp);
 };
@@ -279,6 +308,37 @@ INTERNAL_DECL(void, set_bits,
 	      (unsigned char *buf, size_t start, size_t end));
 INTERNAL_DECL(void, clear_bits,
 	      (unsigned char *buf, size_t start, size_t end));
+INTERNAL_DECL(size_t, skip_clear_bits,
+	      (const unsigned char *buf, size_t size, size_t idx));
+INTERNAL_DECL(size_t, skip_set_bits,
+	      (const unsigned char *buf, size_t size, size_t idx));
+
+/**  Type of a function which skips bytes with a given value.
+ * @param p     First byte to check.
+ * @param end   End of the buffer.
+ * @param fill  Byte value to skip (@c 0x00 or @c 0xff).
+ * @returns     Pointer to the first byte not equal to @p fill,
+ *              or @p end if there is no such byte.
+ */
+typedef const unsigned char *skip_bytes_fn(
+	const unsigned char *p, const unsigned char *end, unsigned char fill);
+
+/**  Implementation of a byte skipping function.
+ */
+struct skip_bytes_impl {
+	/** Implementation name. */
+	const char *name;
+
+	/** Check whether the CPU supports this implementation.
+	 * If @c NULL, the implementation is always supported.
+	 */
+	int (*supported)(void);
+
+	/** Skip function. */
+	skip_bytes_fn *fn;
+};
+
+INTERNAL_DECL(extern const struct skip_bytes_impl, skip_bytes_impls, []);
 
 /* provide our own definition of new_utsname */
 #define NEW_UTS_LEN 64
@@ -539,12 +599,21 @@ INTERNAL_DECL(struct attr_data *, ostype_attr,
 	       const struct ostype_attr_map *map));
 
 struct cache;
+struct readahead_pool;
 
 /** Number of per-context data slots.
  * If needed, this number can be increased without breaking public ABI.
  */
 #define PER_CTX_SLOTS	16
 
+/**  Per-context data cleanup function.
+ * @param data  Per-context data.
+ *
+ * This function is called before per-context data is freed. It must
+ * cope with data which is still all zeroes.
+ */
+typedef void per_ctx_cleanup_fn(void *data);
+
 /**  Shared state of the dump file object.
  *
  * This structure describes the data portion of the dump file object,
@@ -571,9 +640,17 @@ struct kdump_shared {
 	enum kdump_arch arch;	/**< Internal-only arch index. */
 	int arch_init_done;	/**< Non-zero if arch init has been called. */
 
-	struct cache *cache;	/**< Page cache. */
+	struct cache_shard *cache; /**< Page cache shards. */
+	unsigned ncache;	/**< Number of page cache shards. */
 	struct fcache *fcache;	/**< File cache. */
-	mutex_t cache_lock;	/**< Cache access lock. */
+	mutex_t cache_lock;	/**< File cache access lock. */
+
+	/** Replaced page cache shards with pages still in use.
+	 * Protected by @c cache_lock. */
+	struct retired_shards *retired;
+
+	/** Decompression worker pool, or @c NULL if not running. */
+	struct readahead_pool *rapool;
 
 	/** Static attributes. */
 #define ATTR(dir, key, field, type, ctype, ...)	\
@@ -583,6 +660,9 @@ struct kdump_shared {
 
 	/** Size of per-context data. Zero means unallocated. */
 	size_t per_ctx_size[PER_CTX_SLOTS];
+
+	/** Per-context data cleanup functions (optional). */
+	per_ctx_cleanup_fn *per_ctx_cleanup[PER_CTX_SLOTS];
 };
 
 INTERNAL_DECL(void, shared_free,
@@ -692,6 +772,14 @@ struct cached_reads {
 	unsigned char val[READ_CACHE_SLOTS][READ_CACHE_SIZE];
 };
 
+/**  Sequential read detection.
+ */
+struct readahead_state {
+	addrxlat_fulladdr_t next; /**< Address of the next sequential page. */
+	addrxlat_addr_t end;	  /**< End of pages queued for read-ahead. */
+	int worker;		  /**< Non-zero in worker contexts. */
+};
+
 /**  Representation of a dump file.
  *
  * This structure contains state information and a pointer to @c struct
@@ -700,7 +788,10 @@ struct cached_reads {
 struct _kdump_ctx {
 	struct kdump_shared *shared; /**< Dump file shared data. */
 
-	struct attr_dict *dict;	/**< Attribute dictionary. */
+	/** Attribute dictionary.
+	 * This is @c NULL in internal objects which do not use attributes.
+	 */
+	struct attr_dict *dict;
 
 	/** Node of the @c ctx list in @c struct @ref kdump_shared. */
 	struct list_head list;
@@ -717,6 +808,18 @@ struct _kdump_ctx {
 	/** Cached reads. */
 	struct cached_reads cached;
 
+	/** Per-context page cache slots. */
+	struct page_l1_slot *l1;
+
+	/** Number of slots in @c l1. */
+	unsigned l1size;
+
+	/** Flushed per-context page cache slots with active users. */
+	struct page_l1_detached *l1_detached;
+
+	/** Read-ahead state. */
+	struct readahead_state ra;
+
 	/** Per-context data. */
 	void *data[PER_CTX_SLOTS];
 
@@ -725,10 +828,16 @@ struct _kdump_ctx {
 	kdump_errmsg_t err;
 };
 
+INTERNAL_DECL(kdump_ctx_t *, clone_locked,
+	      (const kdump_ctx_t *orig, unsigned long flags));
+INTERNAL_DECL(void, ctx_release_locked, (kdump_ctx_t *ctx));
+
 /* Per-context data */
 
 INTERNAL_DECL(int, per_ctx_alloc, (struct kdump_shared *shared, size_t sz));
 INTERNAL_DECL(void, per_ctx_free, (struct kdump_shared *shared, int slot));
+INTERNAL_DECL(void, per_ctx_release,
+	      (struct kdump_shared *shared, kdump_ctx_t *ctx, int slot));
 
 /* File formats */
 
@@ -771,6 +880,9 @@ INTERNAL_DECL(kdump_status, read_string_locked,
 INTERNAL_DECL(kdump_status, read_locked,
 	      (kdump_ctx_t *ctx, kdump_addrspace_t as,
 	       kdump_addr_t addr, void *buffer, size_t *plength));
+INTERNAL_DECL(kdump_status, readv_locked,
+	      (kdump_ctx_t *ctx, kdump_addrspace_t as,
+	       struct kdump_iovec *vec, size_t n));
 INTERNAL_DECL(void, set_addrspace_caps,
 	      (struct kdump_xlat *xlat, unsigned long caps));
 
@@ -796,8 +908,9 @@ INTERNAL_DECL(int, uts_looks_sane, (struct new_utsname *uts));
 INTERNAL_DECL(int, uncompress_rle,
 	      (unsigned char *dst, size_t *pdstlen,
 	       const unsigned char *src, size_t srclen));
+INTERNAL_DECL(int, per_ctx_alloc_zlib, (struct kdump_shared *shared));
 INTERNAL_DECL(kdump_status, uncompress_page_gzip,
-	      (kdump_ctx_t *ctx, unsigned char *dst,
+	      (kdump_ctx_t *ctx, int slot, unsigned char *dst,
 	       unsigned char *src, size_t srclen));
 
 INTERNAL_DECL(uint32_t, cksum32, (void *buffer, size_t size, uint32_t csum));
@@ -1142,6 +1255,11 @@ INTERNAL_DECL(extern const struct attr_ops, file_fd_ops, );
 INTERNAL_DECL(extern const struct attr_ops, page_size_ops, );
 INTERNAL_DECL(extern const struct attr_ops, page_shift_ops, );
 INTERNAL_DECL(extern const struct attr_ops, cache_size_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_shards_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_l1_size_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_decompress_threads_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_hits_ops, );
+INTERNAL_DECL(extern const struct attr_ops, cache_misses_ops, );
 INTERNAL_DECL(extern const struct attr_ops, arch_name_ops, );
 INTERNAL_DECL(extern const struct attr_ops, ostype_ops, );
 INTERNAL_DECL(extern const struct attr_ops, uts_machine_ops, );
@@ -1149,6 +1267,9 @@ INTERNAL_DECL(extern const struct attr_ops, vmcoreinfo_raw_ops, );
 INTERNAL_DECL(extern const struct attr_ops, dirty_xlat_ops, );
 INTERNAL_DECL(extern const struct attr_ops, linux_dirty_xlat_ops, );
 INTERNAL_DECL(extern const struct attr_ops, xen_dirty_xlat_ops, );
+INTERNAL_DECL(extern const struct attr_ops, xlat_tlb_size_ops, );
+INTERNAL_DECL(extern const struct attr_ops, xlat_tlb_hits_ops, );
+INTERNAL_DECL(extern const struct attr_ops, xlat_tlb_misses_ops, );
 INTERNAL_DECL(extern const struct attr_ops, linux_version_code_ops, );
 INTERNAL_DECL(extern const struct attr_ops, linux_ver_ops, );
 INTERNAL_DECL(extern const struct attr_ops, xen_version_code_ops, );
@@ -1202,6 +1323,17 @@ typedef kdump_addr_t	cache_key_t;
  */
 #define DEFAULT_CACHE_SIZE	1024
 
+/** Default number of page cache shards.
+ * A single shard behaves like a plain cache protected by one lock.
+ */
+#define DEFAULT_CACHE_SHARDS	1
+
+/** Default number of per-context page cache slots.
+ * Each slot pins a page in the shared page cache, so the per-context
+ * page cache is disabled by default.
+ */
+#define DEFAULT_CACHE_L1_SIZE	0
+
 /**  Cache entry state.
  */
 enum cache_state {
@@ -1215,9 +1347,11 @@ enum cache_state {
 struct cache_entry {
 	cache_key_t key;	/**< Cache entry key. */
 	enum cache_state state;	/**< Cache entry state. */
+	unsigned list;		/**< List which contains this entry. */
 	unsigned next;		/**< Index of next entry in evict list. */
 	unsigned prev;		/**< Index of previous entry in evict list. */
 	unsigned refcnt;	/**< Reference count. */
+	unsigned loading;	/**< Non-zero while data is being loaded. */
 	void *data;		/**< Pointer to data. */
 };
 
@@ -1241,8 +1375,101 @@ INTERNAL_DECL(void, cache_put_entry,
 INTERNAL_DECL(void, cache_insert, (struct cache *, struct cache_entry *));
 INTERNAL_DECL(void, cache_discard, (struct cache *, struct cache_entry *));
 
+/**  Page cache shard.
+ *
+ * The page cache key space is split among independently locked
+ * shards to reduce lock contention between threads.
+ */
+struct cache_shard {
+	mutex_t lock;		/**< Shard access lock. */
+	cond_t cond;		/**< Signalled when an entry is released. */
+	unsigned nwait;		/**< Number of waiting threads. */
+	struct cache *cache;	/**< Cache object. */
+};
+
+/**  Wake up all threads waiting for a page cache shard.
+ * @param shard  Page cache shard (locked).
+ */
+static inline void
+cache_shard_wake(struct cache_shard *shard)
+{
+	if (shard->nwait)
+		cond_broadcast(&shard->cond);
+}
+
+INTERNAL_DECL(void, cache_shard_put,
+	      (struct cache_shard *shard, struct cache_entry *entry));
+
+INTERNAL_DECL(unsigned, get_cache_shards, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, free_cache_shards,
+	      (struct cache_shard *shards, unsigned n));
+INTERNAL_DECL(void, retire_cache_shards, (struct kdump_shared *shared));
+INTERNAL_DECL(void, free_retired_shards, (struct kdump_shared *shared));
 INTERNAL_DECL(kdump_status, def_realloc_caches, (kdump_ctx_t *ctx));
 
+/**  Per-context page cache slot.
+ *
+ * Each slot holds a reference to a valid entry in the shared page
+ * cache, so the page can be accessed without taking any lock.
+ */
+struct page_l1_slot {
+	cache_key_t key;	/**< Cache entry key. */
+	struct cache_shard *shard; /**< Cache shard, or @c NULL if unused. */
+	struct cache_entry *ce;	/**< Pinned cache entry. */
+	unsigned users;		/**< Number of active users. */
+};
+
+/**  Detached per-context page cache slot.
+ *
+ * When a slot is flushed while its page is still in use, the reference
+ * to the shared page cache entry is moved here and dropped only after
+ * the last user puts the page.
+ */
+struct page_l1_detached {
+	struct page_l1_detached *next; /**< Next detached slot. */
+	cache_key_t key;	/**< Cache entry key. */
+	struct cache_shard *shard; /**< Cache shard. */
+	struct cache_entry *ce;	/**< Pinned cache entry. */
+	unsigned users;		/**< Number of active users. */
+};
+
+INTERNAL_DECL(unsigned, get_cache_l1_size, (kdump_ctx_t *ctx));
+INTERNAL_DECL(int, page_l1_resize, (kdump_ctx_t *ctx, unsigned size));
+INTERNAL_DECL(void, page_l1_flush, (kdump_ctx_t *ctx));
+INTERNAL_DECL(void, page_l1_free, (kdump_ctx_t *ctx));
+INTERNAL_DECL(int, page_l1_put_detached,
+	      (kdump_ctx_t *ctx, struct cache_entry *ce));
+INTERNAL_DECL(int, put_retired_entry,
+	      (struct kdump_shared *shared, struct cache *cache,
+	       struct cache_entry *entry));
+INTERNAL_DECL(void, flush_all_page_l1, (struct kdump_shared *shared));
+
+/**  Get the per-context page cache slot for a key.
+ * @param ctx  Dump file object.
+ * @param key  Cache key.
+ * @returns    Slot which may hold @p key.
+ *
+ * The per-context page cache must not be empty.
+ */
+static inline struct page_l1_slot *
+get_page_l1_slot(kdump_ctx_t *ctx, cache_key_t key)
+{
+	return &ctx->l1[fold_hash(key ^ (key >> 32), 32) % ctx->l1size];
+}
+
+/**  Get the page cache shard for a key.
+ * @param shared  Shared data of a dump file object.
+ * @param key     Cache key.
+ * @returns       Page cache shard which holds @p key.
+ */
+static inline struct cache_shard *
+get_cache_shard(struct kdump_shared *shared, cache_key_t key)
+{
+	return shared->ncache > 1
+		? &shared->cache[fold_hash(key, 32) % shared->ncache]
+		: shared->cache;
+}
+
 /**  Check if a cache entry is valid.
  *
  * @param entry  Cache entry.
@@ -1382,6 +1609,13 @@ struct page_io {
 	struct fcache_chunk chunk; /**< File cache chunk. */
 };
 
+/**  Borrowed page of dump data.
+ */
+struct _kdump_page {
+	kdump_ctx_t *ctx;	   /**< Dump file object. */
+	struct page_io pio;	   /**< Page I/O control. */
+};
+
 typedef kdump_status read_page_fn(
 	kdump_ctx_t *ctx, struct page_io *pio);
 
@@ -1396,6 +1630,12 @@ void put_page(kdump_ctx_t *ctx, struct page_io *pio)
 	ctx->shared->ops->put_page(ctx, pio);
 }
 
+/* Read-ahead */
+
+INTERNAL_DECL(void, readahead_page,
+	      (kdump_ctx_t *ctx, const struct page_io *pio));
+INTERNAL_DECL(void, readahead_stop, (struct kdump_shared *shared));
+
 /* Inline utility functions */
 
 static inline unsigned
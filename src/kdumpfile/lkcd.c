@@ -35,6 +35,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/stat.h>
 
 /** @cond TARGET_ABI */
 
@@ -310,6 +314,11 @@ struct pfn_block {
 
 #define MAX_PFN_GAP 15
 
+/** Number of page descriptors read by the background scanner
+ * before it adds them to the PFN block tree.
+ */
+#define SCAN_CHUNK	1024
+
 /* Maximum size of the format name: the version field is a 32-bit integer,
  * so it cannot be longer than 10 decimal digits.
  */
@@ -331,15 +340,28 @@ struct lkcd_priv {
 	/** Overridden methods for arch.page_size attribute. */
 	struct attr_override page_size_override;
 	int cbuf_slot;		/**< Compressed data per-context slot. */
+	int zlib_slot;		/**< Per-context zlib stream slot. */
 
 	/** Overridden methods for max.pfn attribute. */
 	struct attr_override max_pfn_override;
 	kdump_pfn_t max_pfn;	/**< Maximum PFN seen so far. */
 
+	/** Overridden methods for file.pagemap attribute. */
+	struct attr_override pagemap_override;
+
+	char *index_path;	/**< Sidecar index file, or @c NULL. */
+	int index_done;		/**< Non-zero if index was loaded or saved. */
+
+	/** Background scanner object, or @c NULL if not started. */
+	kdump_ctx_t *scan_ctx;
+	thread_t scan_thread;	/**< Background scanner thread. */
+	int scan_stop;		/**< Non-zero if the scanner should exit. */
+
 	char format[MAX_FORMAT_NAME];
 };
 
 static void lkcd_cleanup(struct kdump_shared *shared);
+static void free_level1(struct pfn_block ***level1, unsigned long n);
 
 static struct pfn_block **
 get_pfn_slot(kdump_ctx_t *ctx, kdump_pfn_t pfn)
@@ -546,7 +568,9 @@ read_page_desc(kdump_ctx_t *ctx, struct dump_page *dp, off_t off)
 {
 	kdump_status ret;
 
+	mutex_lock(&ctx->shared->cache_lock);
 	ret = fcache_pread(ctx->shared->fcache, dp, sizeof *dp, off);
+	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return set_error(ctx, ret,
 				 "Cannot read page descriptor at %llu",
@@ -572,15 +596,363 @@ error_dup(kdump_ctx_t *ctx, off_t off, struct pfn_block *block, kdump_pfn_t pfn)
 			 (unsigned long long) prevoff);
 }
 
+/** Magic string at the beginning of a sidecar index file. */
+#define LKCD_INDEX_MAGIC	"LKCDIDX1"
+
+/**  Sidecar index file header.
+ *
+ * All fields are stored in host byte order. The index is a local
+ * cache of the page descriptor scan, not a portable file format.
+ */
+struct lkcd_index_header {
+	char magic[8];		/**< Must be @c LKCD_INDEX_MAGIC. */
+	uint64_t file_size;	/**< Dump file size. */
+	int64_t mtime_sec;	/**< Dump file mtime (seconds). */
+	int64_t mtime_nsec;	/**< Dump file mtime (nanoseconds). */
+	uint64_t data_offset;	/**< Offset of the first page. */
+	uint64_t end_offset;	/**< Offset of the end marker. */
+	uint64_t max_pfn;	/**< Maximum PFN plus one. */
+	uint64_t nblocks;	/**< Number of PFN block records. */
+	uint32_t page_shift;	/**< Page shift of the dump. */
+	uint32_t pad;		/**< Reserved (zero). */
+};
+
+/**  Sidecar index PFN block record.
+ *
+ * Each record is followed by @c n 32-bit offsets (see
+ * @ref pfn_block).
+ */
+struct lkcd_index_block {
+	uint64_t pfn;		/**< First PFN in the block. */
+	uint64_t filepos;	/**< Absolute file offset. */
+	uint32_t n;		/**< Number of offsets that follow. */
+	uint32_t pad;		/**< Reserved (zero). */
+};
+
+/**  Fill in the identification part of an index header.
+ * @param ctx  Dump file object.
+ * @param hdr  Header to be initialized.
+ * @returns    Zero on success, -1 if the dump file cannot be identified.
+ *
+ * All fields which describe the scan result are set to zero.
+ */
+static int
+init_index_header(kdump_ctx_t *ctx, struct lkcd_index_header *hdr)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct stat st;
+
+	if (fstat(get_file_fd(ctx), &st) || !S_ISREG(st.st_mode))
+		return -1;
+
+	memset(hdr, 0, sizeof *hdr);
+	memcpy(hdr->magic, LKCD_INDEX_MAGIC, sizeof hdr->magic);
+	hdr->file_size = st.st_size;
+	hdr->mtime_sec = st.st_mtim.tv_sec;
+	hdr->mtime_nsec = st.st_mtim.tv_nsec;
+	hdr->data_offset = lkcdp->data_offset;
+	hdr->page_shift = get_page_shift(ctx);
+	return 0;
+}
+
+/**  Write PFN block records to a sidecar index file.
+ * @param lkcdp  LKCD private data.
+ * @param f      Output stream, or @c NULL to count blocks only.
+ * @returns      Number of PFN blocks.
+ *
+ * Write errors are not reported here; check @c ferror on the stream.
+ */
+static uint64_t
+put_index_blocks(struct lkcd_priv *lkcdp, FILE *f)
+{
+	struct lkcd_index_block rec;
+	struct pfn_block *block;
+	unsigned long i, j;
+	uint64_t nblocks;
+
+	memset(&rec, 0, sizeof rec);
+	nblocks = 0;
+	for (i = 0; i < lkcdp->l1_size; ++i) {
+		if (!lkcdp->pfn_level1[i])
+			continue;
+		for (j = 0; j < PFN_IDX2_SIZE; ++j) {
+			block = lkcdp->pfn_level1[i][j];
+			for ( ; block; block = block->next) {
+				++nblocks;
+				if (!f)
+					continue;
+				rec.pfn = ((kdump_pfn_t)i <<
+					   (PFN_IDX2_BITS + PFN_IDX3_BITS)) |
+					(j << PFN_IDX3_BITS) | block->idx3;
+				rec.filepos = block->filepos;
+				rec.n = block->n;
+				fwrite(&rec, sizeof rec, 1, f);
+				if (block->n)
+					fwrite(block->offs, sizeof(uint32_t),
+					       block->n, f);
+			}
+		}
+	}
+	return nblocks;
+}
+
+/**  Save the sidecar index after a complete page descriptor scan.
+ * @param ctx  Dump file object.
+ *
+ * The index is written to a temporary file, which then replaces the
+ * target file atomically. Any failure is silently ignored, because
+ * the index is merely an optimization.
+ */
+static void
+save_index(kdump_ctx_t *ctx)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct lkcd_index_header hdr;
+	char *tmppath;
+	FILE *f;
+	int fd, ok;
+
+	if (!lkcdp->index_path || lkcdp->index_done)
+		return;
+	lkcdp->index_done = 1;
+
+	if (init_index_header(ctx, &hdr))
+		return;
+	hdr.end_offset = lkcdp->end_offset;
+	hdr.max_pfn = lkcdp->max_pfn;
+	hdr.nblocks = put_index_blocks(lkcdp, NULL);
+
+	tmppath = malloc(strlen(lkcdp->index_path) + sizeof(".XXXXXX"));
+	if (!tmppath)
+		return;
+	sprintf(tmppath, "%s.XXXXXX", lkcdp->index_path);
+	fd = mkstemp(tmppath);
+	if (fd < 0)
+		goto out_free;
+	f = fdopen(fd, "wb");
+	if (!f) {
+		close(fd);
+		goto out_unlink;
+	}
+
+	fwrite(&hdr, sizeof hdr, 1, f);
+	put_index_blocks(lkcdp, f);
+	ok = !ferror(f);
+	if (fclose(f))
+		ok = 0;
+	if (ok && !rename(tmppath, lkcdp->index_path))
+		goto out_free;
+
+ out_unlink:
+	unlink(tmppath);
+ out_free:
+	free(tmppath);
+}
+
+/**  Read PFN block records from a sidecar index file.
+ * @param ctx  Dump file object.
+ * @param f    Input stream (positioned after the header).
+ * @param hdr  Validated index header.
+ * @returns    Zero on success, -1 on failure.
+ *
+ * Every record is checked against the header, so a corrupted index
+ * cannot produce PFN blocks which point outside the page data.
+ */
+static int
+get_index_blocks(kdump_ctx_t *ctx, FILE *f,
+		 const struct lkcd_index_header *hdr)
+{
+	struct lkcd_index_block rec;
+	struct pfn_block *block;
+	uint64_t nblocks;
+	unsigned short i;
+
+	for (nblocks = hdr->nblocks; nblocks; --nblocks) {
+		if (fread(&rec, sizeof rec, 1, f) != 1)
+			return -1;
+		if (rec.pfn > UINT32_MAX ||
+		    rec.n >= PFN_IDX3_SIZE - pfn_idx3(rec.pfn) ||
+		    rec.pfn + rec.n >= hdr->max_pfn ||
+		    rec.filepos < hdr->data_offset ||
+		    rec.filepos >= hdr->end_offset)
+			return -1;
+
+		block = alloc_pfn_block(ctx, rec.pfn);
+		if (!block)
+			return -1;
+		block->filepos = rec.filepos;
+		if (!rec.n)
+			continue;
+		if (realloc_pfn_offs(block, rec.n) != KDUMP_OK)
+			return -1;
+		block->n = rec.n;
+		if (fread(block->offs, sizeof(uint32_t), rec.n, f) != rec.n)
+			return -1;
+		for (i = 0; i < block->n; ++i)
+			if (block->offs[i] >=
+			    hdr->end_offset - block->filepos)
+				return -1;
+	}
+
+	return fgetc(f) == EOF ? 0 : -1;
+}
+
+/**  Load the sidecar index.
+ * @param ctx  Dump file object.
+ *
+ * If the index is missing, stale or otherwise invalid, it is silently
+ * ignored, and the page descriptors are scanned from the beginning.
+ */
+static void
+load_index(kdump_ctx_t *ctx)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct lkcd_index_header hdr, cur;
+	FILE *f;
+	int res;
+
+	f = fopen(lkcdp->index_path, "rb");
+	if (!f)
+		return;
+
+	if (fread(&hdr, sizeof hdr, 1, f) != 1 ||
+	    init_index_header(ctx, &cur) ||
+	    memcmp(hdr.magic, cur.magic, sizeof hdr.magic) ||
+	    hdr.file_size != cur.file_size ||
+	    hdr.mtime_sec != cur.mtime_sec ||
+	    hdr.mtime_nsec != cur.mtime_nsec ||
+	    hdr.data_offset != cur.data_offset ||
+	    hdr.page_shift != cur.page_shift ||
+	    hdr.end_offset < hdr.data_offset ||
+	    hdr.end_offset > hdr.file_size) {
+		fclose(f);
+		return;
+	}
+
+	res = get_index_blocks(ctx, f, &hdr);
+	fclose(f);
+	if (res) {
+		free_level1(lkcdp->pfn_level1, lkcdp->l1_size);
+		lkcdp->pfn_level1 = NULL;
+		lkcdp->l1_size = 0;
+		clear_error(ctx);
+		return;
+	}
+
+	lkcdp->last_offset = hdr.end_offset;
+	lkcdp->end_offset = hdr.end_offset;
+	lkcdp->max_pfn = hdr.max_pfn;
+	lkcdp->index_done = 1;
+}
+
+/**  Add a page descriptor to the PFN block tree.
+ * @param ctx       Dump file object.
+ * @param dp        Page descriptor.
+ * @param off       File offset of @p dp.
+ * @param pblock    Current PFN block (updated on success).
+ * @param blocktbl  PFN of the current block's table (updated on success).
+ * @returns         Error status.
+ *
+ * On success, @c last_offset is advanced past the page data.
+ *
+ * The caller must hold @c pfn_block_mutex.
+ */
+static kdump_status
+index_page_desc(kdump_ctx_t *ctx, const struct dump_page *dp, off_t off,
+		struct pfn_block **pblock, kdump_pfn_t *blocktbl)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct pfn_block *block = *pblock;
+	kdump_pfn_t curpfn;
+	unsigned short idx;
+	kdump_status res;
+
+	curpfn = dp->dp_address >> get_page_shift(ctx);
+	if (!block)
+		block = lookup_pfn_block(ctx, curpfn, MAX_PFN_GAP);
+	else if (*blocktbl != (curpfn & ~PFN_IDX3_MASK) ||
+		 !idx_fits_block(pfn_idx3(curpfn), block)) {
+		realloc_pfn_offs(block, block->n);
+		block = lookup_pfn_block(ctx, curpfn, MAX_PFN_GAP);
+	}
+	if (block && off > block->filepos + UINT32_MAX) {
+		idx = pfn_idx3(curpfn) - block->idx3;
+		res = split_pfn_block(ctx, block, idx);
+		if (res != KDUMP_OK)
+			return set_error(ctx, res,
+					 "Cannot split PFN block");
+		block = NULL;
+	}
+	if (block) {
+		idx = pfn_idx3(curpfn) - block->idx3;
+		if (!idx--)
+			return error_dup(ctx, off, block, curpfn);
+		if (idx >= block->n)
+			block->n = idx + 1;
+		if (block->n >= block->alloc) {
+			res = realloc_pfn_offs(block, PFN_IDX3_SIZE);
+			if (res != KDUMP_OK)
+				return error_pfn_offs(ctx, res);
+		}
+	}
+
+	if (!block) {
+		block = alloc_pfn_block(ctx, curpfn);
+		if (!block)
+			return KDUMP_ERR_SYSTEM;
+		block->filepos = off;
+	} else if (block->offs[idx] == 0)
+		block->offs[idx] = off - block->filepos;
+	else
+		return error_dup(ctx, off, block, curpfn);
+
+	*pblock = block;
+	*blocktbl = curpfn & ~PFN_IDX3_MASK;
+
+	if (curpfn >= lkcdp->max_pfn)
+		lkcdp->max_pfn = curpfn + 1;
+
+	lkcdp->last_offset = off + sizeof(struct dump_page) + dp->dp_size;
+	return KDUMP_OK;
+}
+
+/**  Record the position of the end marker.
+ * @param ctx    Dump file object.
+ * @param off    File offset of the end marker.
+ * @param block  Current PFN block, or @c NULL.
+ *
+ * The caller must hold @c pfn_block_mutex.
+ */
+static void
+end_page_desc(kdump_ctx_t *ctx, off_t off, struct pfn_block *block)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+
+	lkcdp->end_offset = off;
+	if (block)
+		realloc_pfn_offs(block, block->n);
+	save_index(ctx);
+}
+
+/**  Parse page descriptors until a given PFN is found.
+ * @param ctx      Dump file object.
+ * @param pfn      Target PFN.
+ * @param dp       Page descriptor (updated on success).
+ * @param dataoff  File offset of the page data (updated on success).
+ * @returns        Error status.
+ *
+ * Parsing continues where the previous call stopped.
+ *
+ * The caller must hold @c pfn_block_mutex.
+ */
 static kdump_status
 search_page_desc(kdump_ctx_t *ctx, kdump_pfn_t pfn,
 		 struct dump_page *dp, off_t *dataoff)
 {
 	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
 	off_t off;
-	kdump_pfn_t curpfn, blocktbl;
+	kdump_pfn_t blocktbl;
 	struct pfn_block *block;
-	unsigned short idx;
 	kdump_status res;
 
 	off = lkcdp->last_offset;
@@ -588,69 +960,30 @@ search_page_desc(kdump_ctx_t *ctx, kdump_pfn_t pfn,
 		return set_error(ctx, KDUMP_ERR_NODATA, "Page not found");
 
 	block = NULL;
-	do {
+	blocktbl = 0;
+	for (;;) {
 		res = read_page_desc(ctx, dp, off);
 		if (res != KDUMP_OK) {
 			if (res == KDUMP_ERR_EOF)
-				lkcdp->end_offset = off;
-			if (block)
+				end_page_desc(ctx, off, block);
+			else if (block)
 				realloc_pfn_offs(block, block->n);
 			return res;
 		}
 
 		if (dp->dp_flags & DUMP_END) {
-			lkcdp->end_offset = off;
-			if (block)
-				realloc_pfn_offs(block, block->n);
+			end_page_desc(ctx, off, block);
 			return set_error(ctx, KDUMP_ERR_NODATA, "Page not found");
 		}
 
-		curpfn = dp->dp_address >> get_page_shift(ctx);
-		if (!block)
-			block = lookup_pfn_block(ctx, curpfn, MAX_PFN_GAP);
-		else if (blocktbl != (curpfn & ~PFN_IDX3_MASK) ||
-			 !idx_fits_block(pfn_idx3(curpfn), block)) {
-			realloc_pfn_offs(block, block->n);
-			block = lookup_pfn_block(ctx, curpfn, MAX_PFN_GAP);
-		}
-		if (block && off > block->filepos + UINT32_MAX) {
-			idx = pfn_idx3(curpfn) - block->idx3;
-			res = split_pfn_block(ctx, block, idx);
-			if (res != KDUMP_OK)
-				return set_error(ctx, res,
-						 "Cannot split PFN block");
-			block = NULL;
-		}
-		if (block) {
-			idx = pfn_idx3(curpfn) - block->idx3;
-			if (!idx--)
-				return error_dup(ctx, off, block, curpfn);
-			if (idx >= block->n)
-				block->n = idx + 1;
-			if (block->n >= block->alloc) {
-				res = realloc_pfn_offs(block, PFN_IDX3_SIZE);
-				if (res != KDUMP_OK)
-					return error_pfn_offs(ctx, res);
-			}
-		}
-
-		blocktbl = curpfn & ~PFN_IDX3_MASK;
-		if (!block) {
-			block = alloc_pfn_block(ctx, curpfn);
-			if (!block)
-				return KDUMP_ERR_SYSTEM;
-			block->filepos = off;
-		} else if (block->offs[idx] == 0)
-			block->offs[idx] = off - block->filepos;
-		else
-			return error_dup(ctx, off, block, curpfn);
-
-		if (curpfn >= lkcdp->max_pfn)
-			lkcdp->max_pfn = curpfn + 1;
+		res = index_page_desc(ctx, dp, off, &block, &blocktbl);
+		if (res != KDUMP_OK)
+			return res;
 
-		off += sizeof(struct dump_page) + dp->dp_size;
-		lkcdp->last_offset = off;
-	} while (curpfn != pfn);
+		off = lkcdp->last_offset;
+		if ((dp->dp_address >> get_page_shift(ctx)) == pfn)
+			break;
+	}
 
 	*dataoff = off - dp->dp_size;
 	return KDUMP_OK;
@@ -691,6 +1024,215 @@ get_page_desc(kdump_ctx_t *ctx, kdump_pfn_t pfn,
 	return status;
 }
 
+/**  Page descriptor read by the background scanner.
+ */
+struct scan_desc {
+	off_t off;		/**< File offset of the descriptor. */
+	struct dump_page dp;	/**< Page descriptor. */
+};
+
+/**  Read a batch of page descriptors.
+ * @param ctx    Scanner dump file object.
+ * @param batch  Array of at least @ref SCAN_CHUNK elements.
+ * @param off    File offset of the first page descriptor.
+ * @returns      Number of page descriptors read.
+ *
+ * Reading stops after @ref SCAN_CHUNK page descriptors, after the
+ * end marker, or on error. The PFN block tree is not touched, so
+ * this function does not need @c pfn_block_mutex.
+ */
+static unsigned
+read_scan_batch(kdump_ctx_t *ctx, struct scan_desc *batch, off_t off)
+{
+	unsigned n;
+
+	for (n = 0; n < SCAN_CHUNK; ++n) {
+		if (read_page_desc(ctx, &batch[n].dp, off) != KDUMP_OK)
+			break;
+		batch[n].off = off;
+		if (batch[n].dp.dp_flags & DUMP_END)
+			return n + 1;
+		off += sizeof(struct dump_page) + batch[n].dp.dp_size;
+	}
+	return n;
+}
+
+/**  Add a batch of page descriptors to the PFN block tree.
+ * @param ctx    Scanner dump file object.
+ * @param batch  Page descriptors from @ref read_scan_batch.
+ * @param n      Number of elements in @p batch.
+ * @returns      Error status.
+ *
+ * Foreground readers may have parsed some (or all) of the descriptors
+ * in @p batch while the scanner was reading it. These descriptors
+ * are skipped.
+ *
+ * The caller must hold @c pfn_block_mutex.
+ */
+static kdump_status
+add_scan_batch(kdump_ctx_t *ctx, const struct scan_desc *batch, unsigned n)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct pfn_block *block;
+	kdump_pfn_t blocktbl;
+	kdump_status res;
+	unsigned i;
+
+	for (i = 0; i < n && batch[i].off != lkcdp->last_offset; ++i)
+		;
+	if (lkcdp->last_offset == lkcdp->end_offset)
+		return KDUMP_OK;
+
+	block = NULL;
+	blocktbl = 0;
+	for ( ; i < n; ++i) {
+		if (batch[i].dp.dp_flags & DUMP_END) {
+			end_page_desc(ctx, batch[i].off, block);
+			break;
+		}
+		res = index_page_desc(ctx, &batch[i].dp, batch[i].off,
+				      &block, &blocktbl);
+		if (res != KDUMP_OK)
+			return res;
+	}
+	return KDUMP_OK;
+}
+
+/**  Background page descriptor scanner thread function.
+ * @param arg  Scanner dump file object.
+ * @returns    Always @c NULL.
+ *
+ * The scanner reads page descriptors in batches of @ref SCAN_CHUNK
+ * without holding @c pfn_block_mutex, and it takes the mutex only
+ * to add a finished batch to the PFN block tree. Foreground readers
+ * can look up pages which have already been indexed, or continue
+ * the scan themselves if they need a page beyond it.
+ * The thread exits when the end of the dump file is reached, on
+ * error, or when asked to stop.
+ */
+static void *
+lkcd_scanner(void *arg)
+{
+	kdump_ctx_t *ctx = arg;
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct scan_desc *batch;
+	off_t off;
+	unsigned n;
+
+	batch = malloc(SCAN_CHUNK * sizeof(*batch));
+	if (!batch)
+		return NULL;
+
+	mutex_lock(&lkcdp->pfn_block_mutex);
+	while (!lkcdp->scan_stop &&
+	       lkcdp->last_offset != lkcdp->end_offset) {
+		off = lkcdp->last_offset;
+		mutex_unlock(&lkcdp->pfn_block_mutex);
+
+		n = read_scan_batch(ctx, batch, off);
+
+		mutex_lock(&lkcdp->pfn_block_mutex);
+		if (!n || add_scan_batch(ctx, batch, n) != KDUMP_OK)
+			break;
+
+		mutex_unlock(&lkcdp->pfn_block_mutex);
+		sched_yield();
+		mutex_lock(&lkcdp->pfn_block_mutex);
+	}
+	mutex_unlock(&lkcdp->pfn_block_mutex);
+
+	free(batch);
+	return NULL;
+}
+
+/**  Free the background scanner dump file object.
+ * @param ctx  Scanner dump file object.
+ */
+static void
+free_scan_ctx(kdump_ctx_t *ctx)
+{
+	ctx_release_locked(ctx);
+	err_cleanup(&ctx->err);
+	free(ctx);
+}
+
+/**  Start the background page descriptor scanner.
+ * @param ctx  Dump file object.
+ *
+ * The scanner uses its own dump file object, which holds neither
+ * a reference to the shared data nor to the attribute dictionary,
+ * so it does not keep the dump file open. It is stopped in
+ * @ref lkcd_cleanup.
+ *
+ * Failure is not fatal, because foreground readers scan the file
+ * on demand. The shared lock must be held for writing by the caller.
+ */
+static void
+start_scanner(kdump_ctx_t *ctx)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	kdump_ctx_t *scan_ctx;
+
+	scan_ctx = clone_locked(ctx, 0);
+	if (!scan_ctx)
+		return;
+	scan_ctx->ra.worker = 1;
+	page_l1_resize(scan_ctx, 0);
+	attr_dict_decref(scan_ctx->dict);
+	scan_ctx->dict = NULL;
+	shared_decref_locked(ctx->shared);
+
+	lkcdp->scan_stop = 0;
+	if (thread_create(&lkcdp->scan_thread, lkcd_scanner, scan_ctx)) {
+		free_scan_ctx(scan_ctx);
+		return;
+	}
+	lkcdp->scan_ctx = scan_ctx;
+}
+
+/**  Stop the background page descriptor scanner.
+ * @param lkcdp  LKCD private data.
+ */
+static void
+stop_scanner(struct lkcd_priv *lkcdp)
+{
+	if (!lkcdp->scan_ctx)
+		return;
+
+	mutex_lock(&lkcdp->pfn_block_mutex);
+	lkcdp->scan_stop = 1;
+	mutex_unlock(&lkcdp->pfn_block_mutex);
+
+	thread_join(lkcdp->scan_thread, NULL);
+	free_scan_ctx(lkcdp->scan_ctx);
+	lkcdp->scan_ctx = NULL;
+}
+
+/**  Scan all remaining page descriptors.
+ * @param ctx  Dump file object.
+ * @returns    Error status.
+ *
+ * The caller must hold @c pfn_block_mutex.
+ */
+static kdump_status
+scan_all_page_desc(kdump_ctx_t *ctx)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	struct dump_page dummy_dp;
+	off_t dummy_off;
+	kdump_status res;
+
+	if (lkcdp->last_offset == lkcdp->end_offset)
+		return KDUMP_OK;
+
+	res = search_page_desc(ctx, ~(kdump_pfn_t)0, &dummy_dp, &dummy_off);
+	if (res == KDUMP_ERR_NODATA) {
+		clear_error(ctx);
+		res = KDUMP_OK;
+	}
+	return res;
+}
+
 static kdump_status
 lkcd_max_pfn_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
 {
@@ -701,22 +1243,9 @@ lkcd_max_pfn_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
 
 	mutex_lock(&lkcdp->pfn_block_mutex);
 
-	if (lkcdp->last_offset != lkcdp->end_offset) {
-		struct dump_page dummy_dp;
-		off_t dummy_off;
-
-		mutex_lock(&ctx->shared->cache_lock);
-		res = search_page_desc(ctx, ~(kdump_pfn_t)0,
-				       &dummy_dp, &dummy_off);
-		mutex_unlock(&ctx->shared->cache_lock);
-		if (res == KDUMP_ERR_NODATA) {
-			clear_error(ctx);
-			res = KDUMP_OK;
-		}
-		if (res != KDUMP_OK)
-			res = set_error(ctx, res, "Cannot get max_pfn");
-	} else
-		res = KDUMP_OK;
+	res = scan_all_page_desc(ctx);
+	if (res != KDUMP_OK)
+		res = set_error(ctx, res, "Cannot get max_pfn");
 
 	parent_ops = lkcdp->max_pfn_override.template.parent->ops;
 	parent_revalidate = parent_ops ? parent_ops->revalidate : NULL;
@@ -735,6 +1264,128 @@ lkcd_max_pfn_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
 	return res;
 }
 
+/**  Report a PFN block as runs of present pages.
+ * @param st     Run iteration state.
+ * @param base   PFN corresponding to level-3 index zero.
+ * @param block  PFN block.
+ * @returns      Non-zero if the iteration should stop.
+ */
+static int
+pfn_block_runs(struct bmp_run_state *st, kdump_pfn_t base,
+	       const struct pfn_block *block)
+{
+	kdump_pfn_t start, end, pfn;
+	unsigned idx;
+
+	start = end = base + block->idx3;
+	for (idx = 0; idx < block->n; ++idx) {
+		if (!block->offs[idx])
+			continue;
+		pfn = base + block->idx3 + idx + 1;
+		if (pfn != end + 1) {
+			if (bmp_run_add(st, start, end))
+				return 1;
+			start = pfn;
+		}
+		end = pfn;
+	}
+	return bmp_run_add(st, start, end);
+}
+
+static kdump_status
+lkcd_iter_runs(kdump_errmsg_t *err, const kdump_bmp_t *bmp,
+	       struct bmp_run_state *st)
+{
+	struct kdump_shared *shared = bmp->priv;
+	struct lkcd_priv *lkcdp;
+	const struct pfn_block *block;
+	kdump_pfn_t base;
+	unsigned i, j;
+
+	if (st->first > UINT32_MAX)
+		return KDUMP_OK;
+
+	rwlock_rdlock(&shared->lock);
+	lkcdp = shared->fmtdata;
+	mutex_lock(&lkcdp->pfn_block_mutex);
+	for (i = pfn_idx1(st->first); i < lkcdp->l1_size; ++i) {
+		if (!lkcdp->pfn_level1[i])
+			continue;
+		for (j = 0; j < PFN_IDX2_SIZE; ++j) {
+			base = ((kdump_pfn_t)i << (PFN_IDX2_BITS + PFN_IDX3_BITS)) |
+				((kdump_pfn_t)j << PFN_IDX3_BITS);
+			if (base + PFN_IDX3_SIZE <= st->first)
+				continue;
+			for (block = lkcdp->pfn_level1[i][j]; block;
+			     block = block->next)
+				if (pfn_block_runs(st, base, block))
+					goto out;
+		}
+	}
+ out:
+	mutex_unlock(&lkcdp->pfn_block_mutex);
+	rwlock_unlock(&shared->lock);
+	return KDUMP_OK;
+}
+
+static void
+lkcd_bmp_cleanup(const kdump_bmp_t *bmp)
+{
+	struct kdump_shared *shared = bmp->priv;
+	shared_decref(shared);
+}
+
+static const struct kdump_bmp_ops lkcd_bmp_ops = {
+	.iter_runs = lkcd_iter_runs,
+	.cleanup = lkcd_bmp_cleanup,
+};
+
+/**  Create the file pagemap on first use.
+ *
+ * The pagemap is built from the PFN block tree, so all page
+ * descriptors must be scanned before it can be provided.
+ */
+static kdump_status
+lkcd_pagemap_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	struct lkcd_priv *lkcdp = ctx->shared->fmtdata;
+	attr_revalidate_fn *parent_revalidate;
+	const struct attr_ops *parent_ops;
+	kdump_attr_value_t val;
+	kdump_status res;
+
+	mutex_lock(&lkcdp->pfn_block_mutex);
+
+	res = scan_all_page_desc(ctx);
+	if (res != KDUMP_OK)
+		res = set_error(ctx, res, "Cannot get file pagemap");
+
+	parent_ops = lkcdp->pagemap_override.template.parent->ops;
+	parent_revalidate = parent_ops ? parent_ops->revalidate : NULL;
+	lkcdp->pagemap_override.ops.revalidate = parent_revalidate;
+
+	if (res == KDUMP_OK) {
+		val.bitmap = kdump_bmp_new(&lkcd_bmp_ops);
+		if (val.bitmap) {
+			val.bitmap->priv = ctx->shared;
+			/* Other reference count updates hold the shared
+			 * lock for writing, and this hook is serialized
+			 * by pfn_block_mutex.
+			 */
+			shared_incref_locked(ctx->shared);
+			res = set_attr(ctx, attr, ATTR_DEFAULT, &val);
+		} else
+			res = set_error(ctx, KDUMP_ERR_SYSTEM,
+					"Cannot allocate file pagemap");
+	}
+
+	mutex_unlock(&lkcdp->pfn_block_mutex);
+
+	if (res == KDUMP_OK && parent_revalidate)
+		res = parent_revalidate(ctx, attr);
+	return res;
+}
+
 static kdump_status
 lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
@@ -746,11 +1397,9 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 	void *buf;
 	kdump_status ret;
 
-	mutex_lock(&ctx->shared->cache_lock);
 	off = 0;
 	pfn = pio->addr.addr >> get_page_shift(ctx);
 	ret = get_page_desc(ctx, pfn, &dp, &off);
-	mutex_unlock(&ctx->shared->cache_lock);
 	if (ret != KDUMP_OK)
 		return ret;
 
@@ -798,7 +1447,8 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 					 "Wrong uncompressed size: %lu",
 					 (unsigned long) retlen);
 	} else if (lkcdp->compression == DUMP_COMPRESS_GZIP) {
-		ret = uncompress_page_gzip(ctx, pio->chunk.data, buf, dp.dp_size);
+		ret = uncompress_page_gzip(ctx, lkcdp->zlib_slot,
+					   pio->chunk.data, buf, dp.dp_size);
 		if (ret != KDUMP_OK)
 			return ret;
 	} else
@@ -812,6 +1462,7 @@ lkcd_read_page(kdump_ctx_t *ctx, struct page_io *pio)
 static kdump_status
 lkcd_get_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
+	readahead_page(ctx, pio);
 	return cache_get_page(ctx, pio, lkcd_read_page);
 }
 
@@ -915,6 +1566,7 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 {
 	struct dump_header_common *dh = hdr;
 	struct lkcd_priv *lkcdp;
+	kdump_attr_value_t val;
 	kdump_status ret;
 
 	lkcdp = ctx_malloc(sizeof *lkcdp, ctx, "LKCD private data");
@@ -939,11 +1591,15 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 	}
 	lkcdp->pfn_level1 = NULL;
 	lkcdp->l1_size = 0;
+	lkcdp->index_path = NULL;
+	lkcdp->index_done = 0;
+	lkcdp->scan_ctx = NULL;
 
 	attr_add_override(gattr(ctx, GKI_page_size),
 			  &lkcdp->page_size_override);
 	lkcdp->page_size_override.ops.post_set = lkcd_realloc_compressed;
 	lkcdp->cbuf_slot = -1;
+	lkcdp->zlib_slot = -1;
 
 	ret = set_page_size(ctx, dump32toh(ctx, dh->dh_page_size));
 	if (ret != KDUMP_OK)
@@ -954,6 +1610,12 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 	lkcdp->max_pfn_override.ops.revalidate = lkcd_max_pfn_revalidate;
 	set_attr_number(ctx, gattr(ctx, GKI_max_pfn), ATTR_INVALID, 0);
 
+	attr_add_override(gattr(ctx, GKI_file_pagemap),
+			  &lkcdp->pagemap_override);
+	lkcdp->pagemap_override.ops.revalidate = lkcd_pagemap_revalidate;
+	val.bitmap = NULL;
+	set_attr(ctx, gattr(ctx, GKI_file_pagemap), ATTR_INVALID, &val);
+
 	set_addrspace_caps(ctx->xlat, ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR));
 
 	switch(lkcdp->version) {
@@ -984,6 +1646,22 @@ open_common(kdump_ctx_t *ctx, void *hdr)
 	if (ret != KDUMP_OK)
 		goto err_free;
 
+	/* Failure is not fatal; a temporary stream is used instead. */
+	if (lkcdp->compression == DUMP_COMPRESS_GZIP)
+		lkcdp->zlib_slot = per_ctx_alloc_zlib(ctx->shared);
+
+	/* The index is optional; errors are silently ignored. */
+	if (attr_isset(gattr(ctx, GKI_file_index))) {
+		lkcdp->index_path = strdup(
+			attr_value(gattr(ctx, GKI_file_index))->string);
+		if (lkcdp->index_path)
+			load_index(ctx);
+	}
+
+	if (get_background_scan(ctx) &&
+	    lkcdp->last_offset != lkcdp->end_offset)
+		start_scanner(ctx);
+
 	return KDUMP_OK;
 
   err_free:
@@ -1058,6 +1736,8 @@ lkcd_attr_cleanup(struct attr_dict *dict)
 			     &lkcdp->page_size_override);
 	attr_remove_override(dgattr(dict, GKI_max_pfn),
 			     &lkcdp->max_pfn_override);
+	attr_remove_override(dgattr(dict, GKI_file_pagemap),
+			     &lkcdp->pagemap_override);
 }
 
 static void
@@ -1065,10 +1745,14 @@ lkcd_cleanup(struct kdump_shared *shared)
 {
 	struct lkcd_priv *lkcdp = shared->fmtdata;
 
+	stop_scanner(lkcdp);
 	free_level1(lkcdp->pfn_level1, lkcdp->l1_size);
 	mutex_destroy(&lkcdp->pfn_block_mutex);
 	if (lkcdp->cbuf_slot >= 0)
 		per_ctx_free(shared, lkcdp->cbuf_slot);
+	if (lkcdp->zlib_slot >= 0)
+		per_ctx_free(shared, lkcdp->zlib_slot);
+	free(lkcdp->index_path);
 	free(lkcdp);
 	shared->fmtdata = NULL;
 }
@@ -102,10 +102,8 @@ file_fd_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
 			return ret;
 
 		ctx->shared->ops = NULL;
-		if (ctx->shared->cache) {
-			cache_free(ctx->shared->cache);
-			ctx->shared->cache = NULL;
-		}
+		if (ctx->shared->cache)
+			retire_cache_shards(ctx->shared);
 		clear_volatile_attrs(ctx);
 		clear_error(ctx);
 	}
@@ -293,26 +291,43 @@ const struct attr_ops ostype_ops = {
 	.pre_clear = ostype_clear_hook,
 };
 
+/**  Release all resources of a dump file object except shared data.
+ * @param ctx  Dump file object.
+ *
+ * The caller must hold the shared lock for writing. The reference to
+ * the shared data is not dropped, and @p ctx itself is not freed.
+ */
 void
-kdump_free(kdump_ctx_t *ctx)
+ctx_release_locked(kdump_ctx_t *ctx)
 {
 	struct kdump_shared *shared = ctx->shared;
 	int slot;
 
-	rwlock_wrlock(&shared->lock);
+	page_l1_free(ctx);
 
 	for (slot = 0; slot < PER_CTX_SLOTS; ++slot)
 		if (shared->per_ctx_size[slot])
-			free(ctx->data[slot]);
+			per_ctx_release(shared, ctx, slot);
 
 	addrxlat_ctx_decref(ctx->xlatctx);
 
 	list_del(&ctx->xlat_list);
 	xlat_decref(ctx->xlat);
 
-	attr_dict_decref(ctx->dict);
+	if (ctx->dict)
+		attr_dict_decref(ctx->dict);
 
 	list_del(&ctx->list);
+}
+
+void
+kdump_free(kdump_ctx_t *ctx)
+{
+	struct kdump_shared *shared = ctx->shared;
+
+	rwlock_wrlock(&shared->lock);
+
+	ctx_release_locked(ctx);
 	if (shared_decref_locked(shared))
 		rwlock_unlock(&shared->lock);
 
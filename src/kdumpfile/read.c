@@ -34,6 +34,116 @@
 
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <time.h>
+
+/**  Release idle pages from the per-context page cache.
+ * @param ctx  Dump file object.
+ * @returns    Non-zero if any page was released.
+ *
+ * Pages which are currently in use are kept.
+ */
+static int
+page_l1_release(kdump_ctx_t *ctx)
+{
+	struct page_l1_slot *slot;
+	int ret = 0;
+
+	for (slot = ctx->l1; slot < ctx->l1 + ctx->l1size; ++slot) {
+		if (!slot->shard || slot->users)
+			continue;
+		cache_shard_put(slot->shard, slot->ce);
+		slot->shard = NULL;
+		ret = 1;
+	}
+	return ret;
+}
+
+/**  Page cache wait parameters.
+ */
+struct cache_wait {
+	/** Negative if not yet initialized, zero if waiting is disabled,
+	 *  positive if waiting is enabled. */
+	int enabled;
+
+	/** Wait deadline, or @c NULL to wait indefinitely. */
+	struct timespec *deadline;
+
+	/** Storage for the wait deadline. */
+	struct timespec ts;
+};
+
+/**  Initialize page cache wait parameters.
+ * @param ctx  Dump file object.
+ * @param cw   Wait parameters.
+ *
+ * The parameters are taken from "cache.wait" and "cache.wait_timeout"
+ * attributes. The timeout is converted to an absolute deadline, so all
+ * waits during one page lookup share the same deadline.
+ */
+static void
+init_cache_wait(kdump_ctx_t *ctx, struct cache_wait *cw)
+{
+	struct attr_data *attr;
+	kdump_num_t timeout;
+
+	if (cw->enabled >= 0)
+		return;
+
+	attr = gattr(ctx, GKI_cache_wait);
+	cw->enabled = attr_isset(attr) && attr_value(attr)->number;
+	cw->deadline = NULL;
+	if (!cw->enabled)
+		return;
+
+	attr = gattr(ctx, GKI_cache_wait_timeout);
+	if (!attr_isset(attr) || !(timeout = attr_value(attr)->number))
+		return;
+
+	clock_gettime(CLOCK_REALTIME, &cw->ts);
+	cw->ts.tv_sec += timeout / 1000;
+	cw->ts.tv_nsec += (timeout % 1000) * 1000000;
+	if (cw->ts.tv_nsec >= 1000000000) {
+		++cw->ts.tv_sec;
+		cw->ts.tv_nsec -= 1000000000;
+	}
+	cw->deadline = &cw->ts;
+}
+
+/**  Wait until an entry in a page cache shard is released.
+ * @param ctx    Dump file object.
+ * @param shard  Page cache shard (locked).
+ * @param cw     Wait parameters.
+ * @param force  Wait (without a deadline) even if waiting is disabled.
+ * @returns      Zero if the wait succeeded, non-zero otherwise.
+ *
+ * If waiting is disabled and @p force is zero, return non-zero
+ * immediately. Read-ahead workers never wait.
+ */
+static int
+cache_shard_wait(kdump_ctx_t *ctx, struct cache_shard *shard,
+		 struct cache_wait *cw, int force)
+{
+	int ret;
+
+	/* Read-ahead workers hold the shared lock for reading, and
+	 * free_pool() joins them with the lock held for writing, so
+	 * they must never block here.
+	 */
+	if (ctx->ra.worker)
+		return -1;
+
+	init_cache_wait(ctx, cw);
+	if (!cw->enabled && !force)
+		return -1;
+
+	++shard->nwait;
+	ret = cw->deadline
+		? cond_timedwait(&shard->cond, &shard->lock, cw->deadline)
+		: cond_wait(&shard->cond, &shard->lock);
+	--shard->nwait;
+	return ret;
+}
 
 /** Get a page from the default cache.
  *
@@ -44,35 +154,110 @@
  *
  * If the page is not currently found in the cache, read it using
  * the read function.
+ *
+ * If the cache is fully utilized, or if another thread is reading the
+ * same page, wait if "cache.wait" is non-zero. Otherwise, return
+ * @ref KDUMP_ERR_BUSY if the cache is fully utilized, or read the page
+ * concurrently with the other thread. If "cache.decompress_threads"
+ * are running, always wait for a page which is being read.
  */
 kdump_status
 cache_get_page(kdump_ctx_t *ctx, struct page_io *pio, read_page_fn *fn)
 {
+	cache_key_t key = pio->addr.addr | pio->addr.as;
+	struct cache_wait cw = { .enabled = -1 };
+	struct page_l1_slot *slot;
+	struct cache_shard *shard;
 	struct cache_entry *entry;
 	kdump_status ret;
 
-	mutex_lock(&ctx->shared->cache_lock);
 	pio->chunk.nent = 1;
-	pio->chunk.embed_fces->cache = ctx->shared->cache;
-	entry = cache_get_entry(pio->chunk.embed_fces->cache,
-				pio->addr.addr | pio->addr.as);
-	mutex_unlock(&ctx->shared->cache_lock);
-	if (!entry)
-		return set_error(ctx, KDUMP_ERR_BUSY,
-				 "Cache is fully utilized");
+	slot = NULL;
+	if (ctx->l1size) {
+		slot = get_page_l1_slot(ctx, key);
+		if (slot->shard && slot->key == key) {
+			++slot->users;
+			pio->chunk.data = slot->ce->data;
+			pio->chunk.embed_fces->ce = slot->ce;
+			pio->chunk.embed_fces->cache = NULL;
+			return KDUMP_OK;
+		}
+	}
 
-	pio->chunk.data = entry->data;
+	shard = get_cache_shard(ctx->shared, key);
+	mutex_lock(&shard->lock);
+	while (! (entry = cache_get_entry(shard->cache, key)) ) {
+		if (ctx->l1size) {
+			int released;
+
+			/* Other shards may be locked while releasing. */
+			mutex_unlock(&shard->lock);
+			released = page_l1_release(ctx);
+			mutex_lock(&shard->lock);
+			if (released)
+				continue;
+		}
+		if (cache_shard_wait(ctx, shard, &cw, 0)) {
+			mutex_unlock(&shard->lock);
+			return set_error(ctx, KDUMP_ERR_BUSY,
+					 "Cache is fully utilized");
+		}
+	}
+
+	/* Wait for another thread which is reading the same page.
+	 * Always wait for read-ahead, but do not read ahead twice.
+	 */
+	while (!cache_entry_valid(entry) && entry->loading) {
+		if (ctx->ra.worker) {
+			cache_discard(shard->cache, entry);
+			mutex_unlock(&shard->lock);
+			return set_error(ctx, KDUMP_ERR_BUSY,
+					 "Page is being read");
+		}
+		if (cache_shard_wait(ctx, shard, &cw, !!ctx->shared->rapool)) {
+			if (!cw.enabled && !ctx->shared->rapool)
+				break;
+			cache_discard(shard->cache, entry);
+			cache_shard_wake(shard);
+			mutex_unlock(&shard->lock);
+			return set_error(ctx, KDUMP_ERR_BUSY,
+					 "Timeout waiting for a page read");
+		}
+	}
+
+	pio->chunk.embed_fces->cache = shard->cache;
 	pio->chunk.embed_fces->ce = entry;
-	if (cache_entry_valid(entry))
-		return KDUMP_OK;
-
-	ret = fn(ctx, pio);
-	mutex_lock(&ctx->shared->cache_lock);
-	if (ret == KDUMP_OK)
-		cache_insert(pio->chunk.embed_fces->cache, entry);
-	else
-		cache_discard(pio->chunk.embed_fces->cache, entry);
-	mutex_unlock(&ctx->shared->cache_lock);
+	pio->chunk.data = entry->data;
+	if (cache_entry_valid(entry)) {
+		mutex_unlock(&shard->lock);
+		ret = KDUMP_OK;
+	} else {
+		entry->loading = 1;
+		mutex_unlock(&shard->lock);
+
+		ret = fn(ctx, pio);
+
+		mutex_lock(&shard->lock);
+		entry->loading = 0;
+		if (ret == KDUMP_OK)
+			cache_insert(shard->cache, entry);
+		else
+			cache_discard(shard->cache, entry);
+		cache_shard_wake(shard);
+		mutex_unlock(&shard->lock);
+	}
+
+	/* Pin the page in the per-context cache unless the slot is busy. */
+	if (ret == KDUMP_OK && slot && !slot->users) {
+		if (slot->shard)
+			cache_shard_put(slot->shard, slot->ce);
+		mutex_lock(&shard->lock);
+		++entry->refcnt;
+		mutex_unlock(&shard->lock);
+		slot->key = key;
+		slot->shard = shard;
+		slot->ce = entry;
+	}
 	return ret;
 }
 
@@ -83,6 +268,41 @@ cache_get_page(kdump_ctx_t *ctx, struct page_io *pio, read_page_fn *fn)
 void
 cache_put_page(kdump_ctx_t *ctx, struct page_io *pio)
 {
+	struct fcache_entry *fce = pio->chunk.embed_fces;
+	cache_key_t key = pio->addr.addr | pio->addr.as;
+	struct page_l1_slot *slot;
+	struct cache_shard *shard;
+
+	if (pio->chunk.nent == 1) {
+		/* Pages from the per-context cache hold no extra reference. */
+		if (!fce->cache) {
+			if (ctx->l1size) {
+				slot = get_page_l1_slot(ctx, key);
+				if (slot->shard && slot->ce == fce->ce &&
+				    slot->users) {
+					--slot->users;
+					return;
+				}
+			}
+			if (page_l1_put_detached(ctx, fce->ce))
+				return;
+		}
+
+		/* Page cache entries may have waiters. */
+		shard = get_cache_shard(ctx->shared, key);
+		if (shard && fce->cache == shard->cache) {
+			cache_shard_put(shard, fce->ce);
+			return;
+		}
+
+		/* The page may come from replaced page cache shards.
+		 * These cannot all be freed while this page is in use.
+		 */
+		if (fce->cache && ctx->shared->retired &&
+		    put_retired_entry(ctx->shared, fce->cache, fce->ce))
+			return;
+	}
+
 	fcache_put_chunk(&pio->chunk);
 }
 
@@ -139,7 +359,7 @@ get_page(kdump_ctx_t *ctx, struct page_io *pio)
 		: get_page_xlat(ctx, pio);
 }
 
-/**  Internal version of @ref kdump_read
+/**  Read data page by page.
  * @param         ctx      Dump file object.
  * @param[in]     as       Address space of @p addr.
  * @param[in]     addr     Any type of address.
@@ -147,14 +367,11 @@ get_page(kdump_ctx_t *ctx, struct page_io *pio)
  * @param[in,out] plength  Length of the buffer.
  * @returns                Error status.
  *
- * Use this function internally if the shared lock is already held
- * (for reading or writing).
- *
- * @sa kdump_read
+ * Each page is translated separately if needed.
  */
-kdump_status
-read_locked(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
-	    void *buffer, size_t *plength)
+static kdump_status
+read_pages(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	   void *buffer, size_t *plength)
 {
 	struct page_io pio;
 	size_t remain;
@@ -186,6 +403,118 @@ read_locked(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	return ret;
 }
 
+/**  State of a range-translated read.
+ */
+struct read_range {
+	kdump_ctx_t *ctx;	/**< Dump file object. */
+	char *buffer;		/**< Buffer for the next run. */
+	size_t done;		/**< Number of bytes read so far. */
+	kdump_status status;	/**< Status of the last read. */
+};
+
+/**  Read one run of a range-translated read.
+ * @param data  Read state (@c struct read_range).
+ * @param src   First source address of the run.
+ * @param dst   First translated address of the run.
+ * @param len   Length of the run in bytes.
+ * @returns     Error status.
+ *
+ * If the read fails, @ref ADDRXLAT_ERR_CUSTOM_BASE is returned, and
+ * the libkdumpfile error status is stored in @c status.
+ */
+static addrxlat_status
+read_range_op(void *data, const addrxlat_fulladdr_t *src,
+	      const addrxlat_fulladdr_t *dst, addrxlat_addr_t len)
+{
+	struct read_range *rr = data;
+	size_t partlen = len;
+
+	rr->status = read_pages(rr->ctx, dst->as, dst->addr,
+				rr->buffer, &partlen);
+	rr->buffer += partlen;
+	rr->done += partlen;
+	return rr->status == KDUMP_OK
+		? ADDRXLAT_OK
+		: ADDRXLAT_ERR_CUSTOM_BASE;
+}
+
+/**  Read data with range address translation.
+ * @param         ctx      Dump file object.
+ * @param[in]     as       Address space of @p addr.
+ * @param[in]     addr     Any type of address.
+ * @param[out]    buffer   Buffer to receive data.
+ * @param[in,out] plength  Length of the buffer.
+ * @returns                Error status.
+ *
+ * The whole buffer is translated with @ref addrxlat_op_range, so
+ * each contiguous run of pages is translated only once.
+ */
+static kdump_status
+read_xlat_range(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+		void *buffer, size_t *plength)
+{
+	addrxlat_op_range_ctl_t ctl;
+	addrxlat_fulladdr_t faddr;
+	struct read_range rr;
+	addrxlat_status xlaterr;
+	kdump_status status;
+
+	status = revalidate_xlat(ctx);
+	if (status != KDUMP_OK) {
+		*plength = 0;
+		return status;
+	}
+
+	rr.ctx = ctx;
+	rr.buffer = buffer;
+	rr.done = 0;
+	rr.status = KDUMP_OK;
+
+	ctl.ctx = ctx->xlatctx;
+	ctl.sys = ctx->xlat->xlatsys;
+	ctl.op = read_range_op;
+	ctl.data = &rr;
+	ctl.caps = ctx->xlat->xlat_caps;
+
+	faddr.addr = addr;
+	faddr.as = as;
+	xlaterr = addrxlat_op_range(&ctl, &faddr, *plength);
+	*plength = rr.done;
+	if (rr.status != KDUMP_OK)
+		return rr.status;
+	if (xlaterr != ADDRXLAT_OK)
+		return set_error(ctx, addrxlat2kdump(ctx, xlaterr),
+				 "Cannot get page I/O address");
+	return KDUMP_OK;
+}
+
+/**  Internal version of @ref kdump_read
+ * @param         ctx      Dump file object.
+ * @param[in]     as       Address space of @p addr.
+ * @param[in]     addr     Any type of address.
+ * @param[out]    buffer   Buffer to receive data.
+ * @param[in,out] plength  Length of the buffer.
+ * @returns                Error status.
+ *
+ * Use this function internally if the shared lock is already held
+ * (for reading or writing).
+ *
+ * Reads which need address translation are translated by ranges,
+ * unless custom (Xen p2m) translation methods are used; the extent
+ * of these translations is not known.
+ *
+ * @sa kdump_read
+ */
+kdump_status
+read_locked(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	    void *buffer, size_t *plength)
+{
+	if (ctx->xlat->xlat_caps & ADDRXLAT_CAPS(as) ||
+	    get_xen_xlat(ctx) == KDUMP_XEN_NONAUTO)
+		return read_pages(ctx, as, addr, buffer, plength);
+	return read_xlat_range(ctx, as, addr, buffer, plength);
+}
+
 kdump_status
 kdump_read(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	    void *buffer, size_t *plength)
@@ -199,6 +528,199 @@ kdump_read(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
 	return ret;
 }
 
+/**  Page-sized part of a vectored read request.
+ */
+struct readv_frag {
+	kdump_addr_t page;	/**< Page-aligned address. */
+	size_t idx;		/**< Index of the request. */
+};
+
+static int
+readv_frag_cmp(const void *a, const void *b)
+{
+	const struct readv_frag *fa = a, *fb = b;
+
+	if (fa->page != fb->page)
+		return fa->page < fb->page ? -1 : 1;
+	return fa->idx < fb->idx ? -1 : fa->idx > fb->idx;
+}
+
+/**  Internal version of @ref kdump_readv.
+ * @param         ctx  Dump file object.
+ * @param[in]     as   Address space of all addresses in @p vec.
+ * @param[in,out] vec  Read requests.
+ * @param[in]     n    Number of elements in @p vec.
+ * @returns            Error status.
+ *
+ * Use this function internally if the shared lock is already held
+ * (for reading or writing).
+ *
+ * @sa kdump_readv
+ */
+kdump_status
+readv_locked(kdump_ctx_t *ctx, kdump_addrspace_t as,
+	     struct kdump_iovec *vec, size_t n)
+{
+	size_t pgsz = get_page_size(ctx);
+	struct readv_frag *frags, *frag, *end;
+	struct page_io pio;
+	size_t i, nfrags, errlen;
+	kdump_addr_t cnt;
+	kdump_status ret, status;
+
+	/* Split requests into page-sized fragments. */
+	ret = KDUMP_OK;
+	errlen = 0;
+	nfrags = 0;
+	for (i = 0; i < n; ++i) {
+		vec[i].status = KDUMP_OK;
+		if (!vec[i].len)
+			continue;
+		if (vec[i].len - 1 > KDUMP_ADDR_MAX - vec[i].addr) {
+			vec[i].status = KDUMP_ERR_INVALID;
+			if (ret == KDUMP_OK) {
+				ret = set_error(ctx, KDUMP_ERR_INVALID,
+						"Read at 0x%"ADDRXLAT_PRIxADDR
+						" beyond end of address space",
+						vec[i].addr);
+				errlen = strlen(err_str(&ctx->err));
+			}
+			continue;
+		}
+		cnt = (page_align(ctx, vec[i].addr + vec[i].len - 1)
+		       - page_align(ctx, vec[i].addr)) / pgsz + 1;
+		if (cnt > SIZE_MAX / sizeof *frags - nfrags) {
+			for (i = 0; i < n; ++i)
+				vec[i].status = KDUMP_ERR_INVALID;
+			return set_error(ctx, KDUMP_ERR_INVALID,
+					 "Too many pages to read");
+		}
+		nfrags += cnt;
+	}
+	frags = ctx_malloc(nfrags * sizeof *frags, ctx, "read fragments");
+	if (!frags && nfrags) {
+		for (i = 0; i < n; ++i)
+			vec[i].status = KDUMP_ERR_SYSTEM;
+		return KDUMP_ERR_SYSTEM;
+	}
+
+	frag = frags;
+	for (i = 0; i < n; ++i) {
+		kdump_addr_t page, last;
+
+		if (!vec[i].len || vec[i].status != KDUMP_OK)
+			continue;
+		page = page_align(ctx, vec[i].addr);
+		last = page_align(ctx, vec[i].addr + vec[i].len - 1);
+		do {
+			frag->page = page;
+			frag->idx = i;
+			++frag;
+		} while ((page += pgsz) != last + pgsz);
+	}
+	qsort(frags, nfrags, sizeof *frags, readv_frag_cmp);
+
+	/* Get each page once and copy data to all fragments. */
+	end = frags + nfrags;
+	for (frag = frags; frag < end; ) {
+		struct readv_frag *next;
+
+		for (next = frag + 1; next < end; ++next)
+			if (next->page != frag->page)
+				break;
+
+		pio.addr.as = as;
+		pio.addr.addr = frag->page;
+		status = get_page(ctx, &pio);
+		if (status != KDUMP_OK) {
+			if (ret == KDUMP_OK) {
+				ret = status;
+				errlen = strlen(err_str(&ctx->err));
+			}
+			for ( ; frag < next; ++frag)
+				if (vec[frag->idx].status == KDUMP_OK)
+					vec[frag->idx].status = status;
+			continue;
+		}
+
+		for ( ; frag < next; ++frag) {
+			struct kdump_iovec *iov = &vec[frag->idx];
+			kdump_addr_t start, stop;
+
+			start = iov->addr > frag->page
+				? iov->addr
+				: frag->page;
+			stop = iov->addr + iov->len - 1 < frag->page + pgsz - 1
+				? iov->addr + iov->len
+				: frag->page + pgsz;
+			memcpy(iov->buf + (start - iov->addr),
+			       pio.chunk.data + (start - frag->page),
+			       stop - start);
+		}
+		put_page(ctx, &pio);
+	}
+	free(frags);
+
+	/* Report only the first failure. */
+	if (ret != KDUMP_OK)
+		err_truncate(&ctx->err, errlen);
+	return ret;
+}
+
+kdump_status
+kdump_readv(kdump_ctx_t *ctx, kdump_addrspace_t as,
+	    struct kdump_iovec *vec, size_t n)
+{
+	kdump_status ret;
+
+	clear_error(ctx);
+	rwlock_rdlock(&ctx->shared->lock);
+	ret = readv_locked(ctx, as, vec, n);
+	rwlock_unlock(&ctx->shared->lock);
+	return ret;
+}
+
+kdump_status
+kdump_get_page(kdump_ctx_t *ctx, kdump_addrspace_t as, kdump_addr_t addr,
+	       const void **pdata, kdump_page_t **ppage)
+{
+	kdump_page_t *page;
+	kdump_status ret;
+
+	clear_error(ctx);
+
+	page = ctx_malloc(sizeof *page, ctx, "borrowed page");
+	if (!page)
+		return KDUMP_ERR_SYSTEM;
+	page->ctx = ctx;
+
+	rwlock_rdlock(&ctx->shared->lock);
+	page->pio.addr.as = as;
+	page->pio.addr.addr = page_align(ctx, addr);
+	ret = get_page(ctx, &page->pio);
+	rwlock_unlock(&ctx->shared->lock);
+
+	if (ret != KDUMP_OK) {
+		free(page);
+		return ret;
+	}
+
+	*pdata = page->pio.chunk.data;
+	*ppage = page;
+	return KDUMP_OK;
+}
+
+void
+kdump_put_page(kdump_page_t *page)
+{
+	kdump_ctx_t *ctx = page->ctx;
+
+	rwlock_rdlock(&ctx->shared->lock);
+	put_page(ctx, &page->pio);
+	rwlock_unlock(&ctx->shared->lock);
+	free(page);
+}
+
 /**  Internal version of @ref kdump_read_string.
  * @param      ctx   Dump file object.
  * @param[in]  as    Address space of @c addr.
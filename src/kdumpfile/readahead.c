@@ -0,0 +1,329 @@
+/** @internal @file src/kdumpfile/readahead.c
+ * @brief Parallel read-ahead of compressed pages.
+ */
+/* Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of pages read ahead per worker thread. */
+#define READAHEAD_PAGES_PER_THREAD	8
+
+/** Maximum number of decompression threads. */
+#define MAX_DECOMPRESS_THREADS		256
+
+/**  Read-ahead worker thread.
+ */
+struct readahead_worker {
+	struct readahead_pool *pool; /**< Worker pool. */
+	kdump_ctx_t *ctx;	/**< Private dump file object. */
+	thread_t thread;	/**< Worker thread. */
+};
+
+/**  Pool of read-ahead worker threads.
+ *
+ * The pool is shared by all dump file objects of a dump file. Readers
+ * queue pages which are likely to be needed soon, and the workers read
+ * them into the page cache.
+ *
+ * Each worker uses its own dump file object, so per-context data (such
+ * as decompression buffers) need not be shared. These objects do not
+ * hold a reference to the shared data; the pool is stopped before the
+ * shared data is freed.
+ */
+struct readahead_pool {
+	mutex_t mutex;		/**< Protects the queue and @c stop. */
+	cond_t cond;		/**< Signalled when requests are queued. */
+	int stop;		/**< Non-zero if workers should exit. */
+
+	addrxlat_fulladdr_t *queue; /**< Ring buffer of page addresses. */
+	unsigned qsize;		/**< Capacity of @c queue. */
+	unsigned qhead;		/**< Index of the oldest request. */
+	unsigned qlen;		/**< Number of queued requests. */
+
+	/** Number of pages read ahead of a sequential reader. */
+	unsigned window;
+
+	unsigned nworkers;	/**< Number of running workers. */
+	struct readahead_worker workers[]; /**< Worker threads. */
+};
+
+/**  Read-ahead worker thread function.
+ * @param arg  Worker (struct readahead_worker).
+ * @returns    Always @c NULL.
+ *
+ * Pages are read with a shared lock. If the lock cannot be acquired
+ * immediately, the request is dropped, because the lock owner may be
+ * waiting for this thread to exit.
+ */
+static void *
+readahead_worker(void *arg)
+{
+	struct readahead_worker *worker = arg;
+	struct readahead_pool *pool = worker->pool;
+	kdump_ctx_t *ctx = worker->ctx;
+	struct page_io pio;
+
+	mutex_lock(&pool->mutex);
+	for (;;) {
+		while (!pool->stop && !pool->qlen)
+			cond_wait(&pool->cond, &pool->mutex);
+		if (pool->stop)
+			break;
+
+		pio.addr = pool->queue[pool->qhead];
+		pool->qhead = (pool->qhead + 1) % pool->qsize;
+		--pool->qlen;
+		mutex_unlock(&pool->mutex);
+
+		if (!rwlock_tryrdlock(&ctx->shared->lock)) {
+			clear_error(ctx);
+			if (ctx->shared->ops->get_page(ctx, &pio) == KDUMP_OK)
+				put_page(ctx, &pio);
+			rwlock_unlock(&ctx->shared->lock);
+		}
+
+		mutex_lock(&pool->mutex);
+	}
+	mutex_unlock(&pool->mutex);
+
+	return NULL;
+}
+
+/**  Free a worker dump file object.
+ * @param ctx  Worker dump file object.
+ */
+static void
+free_worker_ctx(kdump_ctx_t *ctx)
+{
+	ctx_release_locked(ctx);
+	err_cleanup(&ctx->err);
+	free(ctx);
+}
+
+/**  Stop all workers and free a read-ahead pool.
+ * @param pool  Read-ahead pool.
+ *
+ * The shared lock must be held for writing by the caller.
+ */
+static void
+free_pool(struct readahead_pool *pool)
+{
+	unsigned i;
+
+	mutex_lock(&pool->mutex);
+	pool->stop = 1;
+	cond_broadcast(&pool->cond);
+	mutex_unlock(&pool->mutex);
+
+	for (i = 0; i < pool->nworkers; ++i) {
+		thread_join(pool->workers[i].thread, NULL);
+		free_worker_ctx(pool->workers[i].ctx);
+	}
+
+	cond_destroy(&pool->cond);
+	mutex_destroy(&pool->mutex);
+	free(pool->queue);
+	free(pool);
+}
+
+/**  Start a read-ahead pool.
+ * @param ctx       Dump file object.
+ * @param nthreads  Number of worker threads.
+ * @returns         Error status.
+ *
+ * The shared lock must be held for writing by the caller.
+ */
+static kdump_status
+readahead_start(kdump_ctx_t *ctx, unsigned nthreads)
+{
+	struct readahead_pool *pool;
+	struct readahead_worker *worker;
+	kdump_status status;
+	int res;
+
+	pool = ctx_malloc(sizeof(*pool) + nthreads * sizeof(pool->workers[0]),
+			  ctx, "read-ahead pool");
+	if (!pool)
+		return KDUMP_ERR_SYSTEM;
+	memset(pool, 0, sizeof *pool);
+	pool->window = nthreads * READAHEAD_PAGES_PER_THREAD;
+	pool->qsize = 4 * pool->window;
+	pool->queue = ctx_malloc(pool->qsize * sizeof(*pool->queue),
+				 ctx, "read-ahead queue");
+	if (!pool->queue) {
+		free(pool);
+		return KDUMP_ERR_SYSTEM;
+	}
+	if (mutex_init(&pool->mutex, NULL)) {
+		free(pool->queue);
+		free(pool);
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot initialize read-ahead mutex");
+	}
+	if (cond_init(&pool->cond, NULL)) {
+		mutex_destroy(&pool->mutex);
+		free(pool->queue);
+		free(pool);
+		return set_error(ctx, KDUMP_ERR_SYSTEM,
+				 "Cannot initialize read-ahead condition");
+	}
+
+	status = KDUMP_OK;
+	while (pool->nworkers < nthreads) {
+		worker = &pool->workers[pool->nworkers];
+		worker->pool = pool;
+		worker->ctx = clone_locked(ctx, 0);
+		if (!worker->ctx) {
+			status = set_error(ctx, KDUMP_ERR_SYSTEM,
+					   "Cannot allocate worker context");
+			break;
+		}
+		worker->ctx->ra.worker = 1;
+		page_l1_resize(worker->ctx, 0);
+		shared_decref_locked(ctx->shared);
+
+		res = thread_create(&worker->thread, readahead_worker, worker);
+		if (res) {
+			free_worker_ctx(worker->ctx);
+			status = set_error(ctx, KDUMP_ERR_SYSTEM,
+					   "Cannot create worker thread: %s",
+					   strerror(res));
+			break;
+		}
+		++pool->nworkers;
+	}
+
+	if (status != KDUMP_OK) {
+		free_pool(pool);
+		return status;
+	}
+
+	ctx->shared->rapool = pool;
+	return KDUMP_OK;
+}
+
+/**  Stop the read-ahead pool.
+ * @param shared  Dump file shared data.
+ *
+ * The shared lock must be held for writing by the caller.
+ */
+void
+readahead_stop(struct kdump_shared *shared)
+{
+	struct readahead_pool *pool = shared->rapool;
+
+	if (pool) {
+		shared->rapool = NULL;
+		free_pool(pool);
+	}
+}
+
+/**  Queue pages after a sequentially accessed page.
+ * @param ctx  Dump file object.
+ * @param pio  Page I/O control of the accessed page.
+ *
+ * If @p pio immediately follows the previously accessed page, queue
+ * the following pages for the read-ahead workers. Otherwise, only
+ * remember the position.
+ */
+void
+readahead_page(kdump_ctx_t *ctx, const struct page_io *pio)
+{
+	struct readahead_pool *pool = ctx->shared->rapool;
+	struct readahead_state *ra = &ctx->ra;
+	addrxlat_fulladdr_t *req;
+	addrxlat_addr_t pgsz, end;
+
+	if (!pool || ra->worker)
+		return;
+
+	pgsz = get_page_size(ctx);
+	if (pio->addr.as != ra->next.as || pio->addr.addr != ra->next.addr) {
+		/* Another access to the last page keeps the state. */
+		if (pio->addr.as == ra->next.as &&
+		    pio->addr.addr + pgsz == ra->next.addr)
+			return;
+		ra->next.as = pio->addr.as;
+		ra->next.addr = pio->addr.addr + pgsz;
+		ra->end = ra->next.addr;
+		return;
+	}
+
+	ra->next.addr += pgsz;
+	if (ra->end < ra->next.addr)
+		ra->end = ra->next.addr;
+	end = ra->next.addr + pool->window * pgsz;
+
+	mutex_lock(&pool->mutex);
+	while (ra->end < end && pool->qlen < pool->qsize) {
+		req = &pool->queue[(pool->qhead + pool->qlen) % pool->qsize];
+		req->addr = ra->end;
+		req->as = ra->next.as;
+		++pool->qlen;
+		ra->end += pgsz;
+	}
+	cond_broadcast(&pool->cond);
+	mutex_unlock(&pool->mutex);
+}
+
+static kdump_status
+cache_decompress_threads_pre_hook(kdump_ctx_t *ctx, struct attr_data *attr,
+				  kdump_attr_value_t *val)
+{
+	if (val->number > MAX_DECOMPRESS_THREADS)
+		return set_error(ctx, KDUMP_ERR_INVALID,
+				 "Too many decompression threads (max %u)",
+				 MAX_DECOMPRESS_THREADS);
+	return KDUMP_OK;
+}
+
+static kdump_status
+cache_decompress_threads_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	readahead_stop(ctx->shared);
+	return attr_value(attr)->number
+		? readahead_start(ctx, attr_value(attr)->number)
+		: KDUMP_OK;
+}
+
+static void
+cache_decompress_threads_clear_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	readahead_stop(ctx->shared);
+}
+
+const struct attr_ops cache_decompress_threads_ops = {
+	.pre_set = cache_decompress_threads_pre_hook,
+	.post_set = cache_decompress_threads_post_hook,
+	.pre_clear = cache_decompress_threads_clear_hook,
+};
@@ -0,0 +1,311 @@
+/** @internal @file src/kdumpfile/test-bitmap.c
+ * @brief Test raw bitmap functions.
+ */
+/* Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define TEST_OK     0
+#define TEST_FAIL   1
+#define TEST_ERR   99
+
+/** Size of the bitmap used for correctness tests (in bytes). */
+#define TEST_SIZE	4096
+
+/** Number of random ranges used to test set_bits and clear_bits. */
+#define TEST_RANGES	10000
+
+/** Size of the sparse bitmap (in bytes). */
+#define SPARSE_SIZE	(1 << 20)
+
+/** Distance between isolated bits in the sparse bitmap (in bytes).
+ * This is deliberately not a multiple of any vector size.
+ */
+#define SPARSE_STRIDE	4099
+
+static inline int
+test_bit(const unsigned char *buf, size_t idx)
+{
+	return (buf[idx >> 3] >> (idx & 7)) & 1;
+}
+
+/** Reference implementation of skip_clear_bits and skip_set_bits. */
+static size_t
+ref_skip_bits(const unsigned char *buf, size_t size, size_t idx, int value)
+{
+	if (idx >= size << 3)
+		return idx;
+	while (idx < size << 3 && test_bit(buf, idx) != value)
+		++idx;
+	return idx;
+}
+
+/** Fill a buffer with random runs of 0x00 and 0xff bytes.
+ * Short runs are more likely, but some runs are long enough to
+ * exercise the vector loops.
+ */
+static void
+random_runs(unsigned char *buf, size_t size)
+{
+	unsigned char fill = 0;
+	size_t len;
+
+	while (size) {
+		len = rand() % 8 ? rand() % 16 : rand() % 1024;
+		if (len > size)
+			len = size;
+		memset(buf, fill, len);
+		buf += len;
+		size -= len;
+		if (size && rand() % 4 == 0) {
+			*buf++ = rand();
+			--size;
+		}
+		fill = ~fill;
+	}
+}
+
+static int
+check_skip_bytes(const struct skip_bytes_impl *impl,
+		 const unsigned char *buf)
+{
+	const unsigned char *p, *end, *expect, *got;
+	unsigned char fill;
+	size_t start;
+
+	for (start = 0; start < TEST_SIZE; ++start) {
+		p = buf + start;
+		end = p + rand() % (TEST_SIZE - start + 1);
+		for (fill = 0x00; ; fill = 0xff) {
+			expect = skip_bytes_impls[0].fn(p, end, fill);
+			got = impl->fn(p, end, fill);
+			if (got != expect) {
+				printf("%s: skip 0x%02x from %zu to %zu:"
+				       " got %zu, expected %zu\n",
+				       impl->name, fill, start,
+				       (size_t)(end - buf),
+				       (size_t)(got - buf),
+				       (size_t)(expect - buf));
+				return TEST_FAIL;
+			}
+			if (fill)
+				break;
+		}
+	}
+	return TEST_OK;
+}
+
+static int
+check_skip_bits(const unsigned char *buf)
+{
+	size_t idx, expect, got;
+
+	for (idx = 0; idx < (TEST_SIZE << 3) + 8; ++idx) {
+		expect = ref_skip_bits(buf, TEST_SIZE, idx, 1);
+		got = skip_clear_bits(buf, TEST_SIZE, idx);
+		if (got != expect) {
+			printf("skip_clear_bits(%zu) = %zu, expected %zu\n",
+			       idx, got, expect);
+			return TEST_FAIL;
+		}
+
+		expect = ref_skip_bits(buf, TEST_SIZE, idx, 0);
+		got = skip_set_bits(buf, TEST_SIZE, idx);
+		if (got != expect) {
+			printf("skip_set_bits(%zu) = %zu, expected %zu\n",
+			       idx, got, expect);
+			return TEST_FAIL;
+		}
+	}
+	return TEST_OK;
+}
+
+static int
+check_fill_bits(void)
+{
+	unsigned char buf[TEST_SIZE], ref[TEST_SIZE];
+	size_t start, end, idx;
+	int i, set;
+
+	random_runs(buf, sizeof buf);
+	memcpy(ref, buf, sizeof buf);
+	for (i = 0; i < TEST_RANGES; ++i) {
+		start = rand() % (TEST_SIZE << 3);
+		end = start + rand() % ((TEST_SIZE << 3) - start);
+		if (rand() % 2 == 0 && end - start > 64)
+			end = start + rand() % 64;
+		set = rand() % 2;
+
+		if (set)
+			set_bits(buf, start, end);
+		else
+			clear_bits(buf, start, end);
+		for (idx = start; idx <= end; ++idx)
+			if (set)
+				ref[idx >> 3] |= 1 << (idx & 7);
+			else
+				ref[idx >> 3] &= ~(1 << (idx & 7));
+
+		if (memcmp(buf, ref, sizeof buf)) {
+			printf("%s_bits(%zu, %zu) mismatch\n",
+			       set ? "set" : "clear", start, end);
+			return TEST_FAIL;
+		}
+	}
+	return TEST_OK;
+}
+
+static int
+test_correctness(void)
+{
+	unsigned char buf[TEST_SIZE];
+	const struct skip_bytes_impl *impl;
+	int ret, tmp;
+
+	random_runs(buf, sizeof buf);
+
+	ret = TEST_OK;
+	for (impl = skip_bytes_impls; impl->name; ++impl) {
+		if (impl->supported && !impl->supported()) {
+			printf("%s: not supported by this CPU\n", impl->name);
+			continue;
+		}
+		tmp = check_skip_bytes(impl, buf);
+		if (tmp > ret)
+			ret = tmp;
+	}
+
+	tmp = check_skip_bits(buf);
+	if (tmp > ret)
+		ret = tmp;
+
+	tmp = check_fill_bits();
+	if (tmp > ret)
+		ret = tmp;
+
+	return ret;
+}
+
+/** Scan a sparse bitmap with an implementation.
+ * @param impl  Implementation.
+ * @param buf   Bitmap of @ref SPARSE_SIZE bytes.
+ * @param fill  Value of all bytes except the isolated ones.
+ * @returns     Test status.
+ */
+static int
+check_sparse_impl(const struct skip_bytes_impl *impl,
+		  const unsigned char *buf, unsigned char fill)
+{
+	const unsigned char *p;
+	size_t expect;
+
+	p = buf;
+	expect = SPARSE_STRIDE - 1;
+	while ((p = impl->fn(p, buf + SPARSE_SIZE, fill)) <
+	       buf + SPARSE_SIZE) {
+		if (p - buf != expect) {
+			printf("%s: skip 0x%02x found %zu, expected %zu\n",
+			       impl->name, fill, (size_t)(p - buf), expect);
+			return TEST_FAIL;
+		}
+		++p;
+		expect += SPARSE_STRIDE;
+	}
+	if (expect < SPARSE_SIZE) {
+		printf("%s: skip 0x%02x missed %zu\n",
+		       impl->name, fill, expect);
+		return TEST_FAIL;
+	}
+	return TEST_OK;
+}
+
+/** Check all implementations with long runs of equal bytes.
+ */
+static int
+check_sparse(void)
+{
+	const struct skip_bytes_impl *impl;
+	unsigned char *buf;
+	size_t off;
+	int ret, tmp;
+
+	buf = malloc(SPARSE_SIZE);
+	if (!buf) {
+		perror("Cannot allocate sparse bitmap");
+		return TEST_ERR;
+	}
+
+	ret = TEST_OK;
+	for (impl = skip_bytes_impls; impl->name; ++impl) {
+		if (impl->supported && !impl->supported())
+			continue;
+
+		memset(buf, 0x00, SPARSE_SIZE);
+		for (off = SPARSE_STRIDE - 1; off < SPARSE_SIZE;
+		     off += SPARSE_STRIDE)
+			buf[off] = 0x10;
+		tmp = check_sparse_impl(impl, buf, 0x00);
+		if (tmp > ret)
+			ret = tmp;
+
+		memset(buf, 0xff, SPARSE_SIZE);
+		for (off = SPARSE_STRIDE - 1; off < SPARSE_SIZE;
+		     off += SPARSE_STRIDE)
+			buf[off] = 0xef;
+		tmp = check_sparse_impl(impl, buf, 0xff);
+		if (tmp > ret)
+			ret = tmp;
+	}
+
+	free(buf);
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned seed;
+	int ret, tmp;
+
+	seed = time(NULL);
+	printf("Random seed: %u\n", seed);
+	srand(seed);
+
+	ret = test_correctness();
+	tmp = check_sparse();
+	if (tmp > ret)
+		ret = tmp;
+	return ret;
+}
@@ -0,0 +1,330 @@
+/** @internal @file src/kdumpfile/test-cache.c
+ * @brief Test data cache.
+ */
+/* Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#define _GNU_SOURCE
+
+#include "kdumpfile-priv.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+
+#define TEST_OK     0
+#define TEST_FAIL   1
+#define TEST_ERR   99
+
+/** Number of elements in the small test cache. */
+#define SMALL_SIZE	4
+
+/** Number of elements in the big test cache. */
+#define BIG_SIZE	4096
+
+/** Number of distinct keys used with the big test cache. */
+#define BIG_KEYS	(4 * BIG_SIZE)
+
+/** Number of lookups in the big test cache. */
+#define BIG_LOOPS	200000
+
+/** Maximum number of elements counted in a page cache shard. */
+#define MAX_SHARD_SIZE	64
+
+/**  Get an entry and fill it with its key on a miss.
+ * @param cache  Cache object.
+ * @param key    Cache key.
+ * @param hit    Set to non-zero on a cache hit.
+ * @returns      Cache entry, or @c NULL if cache is full.
+ */
+static struct cache_entry *
+get_entry(struct cache *cache, cache_key_t key, int *hit)
+{
+	struct cache_entry *entry;
+
+	entry = cache_get_entry(cache, key);
+	if (!entry)
+		return NULL;
+
+	*hit = cache_entry_valid(entry);
+	if (!*hit) {
+		*(cache_key_t *)entry->data = key;
+		cache_insert(cache, entry);
+	}
+	return entry;
+}
+
+/**  Check that a key is (or is not) cached.
+ * @param cache   Cache object.
+ * @param key     Cache key.
+ * @param expect  Expected hit status.
+ * @returns       Test status.
+ */
+static int
+check_key(struct cache *cache, cache_key_t key, int expect)
+{
+	struct cache_entry *entry;
+	int hit;
+	int ret = TEST_OK;
+
+	entry = get_entry(cache, key, &hit);
+	if (!entry) {
+		printf("Cache full when getting key %lu\n",
+		       (unsigned long)key);
+		return TEST_FAIL;
+	}
+	if (hit != expect) {
+		printf("Key %lu: %s, expected %s\n", (unsigned long)key,
+		       hit ? "hit" : "miss", expect ? "hit" : "miss");
+		ret = TEST_FAIL;
+	}
+	if (*(cache_key_t *)entry->data != key) {
+		printf("Key %lu: data mismatch\n", (unsigned long)key);
+		ret = TEST_FAIL;
+	}
+	cache_put_entry(cache, entry);
+	return ret;
+}
+
+static int
+test_small(void)
+{
+	struct cache_entry *entries[SMALL_SIZE];
+	struct cache_entry *entry;
+	struct cache *cache;
+	cache_key_t key;
+	int hit;
+	int ret = TEST_OK;
+
+	cache = cache_alloc(SMALL_SIZE, sizeof(cache_key_t));
+	if (!cache) {
+		perror("Cannot allocate cache");
+		return TEST_ERR;
+	}
+
+	/* Fill the cache. */
+	for (key = 0; key < SMALL_SIZE; ++key)
+		ret |= check_key(cache, key, 0);
+	for (key = 0; key < SMALL_SIZE; ++key)
+		ret |= check_key(cache, key, 1);
+
+	/* Evict everything with new keys and get a ghost hit. */
+	for (key = SMALL_SIZE; key < 2 * SMALL_SIZE; ++key)
+		ret |= check_key(cache, key, 0);
+	ret |= check_key(cache, 0, 0);
+	ret |= check_key(cache, 0, 1);
+
+	/* A discarded entry must not be found. */
+	key = 100;
+	entry = cache_get_entry(cache, key);
+	if (!entry || cache_entry_valid(entry)) {
+		printf("Key %lu: unexpected hit or full cache\n",
+		       (unsigned long)key);
+		ret = TEST_FAIL;
+	} else
+		cache_discard(cache, entry);
+	ret |= check_key(cache, key, 0);
+
+	/* Pin all entries; further misses must fail. */
+	for (key = 0; key < SMALL_SIZE; ++key) {
+		entries[key] = get_entry(cache, 200 + key, &hit);
+		if (!entries[key]) {
+			printf("Cache full when pinning key %lu\n",
+			       (unsigned long)key);
+			ret = TEST_FAIL;
+		}
+	}
+	entry = cache_get_entry(cache, 300);
+	if (entry) {
+		printf("Got an entry from a fully utilized cache\n");
+		ret = TEST_FAIL;
+	}
+	for (key = 0; key < SMALL_SIZE; ++key)
+		if (entries[key])
+			cache_put_entry(cache, entries[key]);
+	ret |= check_key(cache, 300, 0);
+
+	cache_free(cache);
+	return ret;
+}
+
+static int
+test_big(void)
+{
+	struct cache_entry *entry;
+	struct cache *cache;
+	unsigned long i, hits;
+	cache_key_t key;
+	int hit;
+	int ret = TEST_OK;
+
+	cache = cache_alloc(BIG_SIZE, sizeof(cache_key_t));
+	if (!cache) {
+		perror("Cannot allocate cache");
+		return TEST_ERR;
+	}
+
+	hits = 0;
+	srand(1);
+	for (i = 0; i < BIG_LOOPS; ++i) {
+		/* Make half of the keys four times as hot. */
+		key = rand() % (i & 1 ? BIG_KEYS : BIG_KEYS / 8);
+		key <<= 12;
+		entry = get_entry(cache, key, &hit);
+		if (!entry) {
+			printf("Cache full at key 0x%llx\n",
+			       (unsigned long long)key);
+			ret = TEST_FAIL;
+			break;
+		}
+		if (*(cache_key_t *)entry->data != key) {
+			printf("Key 0x%llx: data mismatch\n",
+			       (unsigned long long)key);
+			ret = TEST_FAIL;
+		}
+		hits += hit;
+		cache_put_entry(cache, entry);
+	}
+
+	printf("Big cache: %lu hits, %lu misses\n", hits, i - hits);
+	if (hits < BIG_LOOPS / 4) {
+		printf("Hot keys were not kept in the cache\n");
+		ret = TEST_FAIL;
+	}
+
+	cache_free(cache);
+	return ret;
+}
+
+/**  Count the entries which can be used at the same time.
+ * @param cache  Cache object.
+ * @returns      Number of entries (at most @ref MAX_SHARD_SIZE).
+ *
+ * Entry data is not touched, because the element size of a page
+ * cache is zero until the page size is known.
+ */
+static unsigned
+cache_capacity(struct cache *cache)
+{
+	struct cache_entry *entries[MAX_SHARD_SIZE];
+	unsigned i, n;
+
+	for (n = 0; n < MAX_SHARD_SIZE; ++n) {
+		entries[n] = cache_get_entry(cache, n);
+		if (!entries[n])
+			break;
+		cache_insert(cache, entries[n]);
+	}
+	for (i = 0; i < n; ++i)
+		cache_put_entry(cache, entries[i]);
+	return n;
+}
+
+/**  Check the page cache shards of a dump file object.
+ * @param ctx      Dump file object.
+ * @param size     Cache size.
+ * @param nshards  Requested number of shards.
+ * @param expect   Expected number of shards.
+ * @returns        Test status.
+ */
+static int
+check_shards(kdump_ctx_t *ctx, unsigned size, unsigned nshards,
+	     unsigned expect)
+{
+	struct kdump_shared *shared = ctx->shared;
+	unsigned i, cap, total, min, max;
+	kdump_status status;
+
+	status = kdump_set_number_attr(ctx, "cache.size", size);
+	if (status == KDUMP_OK)
+		status = kdump_set_number_attr(ctx, "cache.shards", nshards);
+	if (status == KDUMP_OK)
+		status = def_realloc_caches(ctx);
+	if (status != KDUMP_OK) {
+		printf("Cannot allocate %u shards of %u elements: %s\n",
+		       nshards, size, kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+
+	total = 0;
+	min = max = cache_capacity(shared->cache[0].cache);
+	for (i = 0; i < shared->ncache; ++i) {
+		cap = cache_capacity(shared->cache[i].cache);
+		total += cap;
+		if (cap < min)
+			min = cap;
+		if (cap > max)
+			max = cap;
+	}
+	printf("Size %u, %u shards: %u shards, %u elements\n",
+	       size, nshards, shared->ncache, total);
+
+	if (shared->ncache != expect) {
+		printf("Expected %u shards\n", expect);
+		return TEST_FAIL;
+	}
+	if (total != size || max - min > 1) {
+		printf("Elements are not split evenly\n");
+		return TEST_FAIL;
+	}
+	return TEST_OK;
+}
+
+static int
+test_shards(void)
+{
+	kdump_ctx_t *ctx;
+	int ret = TEST_OK;
+
+	ctx = kdump_new();
+	if (!ctx) {
+		perror("Cannot allocate dump file object");
+		return TEST_ERR;
+	}
+
+	ret |= check_shards(ctx, 2, 8, 2);
+	ret |= check_shards(ctx, 10, 4, 4);
+	ret |= check_shards(ctx, 16, 4, 4);
+	ret |= check_shards(ctx, 1, 1, 1);
+
+	kdump_free(ctx);
+	return ret;
+}
+
+int
+main(int argc, char **argv)
+{
+	int ret, tmp;
+
+	ret = test_small();
+	tmp = test_big();
+	if (tmp > ret)
+		ret = tmp;
+	tmp = test_shards();
+	if (tmp > ret)
+		ret = tmp;
+	return ret;
+}
@@ -704,49 +704,117 @@ set_zlib_error(kdump_ctx_t *ctx, const char *what,
 }
 #endif
 
+#if USE_ZLIB
+/** Per-context zlib decompression stream. */
+struct zlib_stream {
+	int initialized;	/**< Non-zero if @c zstream is initialized. */
+	z_stream zstream;	/**< The zlib stream. */
+};
+
+/**  Clean up a per-context zlib stream.
+ * @param data  Per-context data (struct zlib_stream).
+ */
+static void
+zlib_stream_cleanup(void *data)
+{
+	struct zlib_stream *zs = data;
+
+	if (zs->initialized)
+		inflateEnd(&zs->zstream);
+}
+#endif
+
+/**  Allocate a per-context zlib stream.
+ * @param shared  Dump file shared data.
+ * @returns       Per-context slot number, or -1 on error.
+ *
+ * The stream itself is initialized lazily on first use. Pass the slot
+ * number to @ref uncompress_page_gzip. The slot must be released with
+ * @ref per_ctx_free.
+ *
+ * On error, @c errno is set to:
+ * - @c ENOTSUP  Compiled without zlib support.
+ * - errors from @ref per_ctx_alloc
+ */
+int
+per_ctx_alloc_zlib(struct kdump_shared *shared)
+{
+#if USE_ZLIB
+	int slot;
+
+	slot = per_ctx_alloc(shared, sizeof(struct zlib_stream));
+	if (slot >= 0)
+		shared->per_ctx_cleanup[slot] = zlib_stream_cleanup;
+	return slot;
+#else
+	errno = ENOTSUP;
+	return -1;
+#endif
+}
+
 /**  Uncompress a gzipp'ed page.
  * @param ctx     Dump file object.
+ * @param slot    Per-context zlib stream slot, or -1.
  * @param dst     Destination buffer.
  * @param src     Source (compressed) data.
  * @param srclen  Length of source data.
+ *
+ * If @p slot is a slot number returned by @ref per_ctx_alloc_zlib,
+ * the zlib stream is reused between calls; otherwise, a temporary
+ * stream is allocated for this call.
  */
 kdump_status
-uncompress_page_gzip(kdump_ctx_t *ctx, unsigned char *dst,
+uncompress_page_gzip(kdump_ctx_t *ctx, int slot, unsigned char *dst,
 		     unsigned char *src, size_t srclen)
 {
 #if USE_ZLIB
-	z_stream zstream;
+	struct zlib_stream tmp, *zs;
 	int res;
 
-	memset(&zstream, 0, sizeof zstream);
-	zstream.next_in = (z_const Bytef *)src;
-	zstream.avail_in = srclen;
-	zstream.next_out = dst;
-	zstream.avail_out = get_page_size(ctx);
+	if (slot >= 0) {
+		zs = ctx->data[slot];
+	} else {
+		zs = &tmp;
+		zs->initialized = 0;
+	}
+
+	if (!zs->initialized) {
+		memset(&zs->zstream, 0, sizeof zs->zstream);
+		res = inflateInit(&zs->zstream);
+		if (res != Z_OK)
+			return set_zlib_error(ctx, "Cannot init zlib",
+					      &zs->zstream, res);
+		zs->initialized = 1;
+	} else {
+		res = inflateReset(&zs->zstream);
+		if (res != Z_OK)
+			return set_zlib_error(ctx, "Cannot reset zlib",
+					      &zs->zstream, res);
+	}
 
-	res = inflateInit(&zstream);
-	if (res != Z_OK)
-		return set_zlib_error(ctx, "Cannot init zlib", &zstream, res);
+	zs->zstream.next_in = (z_const Bytef *)src;
+	zs->zstream.avail_in = srclen;
+	zs->zstream.next_out = dst;
+	zs->zstream.avail_out = get_page_size(ctx);
 
-	res = inflate(&zstream, Z_FINISH);
+	res = inflate(&zs->zstream, Z_FINISH);
+	if (zs == &tmp) {
+		int endres = inflateEnd(&zs->zstream);
+		if (res == Z_STREAM_END && endres != Z_OK)
+			res = endres;
+	}
 	if (res != Z_STREAM_END) {
-		inflateEnd(&zstream);
 		if (res == Z_NEED_DICT ||
-		    (res == Z_BUF_ERROR && zstream.avail_in == 0))
+		    (res == Z_BUF_ERROR && zs->zstream.avail_in == 0))
 			res = Z_DATA_ERROR;
 		return set_zlib_error(ctx, "Decompresion failed",
-				      &zstream, res);
+				      &zs->zstream, res);
 	}
 
-	res = inflateEnd(&zstream);
-	if (res != Z_OK)
-		return set_zlib_error(ctx, "Decompression failed",
-				      &zstream, res);
-
-	if (zstream.avail_out)
+	if (zs->zstream.avail_out)
 		return set_error(ctx, KDUMP_ERR_CORRUPT,
 				 "Wrong uncompressed size: %lu",
-				 (unsigned long) zstream.total_out);
+				 (unsigned long) zs->zstream.total_out);
 
 	return KDUMP_OK;
 
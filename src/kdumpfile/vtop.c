@@ -378,6 +378,69 @@ const struct attr_ops xen_dirty_xlat_ops = {
 	.pre_clear = (attr_pre_clear_fn*)xen_dirty_xlat_hook,
 };
 
+static kdump_status
+xlat_tlb_size_post_hook(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	size_t size = attr_value(attr)->number;
+	kdump_ctx_t *other;
+	addrxlat_status status;
+
+	/* Resize all contexts which share this attribute. */
+	list_for_each_entry(other, &ctx->shared->ctx, list) {
+		if (other->dict != ctx->dict)
+			continue;
+		status = addrxlat_ctx_set_tlb_size(other->xlatctx, size);
+		if (status != ADDRXLAT_OK)
+			return addrxlat2kdump(ctx, status);
+	}
+	return KDUMP_OK;
+}
+
+const struct attr_ops xlat_tlb_size_ops = {
+	.post_set = xlat_tlb_size_post_hook,
+};
+
+/**  Get translation lookaside buffer statistics.
+ * @param ctx   Dump file object.
+ * @param attr  Statistics attribute.
+ * @param miss  Non-zero to get misses, zero to get hits.
+ * @returns     Error status.
+ *
+ * The counters are kept by the address translation context of @p ctx.
+ * The attribute is left invalid, so it is updated every time its value
+ * is requested.
+ */
+static kdump_status
+xlat_tlb_stat_revalidate(kdump_ctx_t *ctx, struct attr_data *attr, int miss)
+{
+	unsigned long hits, misses;
+	kdump_attr_value_t val;
+
+	addrxlat_ctx_get_tlb_stats(ctx->xlatctx, &hits, &misses);
+	val.number = miss ? misses : hits;
+	return set_attr(ctx, attr, ATTR_INVALID, &val);
+}
+
+static kdump_status
+xlat_tlb_hits_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return xlat_tlb_stat_revalidate(ctx, attr, 0);
+}
+
+const struct attr_ops xlat_tlb_hits_ops = {
+	.revalidate = xlat_tlb_hits_revalidate,
+};
+
+static kdump_status
+xlat_tlb_misses_revalidate(kdump_ctx_t *ctx, struct attr_data *attr)
+{
+	return xlat_tlb_stat_revalidate(ctx, attr, 1);
+}
+
+const struct attr_ops xlat_tlb_misses_ops = {
+	.revalidate = xlat_tlb_misses_revalidate,
+};
+
 /**  Add a cached read chunk.
  * @param cache  Read cache.
  * @param key    New entry key.
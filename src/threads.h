@@ -69,6 +69,39 @@ mutex_unlock(mutex_t *mutex)
 	return pthread_mutex_unlock(mutex);
 }
 
+typedef pthread_cond_t cond_t;
+typedef pthread_condattr_t condattr_t;
+
+static inline int
+cond_init(cond_t *cond, const condattr_t *attr)
+{
+	return pthread_cond_init(cond, attr);
+}
+
+static inline int
+cond_destroy(cond_t *cond)
+{
+	return pthread_cond_destroy(cond);
+}
+
+static inline int
+cond_wait(cond_t *cond, mutex_t *mutex)
+{
+	return pthread_cond_wait(cond, mutex);
+}
+
+static inline int
+cond_timedwait(cond_t *cond, mutex_t *mutex, const struct timespec *abstime)
+{
+	return pthread_cond_timedwait(cond, mutex, abstime);
+}
+
+static inline int
+cond_broadcast(cond_t *cond)
+{
+	return pthread_cond_broadcast(cond);
+}
+
 typedef pthread_rwlock_t rwlock_t;
 typedef pthread_rwlockattr_t rwlockattr_t;
 
@@ -90,6 +123,12 @@ rwlock_rdlock(rwlock_t *rwlock)
 	return pthread_rwlock_rdlock(rwlock);
 }
 
+static inline int
+rwlock_tryrdlock(rwlock_t *rwlock)
+{
+	return pthread_rwlock_tryrdlock(rwlock);
+}
+
 static inline int
 rwlock_wrlock(rwlock_t *rwlock)
 {
@@ -102,8 +141,25 @@ rwlock_unlock(rwlock_t *rwlock)
 	return pthread_rwlock_unlock(rwlock);
 }
 
+typedef pthread_t thread_t;
+
+static inline int
+thread_create(thread_t *thread, void *(*start)(void *), void *arg)
+{
+	return pthread_create(thread, NULL, start, arg);
+}
+
+static inline int
+thread_join(thread_t thread, void **retval)
+{
+	return pthread_join(thread, retval);
+}
+
 #else  /* USE_PTHREAD */
 
+#include <errno.h>
+#include <time.h>
+
 typedef struct { } mutex_t;
 typedef struct { } mutexattr_t;
 
@@ -137,6 +193,40 @@ mutex_unlock(mutex_t *mutex)
 	return 0;
 }
 
+/* There is no other thread which could wake up a waiter. */
+typedef struct { } cond_t;
+typedef struct { } condattr_t;
+
+static inline int
+cond_init(cond_t *cond, const condattr_t *attr)
+{
+	return 0;
+}
+
+static inline int
+cond_destroy(cond_t *cond)
+{
+	return 0;
+}
+
+static inline int
+cond_wait(cond_t *cond, mutex_t *mutex)
+{
+	return EDEADLK;
+}
+
+static inline int
+cond_timedwait(cond_t *cond, mutex_t *mutex, const struct timespec *abstime)
+{
+	return ETIMEDOUT;
+}
+
+static inline int
+cond_broadcast(cond_t *cond)
+{
+	return 0;
+}
+
 typedef struct { } rwlock_t;
 typedef struct { } rwlockattr_t;
 
@@ -158,6 +248,12 @@ rwlock_rdlock(rwlock_t *rwlock)
 	return 0;
 }
 
+static inline int
+rwlock_tryrdlock(rwlock_t *rwlock)
+{
+	return 0;
+}
+
 static inline int
 rwlock_wrlock(rwlock_t *rwlock)
 {
@@ -170,6 +266,21 @@ rwlock_unlock(rwlock_t *rwlock)
 	return 0;
 }
 
+/* Threads cannot be created without thread support. */
+typedef struct { } thread_t;
+
+static inline int
+thread_create(thread_t *thread, void *(*start)(void *), void *arg)
+{
+	return ENOSYS;
+}
+
+static inline int
+thread_join(thread_t thread, void **retval)
+{
+	return ESRCH;
+}
+
 #endif
 
 #endif	/* threads.h */
@@ -50,6 +50,42 @@ printmap(const addrxlat_map_t *map)
 	}
 }
 
+/* Check that each range boundary is found by addrxlat_map_search(). */
+static int
+checksearch(const addrxlat_map_t *map)
+{
+	addrxlat_addr_t addr, end;
+	addrxlat_sys_meth_t meth;
+	const addrxlat_range_t *range;
+	size_t i, n;
+	int rc;
+
+	rc = TEST_OK;
+	n = addrxlat_map_len(map);
+	addr = 0;
+	range = addrxlat_map_ranges(map);
+	for (i = 0; i < n; ++i) {
+		end = addr + range->endoff;
+		meth = addrxlat_map_search(map, addr);
+		if (meth != range->meth) {
+			fprintf(stderr, "Search for 0x%"ADDRXLAT_PRIxADDR
+				" returned %ld, expected %ld\n",
+				addr, (long) meth, (long) range->meth);
+			rc = TEST_FAIL;
+		}
+		meth = addrxlat_map_search(map, end);
+		if (meth != range->meth) {
+			fprintf(stderr, "Search for 0x%"ADDRXLAT_PRIxADDR
+				" returned %ld, expected %ld\n",
+				end, (long) meth, (long) range->meth);
+			rc = TEST_FAIL;
+		}
+		addr = end + 1;
+		++range;
+	}
+	return rc;
+}
+
 int
 main(int argc, char **argv)
 {
@@ -60,6 +96,7 @@ main(int argc, char **argv)
 	unsigned long methidx;
 	char *endp;
 	int i;
+	int rc;
 
 	map = addrxlat_map_new();
 	if (!map) {
@@ -95,10 +132,12 @@ main(int argc, char **argv)
 		}
 	}
 
+	rc = TEST_OK;
 	if (map) {
 		printmap(map);
+		rc = checksearch(map);
 		addrxlat_map_decref(map);
 	}
 
-	return TEST_OK;
+	return rc;
 }
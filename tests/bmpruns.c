@@ -0,0 +1,228 @@
+/* List runs of present pages in the file pagemap.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libkdumpfile/kdumpfile.h>
+
+#include "testutil.h"
+
+/** Maximum number of runs which can be checked. */
+#define MAX_RUNS	1024
+
+struct run {
+	kdump_addr_t first, last;
+};
+
+struct runs {
+	unsigned n;
+	struct run run[MAX_RUNS];
+};
+
+static int
+add_run(void *data, kdump_addr_t first, kdump_addr_t last)
+{
+	struct runs *runs = data;
+
+	printf("0x%llx-0x%llx\n",
+	       (unsigned long long) first, (unsigned long long) last);
+	if (runs->n >= MAX_RUNS)
+		return 1;
+	runs->run[runs->n].first = first;
+	runs->run[runs->n].last = last;
+	++runs->n;
+	return 0;
+}
+
+/* Verify the runs against kdump_bmp_find_set and kdump_bmp_find_clear. */
+static int
+check_runs(kdump_bmp_t *bmp, const struct runs *runs,
+	   kdump_addr_t first, kdump_addr_t last)
+{
+	kdump_addr_t idx;
+	kdump_status status;
+	unsigned i;
+
+	idx = first;
+	for (i = 0; i < runs->n; ++i) {
+		const struct run *run = &runs->run[i];
+
+		status = kdump_bmp_find_set(bmp, &idx);
+		if (status != KDUMP_OK) {
+			fprintf(stderr, "Cannot find set bit: %s\n",
+				kdump_bmp_get_err(bmp));
+			return TEST_FAIL;
+		}
+		if (idx != run->first) {
+			fprintf(stderr, "Run %u starts at 0x%llx,"
+				" but first set bit is 0x%llx\n", i,
+				(unsigned long long) run->first,
+				(unsigned long long) idx);
+			return TEST_FAIL;
+		}
+
+		if (run->last == last)
+			return TEST_OK;
+
+		status = kdump_bmp_find_clear(bmp, &idx);
+		if (status != KDUMP_OK) {
+			fprintf(stderr, "Cannot find clear bit: %s\n",
+				kdump_bmp_get_err(bmp));
+			return TEST_FAIL;
+		}
+		if (idx != run->last + 1) {
+			fprintf(stderr, "Run %u ends at 0x%llx,"
+				" but next clear bit is 0x%llx\n", i,
+				(unsigned long long) run->last,
+				(unsigned long long) idx);
+			return TEST_FAIL;
+		}
+	}
+
+	status = kdump_bmp_find_set(bmp, &idx);
+	if (status == KDUMP_OK && idx <= last) {
+		fprintf(stderr, "Set bit 0x%llx is not in any run\n",
+			(unsigned long long) idx);
+		return TEST_FAIL;
+	}
+
+	return TEST_OK;
+}
+
+static int
+list_runs(kdump_ctx_t *ctx, kdump_addr_t first, kdump_addr_t last)
+{
+	kdump_attr_t attr;
+	kdump_status status;
+	struct runs runs;
+
+	status = kdump_get_attr(ctx, KDUMP_ATTR_FILE_PAGEMAP, &attr);
+	if (status != KDUMP_OK) {
+		fprintf(stderr, "Cannot get file pagemap: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+
+	runs.n = 0;
+	status = kdump_bmp_iter_runs(attr.val.bitmap, first, last,
+				     add_run, &runs);
+	if (status != KDUMP_OK) {
+		fprintf(stderr, "Cannot iterate runs: %s\n",
+			kdump_bmp_get_err(attr.val.bitmap));
+		return TEST_FAIL;
+	}
+	if (runs.n >= MAX_RUNS) {
+		fprintf(stderr, "Too many runs\n");
+		return TEST_ERR;
+	}
+
+	return check_runs(attr.val.bitmap, &runs, first, last);
+}
+
+static int
+list_runs_fd(int fd, kdump_addr_t first, kdump_addr_t last)
+{
+	kdump_ctx_t *ctx;
+	kdump_status res;
+	int rc;
+
+	ctx = kdump_new();
+	if (!ctx) {
+		perror("Cannot initialize dump context");
+		return TEST_ERR;
+	}
+
+	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
+		rc = TEST_ERR;
+	} else
+		rc = list_runs(ctx, first, last);
+
+	kdump_free(ctx);
+	return rc;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s <dump> [<first> [<last>]]\n",
+		name);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long long first, last;
+	char *endp;
+	int fd;
+	int rc;
+
+	if (argc < 2 || argc > 4) {
+		usage(argv[0]);
+		return TEST_ERR;
+	}
+
+	first = 0;
+	if (argc > 2) {
+		first = strtoull(argv[2], &endp, 0);
+		if (*endp) {
+			fprintf(stderr, "Invalid first index: %s\n", argv[2]);
+			return TEST_ERR;
+		}
+	}
+
+	last = KDUMP_ADDR_MAX;
+	if (argc > 3) {
+		last = strtoull(argv[3], &endp, 0);
+		if (*endp) {
+			fprintf(stderr, "Invalid last index: %s\n", argv[3]);
+			return TEST_ERR;
+		}
+	}
+
+	fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		perror("open dump");
+		return TEST_ERR;
+	}
+
+	rc = list_runs_fd(fd, first, last);
+
+	if (close(fd) < 0) {
+		perror("close dump");
+		rc = TEST_ERR;
+	}
+
+	return rc;
+}
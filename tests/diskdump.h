@@ -131,11 +131,13 @@ struct kdump_sub_header_64 {
 #define DUMP_DH_COMPRESSED_SNAPPY	0x4
 #define DUMP_DH_COMPRESSED_INCOMPLETE	0x8
 #define DUMP_DH_EXCLUDED_VMEMMAP	0x10
+#define DUMP_DH_COMPRESSED_ZSTD		0x20
 
 #define DUMP_DH_COMPRESSED			\
 	(DUMP_DH_COMPRESSED_ZLIB |		\
 	 DUMP_DH_COMPRESSED_LZO |		\
-	 DUMP_DH_COMPRESSED_SNAPPY)
+	 DUMP_DH_COMPRESSED_SNAPPY |		\
+	 DUMP_DH_COMPRESSED_ZSTD)
 
 struct page_desc {
 	uint64_t offset;
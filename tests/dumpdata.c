@@ -42,6 +42,7 @@
 static const char *ostype = NULL;
 static unsigned long valsz = 1;
 static int zero_excluded;
+static const char *index_file;
 
 static inline int
 endofline(unsigned long long addr)
@@ -184,6 +185,16 @@ dump_data_fd(int fd, char **argv)
 		}
 	}
 
+	if (index_file) {
+		res = kdump_set_string_attr(ctx, KDUMP_ATTR_FILE_INDEX,
+					    index_file);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set index file: %s\n",
+				kdump_get_err(ctx));
+			goto err;
+		}
+	}
+
 	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
 	if (res != KDUMP_OK) {
 		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
@@ -246,6 +257,7 @@ usage(const char *name)
 		"Options:\n"
 		"  -o ostype  Set OS type\n"
 		"  -s size    Set value size in bytes\n"
+		"  -x file    Use a sidecar index file\n"
 		"  -z         Fill excluded pages with zeroes\n",
 		name);
 }
@@ -258,7 +270,7 @@ main(int argc, char **argv)
 	int fd;
 	int rc;
 
-	while ((opt = getopt(argc, argv, "ho:s:z")) != -1) {
+	while ((opt = getopt(argc, argv, "ho:s:x:z")) != -1) {
 		switch (opt) {
 		case 'o':
 			ostype = optarg;
@@ -274,6 +286,10 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'x':
+			index_file = optarg;
+			break;
+
 		case 'z':
 			zero_excluded = 1;
 			break;
@@ -0,0 +1,235 @@
+/* Borrow pages without copying.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libkdumpfile/kdumpfile.h>
+
+#include "testutil.h"
+
+/** Number of pages which are borrowed at the same time. */
+#define NBORROW		4
+
+/** Re-allocate the page cache while pages are borrowed. */
+static int realloc_cache;
+
+/* Borrow the same pages again and re-allocate the page cache. */
+static int
+borrow_realloc(kdump_ctx_t *ctx, kdump_addr_t addr, kdump_num_t page_size,
+	       const void **data, kdump_page_t **pages)
+{
+	static kdump_num_t cache_size = 8;
+	kdump_status res;
+	unsigned i;
+
+	for (i = 0; i < NBORROW; ++i) {
+		res = kdump_get_page(ctx, KDUMP_MACHPHYSADDR,
+				     addr + i * page_size, &data[i], &pages[i]);
+		if (res != KDUMP_OK)
+			pages[i] = NULL;
+	}
+
+	cache_size = cache_size == 8 ? 16 : 8;
+	res = kdump_set_number_attr(ctx, "cache.size", cache_size);
+	if (res == KDUMP_OK)
+		res = kdump_set_number_attr(ctx, "cache.l1_size", cache_size);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot re-allocate cache: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+	return TEST_OK;
+}
+
+/* Compare borrowed pages with copied data. */
+static int
+check_pages(kdump_ctx_t *ctx, kdump_addr_t start, kdump_addr_t size)
+{
+	kdump_page_t *pages[NBORROW], *again[NBORROW];
+	const void *data[NBORROW], *againdata[NBORROW];
+	kdump_status status[NBORROW];
+	kdump_num_t page_size;
+	unsigned char *buf;
+	kdump_addr_t addr;
+	unsigned long npages, nfail;
+	kdump_status res;
+	size_t sz;
+	unsigned i;
+	int rc;
+
+	res = kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SIZE, &page_size);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot get page size: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+
+	buf = malloc(page_size);
+	if (!buf) {
+		perror("Cannot allocate buffer");
+		return TEST_ERR;
+	}
+
+	rc = TEST_OK;
+	npages = nfail = 0;
+	for (addr = start; addr < start + size; addr += NBORROW * page_size) {
+		/* Borrow several pages at once ... */
+		for (i = 0; i < NBORROW; ++i) {
+			status[i] = kdump_get_page(
+				ctx, KDUMP_MACHPHYSADDR,
+				addr + i * page_size + i,
+				&data[i], &pages[i]);
+			++npages;
+		}
+
+		if (realloc_cache) {
+			rc = borrow_realloc(ctx, addr, page_size,
+					    againdata, again);
+			if (rc != TEST_OK)
+				break;
+		}
+
+		/* ... and check them against kdump_read(). */
+		for (i = 0; i < NBORROW; ++i) {
+			sz = page_size;
+			res = kdump_read(ctx, KDUMP_MACHPHYSADDR,
+					 addr + i * page_size, buf, &sz);
+			if (res != status[i]) {
+				fprintf(stderr, "Page at 0x%llx: status %d,"
+					" expected %d\n",
+					(unsigned long long)
+					(addr + i * page_size),
+					(int) status[i], (int) res);
+				rc = TEST_FAIL;
+			} else if (res == KDUMP_OK &&
+				   memcmp(buf, data[i], page_size)) {
+				fprintf(stderr, "Page at 0x%llx: data mismatch\n",
+					(unsigned long long)
+					(addr + i * page_size));
+				rc = TEST_FAIL;
+			} else if (realloc_cache && res == KDUMP_OK &&
+				   (againdata[i] != data[i] || !again[i])) {
+				fprintf(stderr, "Page at 0x%llx: not shared\n",
+					(unsigned long long)
+					(addr + i * page_size));
+				rc = TEST_FAIL;
+			}
+			if (realloc_cache && again[i])
+				kdump_put_page(again[i]);
+			if (status[i] == KDUMP_OK)
+				kdump_put_page(pages[i]);
+			else
+				++nfail;
+		}
+	}
+	printf("%lu pages, %lu failed\n", npages, nfail);
+
+	free(buf);
+	return rc;
+}
+
+static int
+getpage_fd(int fd, kdump_addr_t start, kdump_addr_t size)
+{
+	kdump_ctx_t *ctx;
+	kdump_status res;
+	int rc;
+
+	ctx = kdump_new();
+	if (!ctx) {
+		perror("Cannot initialize dump context");
+		return TEST_ERR;
+	}
+
+	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
+		rc = TEST_ERR;
+	} else
+		rc = check_pages(ctx, start, size);
+
+	kdump_free(ctx);
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long long start, size;
+	char *p;
+	int opt;
+	int fd;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "r")) != -1) {
+		switch (opt) {
+		case 'r':
+			realloc_cache = 1;
+			break;
+
+		default:
+			argc = 0;
+		}
+	}
+
+	if (argc - optind != 3) {
+		fprintf(stderr, "Usage: %s [-r] <dump> <start> <size>\n",
+			argv[0]);
+		return TEST_ERR;
+	}
+
+	start = strtoull(argv[optind + 1], &p, 0);
+	if (*p) {
+		fprintf(stderr, "Invalid number: %s\n", argv[optind + 1]);
+		return TEST_ERR;
+	}
+	size = strtoull(argv[optind + 2], &p, 0);
+	if (*p) {
+		fprintf(stderr, "Invalid number: %s\n", argv[optind + 2]);
+		return TEST_ERR;
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if (fd < 0) {
+		perror("open dump");
+		return TEST_ERR;
+	}
+
+	rc = getpage_fd(fd, start, size);
+
+	if (close(fd) < 0) {
+		perror("close dump");
+		rc = TEST_ERR;
+	}
+
+	return rc;
+}
@@ -43,25 +43,37 @@
 
 static unsigned long base_pfn, npages;
 static unsigned long niter = DEFITER;
+static unsigned long nshards;
+static unsigned long l1size;
+static unsigned long wait_timeout;
+static int wait_mode;
+static int check_data;
+static int sequential;
+static unsigned long decompress_threads;
+static int background_scan;
 
 static void *
 run_reads(void *arg)
 {
 	kdump_ctx_t *ctx = arg;
-	kdump_num_t page_shift;
-	unsigned long pfn;
-	char buf[1];
+	kdump_num_t page_shift, byte_order;
+	unsigned long pfn, start, val;
+	unsigned char buf[4];
 	size_t sz;
 	unsigned i;
 	kdump_status res;
 
 	res = kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SHIFT, &page_shift);
+	if (res == KDUMP_OK)
+		res = kdump_get_number_attr(ctx, KDUMP_ATTR_BYTE_ORDER,
+					    &byte_order);
 	if (res != KDUMP_OK)
 		return (void*) kdump_get_err(ctx);
 
-	sz = sizeof buf;
+	start = lrand48();
 	for (i = 0; i < niter; ++i) {
-		pfn = base_pfn + lrand48() % npages;
+		pfn = base_pfn + (sequential ? start + i : lrand48()) % npages;
+		sz = check_data ? 4 : 1;
 		res = kdump_read(ctx, KDUMP_MACHPHYSADDR, pfn << page_shift,
 				 &buf, &sz);
 		if (res != KDUMP_OK) {
@@ -69,6 +81,19 @@ run_reads(void *arg)
 				(unsigned long long) pfn << page_shift);
 			return (void*) kdump_get_err(ctx);
 		}
+		if (!check_data)
+			continue;
+
+		val = byte_order == KDUMP_BIG_ENDIAN
+			? (unsigned long)buf[0] << 24 | buf[1] << 16 |
+			  buf[2] << 8 | buf[3]
+			: (unsigned long)buf[3] << 24 | buf[2] << 16 |
+			  buf[1] << 8 | buf[0];
+		if (val != (pfn & 0xffffffff)) {
+			fprintf(stderr, "Wrong data at 0x%llx: 0x%08lx\n",
+				(unsigned long long) pfn << page_shift, val);
+			return (void*) "Data mismatch";
+		}
 	}
 
 	return NULL;
@@ -98,6 +123,46 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 		}
 	}
 
+	if (nshards) {
+		res = kdump_set_number_attr(ctx, "cache.shards", nshards);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set cache shards: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (wait_mode) {
+		res = kdump_set_number_attr(ctx, "cache.wait", 1);
+		if (res == KDUMP_OK && wait_timeout)
+			res = kdump_set_number_attr(ctx, "cache.wait_timeout",
+						    wait_timeout);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set cache wait mode: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (decompress_threads) {
+		res = kdump_set_number_attr(ctx, "cache.decompress_threads",
+					    decompress_threads);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot start decompression threads: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
+	if (l1size) {
+		res = kdump_set_number_attr(ctx, "cache.l1_size", l1size);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set L1 cache size: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+	}
+
 	res = pthread_attr_init(&attr);
 	if (res) {
 		fprintf(stderr, "pthread_attr_init: %s\n", strerror(res));
@@ -136,6 +201,29 @@ run_threads(kdump_ctx_t *ctx, unsigned long nthreads, unsigned long cache_size)
 		kdump_free(tinfo[i].ctx);
 	}
 
+	if (rc == TEST_OK) {
+		kdump_num_t hits, misses;
+
+		res = kdump_get_number_attr(ctx, "cache.hits", &hits);
+		if (res == KDUMP_OK)
+			res = kdump_get_number_attr(ctx, "cache.misses",
+						    &misses);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot get cache statistics: %s\n",
+				kdump_get_err(ctx));
+			return TEST_ERR;
+		}
+		printf("Cache hits: %llu, misses: %llu\n",
+		       (unsigned long long) hits,
+		       (unsigned long long) misses);
+		/* Hits in the per-context cache are not counted. */
+		if (!l1size && hits + misses < nthreads * niter) {
+			fprintf(stderr, "Expected at least %lu lookups\n",
+				nthreads * niter);
+			rc = TEST_FAIL;
+		}
+	}
+
 	return rc;
 }
 
@@ -152,6 +240,17 @@ run_threads_fd(int fd, unsigned long nthreads, unsigned long cache_size)
 		return TEST_ERR;
 	}
 
+	if (background_scan) {
+		res = kdump_set_number_attr(
+			ctx, KDUMP_ATTR_FILE_BACKGROUND_SCAN, 1);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot set background scan: %s\n",
+				kdump_get_err(ctx));
+			kdump_free(ctx);
+			return TEST_ERR;
+		}
+	}
+
 	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
 	if (res != KDUMP_OK) {
 		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
@@ -170,10 +269,17 @@ usage(const char *name)
 		"Usage: %s [<options>] <dump> <base-pfn> <num-pages>\n"
 		"\n"
 		"Options:\n"
+		"  -b              Scan page descriptors in the background\n"
+		"  -c              Check that each page starts with its PFN\n"
+		"  -D threads      Number of decompression threads\n"
 		"  -i iterations   Number of reads per thread (default: %u)\n"
+		"  -L slots        Number of per-context cache slots\n"
 		"  -n num-threads  Number of threads (default: %u)\n"
+		"  -q              Read pages sequentially\n"
 		"  -s cache-size   Cache size\n"
-		"  -t timeout      Maximum execution time in seconds\n",
+		"  -S shards       Number of cache shards\n"
+		"  -t timeout      Maximum execution time in seconds\n"
+		"  -w ms           Wait for a free cache entry (0 means forever)\n",
 		name, DEFITER, DEFTHREADS);
 }
 
@@ -190,8 +296,28 @@ main(int argc, char **argv)
 	nthreads = DEFTHREADS;
 	cache_size = 0;
 	timeout = 0;
-	while ((opt = getopt(argc, argv, "hi:n:s:t:")) != -1) {
+	while ((opt = getopt(argc, argv, "bcD:hi:L:n:qs:S:t:w:")) != -1) {
 		switch (opt) {
+		case 'b':
+			background_scan = 1;
+			break;
+
+		case 'c':
+			check_data = 1;
+			break;
+
+		case 'D':
+			decompress_threads = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'q':
+			sequential = 1;
+			break;
+
 		case 'i':
 			niter = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -200,6 +326,14 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'L':
+			l1size = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
 		case 'n':
 			nthreads = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -216,6 +350,14 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'S':
+			nshards = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
 		case 't':
 			timeout = strtoul(optarg, &p, 0);
 			if (*p) {
@@ -224,6 +366,14 @@ main(int argc, char **argv)
 			}
 			break;
 
+		case 'w':
+			wait_mode = 1;
+			wait_timeout = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
 
 		case 'h':
 		default:
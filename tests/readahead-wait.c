@@ -0,0 +1,180 @@
+/* Read-ahead with a fully utilized cache in wait mode.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libkdumpfile/kdumpfile.h>
+
+#include "testutil.h"
+
+/** Number of pages borrowed by the reader (and size of the cache). */
+#define NBORROW		4
+
+/** Number of decompression threads. */
+#define NTHREADS	2
+
+/** Maximum execution time in seconds. */
+#define TIMEOUT		10
+
+static int
+set_attrs(kdump_ctx_t *ctx)
+{
+	kdump_status res;
+
+	res = kdump_set_number_attr(ctx, "cache.size", NBORROW);
+	if (res == KDUMP_OK)
+		res = kdump_set_number_attr(ctx, "cache.shards", 1);
+	if (res == KDUMP_OK)
+		res = kdump_set_number_attr(ctx, "cache.wait", 1);
+	if (res == KDUMP_OK)
+		res = kdump_set_number_attr(ctx, "cache.decompress_threads",
+					    NTHREADS);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot set cache attributes: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+	return TEST_OK;
+}
+
+/* Borrow all cache entries with sequential access, so read-ahead
+ * workers find the cache fully utilized, then stop the workers.
+ */
+static int
+check_readahead(kdump_ctx_t *ctx)
+{
+	kdump_page_t *pages[NBORROW];
+	const void *data[NBORROW];
+	struct timespec ts;
+	kdump_num_t page_size;
+	kdump_status res;
+	unsigned i, n;
+	int rc;
+
+	res = kdump_get_number_attr(ctx, KDUMP_ATTR_PAGE_SIZE, &page_size);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot get page size: %s\n",
+			kdump_get_err(ctx));
+		return TEST_ERR;
+	}
+
+	rc = TEST_OK;
+	for (n = 0; n < NBORROW; ++n) {
+		res = kdump_get_page(ctx, KDUMP_MACHPHYSADDR, n * page_size,
+				     &data[n], &pages[n]);
+		if (res != KDUMP_OK) {
+			fprintf(stderr, "Cannot get page %u: %s\n",
+				n, kdump_get_err(ctx));
+			rc = TEST_FAIL;
+			break;
+		}
+		if (*(const unsigned char *)data[n] != n) {
+			fprintf(stderr, "Wrong data in page %u\n", n);
+			rc = TEST_FAIL;
+		}
+	}
+
+	/* Give the workers time to pick up queued pages. */
+	ts.tv_sec = 0;
+	ts.tv_nsec = 200000000;
+	nanosleep(&ts, NULL);
+
+	/* This blocks forever if a worker waits for a cache entry. */
+	res = kdump_set_number_attr(ctx, "cache.decompress_threads", 0);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot stop decompression threads: %s\n",
+			kdump_get_err(ctx));
+		rc = TEST_FAIL;
+	} else
+		printf("Read-ahead stopped with %u borrowed pages\n", n);
+
+	for (i = 0; i < n; ++i)
+		kdump_put_page(pages[i]);
+
+	return rc;
+}
+
+static int
+readahead_fd(int fd)
+{
+	kdump_ctx_t *ctx;
+	kdump_status res;
+	int rc;
+
+	ctx = kdump_new();
+	if (!ctx) {
+		perror("Cannot initialize dump context");
+		return TEST_ERR;
+	}
+
+	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
+		rc = TEST_ERR;
+	} else {
+		rc = set_attrs(ctx);
+		if (rc == TEST_OK)
+			rc = check_readahead(ctx);
+	}
+
+	kdump_free(ctx);
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	int fd;
+	int rc;
+
+	if (argc != 2) {
+		fprintf(stderr, "Usage: %s <dump>\n", argv[0]);
+		return TEST_ERR;
+	}
+
+	fd = open(argv[1], O_RDONLY);
+	if (fd < 0) {
+		perror("open dump");
+		return TEST_ERR;
+	}
+
+	alarm(TIMEOUT);
+	rc = readahead_fd(fd);
+
+	if (close(fd) < 0) {
+		perror("close dump");
+		rc = TEST_ERR;
+	}
+
+	return rc;
+}
@@ -0,0 +1,296 @@
+/* Vectored data read.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <libkdumpfile/kdumpfile.h>
+
+#include "testutil.h"
+
+#define DEFREQS		1000
+#define MAXLEN		0x2000
+
+/* Enough whole-address-space requests to overflow the fragment
+ * array size with 64-bit addresses and 4 KiB pages.
+ */
+#define OVERFLOW_REQS	512
+
+static unsigned long nreqs = DEFREQS;
+
+/* Compare a vectored read with individual reads. */
+static int
+check_readv(kdump_ctx_t *ctx, kdump_addr_t start, kdump_addr_t size)
+{
+	struct kdump_iovec *vec;
+	unsigned char *data, *buf;
+	kdump_status res;
+	unsigned long i, nfail;
+	size_t sz;
+	int rc;
+
+	vec = calloc(nreqs, sizeof *vec);
+	data = malloc(nreqs * MAXLEN);
+	buf = malloc(MAXLEN);
+	if (!vec || !data || !buf) {
+		perror("Cannot allocate buffers");
+		return TEST_ERR;
+	}
+
+	srand(1);
+	for (i = 0; i < nreqs; ++i) {
+		vec[i].addr = start + rand() % size;
+		vec[i].buf = data + i * MAXLEN;
+		vec[i].len = (i % 4) ? rand() % 64 : rand() % MAXLEN;
+	}
+
+	res = kdump_readv(ctx, KDUMP_MACHPHYSADDR, vec, nreqs);
+	printf("kdump_readv: %s\n",
+	       res == KDUMP_OK ? "OK" : kdump_get_err(ctx));
+
+	rc = TEST_OK;
+	nfail = 0;
+	for (i = 0; i < nreqs; ++i) {
+		sz = vec[i].len;
+		res = kdump_read(ctx, KDUMP_MACHPHYSADDR, vec[i].addr,
+				 buf, &sz);
+		if (res != vec[i].status) {
+			fprintf(stderr, "Request %lu at 0x%llx: status %d,"
+				" expected %d\n", i,
+				(unsigned long long) vec[i].addr,
+				(int) vec[i].status, (int) res);
+			rc = TEST_FAIL;
+		} else if (res == KDUMP_OK &&
+			   memcmp(buf, vec[i].buf, vec[i].len)) {
+			fprintf(stderr, "Request %lu at 0x%llx: data mismatch\n",
+				i, (unsigned long long) vec[i].addr);
+			rc = TEST_FAIL;
+		}
+		if (res != KDUMP_OK)
+			++nfail;
+	}
+	printf("%lu requests, %lu failed\n", nreqs, nfail);
+
+	res = kdump_readv(ctx, KDUMP_MACHPHYSADDR, vec, nreqs);
+	if (nfail && res == KDUMP_OK) {
+		fprintf(stderr, "kdump_readv did not report a failure\n");
+		rc = TEST_FAIL;
+	} else if (!nfail && res != KDUMP_OK) {
+		fprintf(stderr, "kdump_readv failed: %s\n",
+			kdump_get_err(ctx));
+		rc = TEST_FAIL;
+	}
+
+	free(buf);
+	free(data);
+	free(vec);
+	return rc;
+}
+
+/* A request which wraps around the end of the address space is
+ * rejected without affecting other requests.
+ */
+static int
+check_wrap(kdump_ctx_t *ctx, kdump_addr_t start)
+{
+	struct kdump_iovec vec[2];
+	unsigned char buf[2][0x20];
+	kdump_status res;
+	int rc;
+
+	vec[0].addr = KDUMP_ADDR_MAX - 0xf;
+	vec[0].buf = buf[0];
+	vec[0].len = sizeof buf[0];
+	vec[1].addr = start;
+	vec[1].buf = buf[1];
+	vec[1].len = sizeof buf[1];
+
+	res = kdump_readv(ctx, KDUMP_MACHPHYSADDR, vec, 2);
+	printf("kdump_readv across end of address space: %s\n",
+	       res == KDUMP_OK ? "OK" : kdump_get_err(ctx));
+
+	rc = TEST_OK;
+	if (res != KDUMP_ERR_INVALID ||
+	    vec[0].status != KDUMP_ERR_INVALID) {
+		fprintf(stderr, "Wrapped request: status %d (request %d),"
+			" expected %d\n", (int) res, (int) vec[0].status,
+			(int) KDUMP_ERR_INVALID);
+		rc = TEST_FAIL;
+	}
+	if (vec[1].status != KDUMP_OK) {
+		fprintf(stderr, "Request at 0x%llx: status %d, expected %d\n",
+			(unsigned long long) start,
+			(int) vec[1].status, (int) KDUMP_OK);
+		rc = TEST_FAIL;
+	}
+
+	return rc;
+}
+
+/* Requests which need more page fragments than can be allocated
+ * are rejected as a whole.
+ */
+static int
+check_overflow(kdump_ctx_t *ctx)
+{
+	struct kdump_iovec vec[OVERFLOW_REQS];
+	unsigned char buf;
+	kdump_status res;
+	unsigned i;
+	int rc;
+
+	for (i = 0; i < OVERFLOW_REQS; ++i) {
+		vec[i].addr = 0;
+		vec[i].buf = &buf;
+		vec[i].len = KDUMP_ADDR_MAX;
+	}
+
+	res = kdump_readv(ctx, KDUMP_MACHPHYSADDR, vec, OVERFLOW_REQS);
+	printf("kdump_readv of %u whole address spaces: %s\n",
+	       OVERFLOW_REQS, res == KDUMP_OK ? "OK" : kdump_get_err(ctx));
+
+	rc = TEST_OK;
+	if (res != KDUMP_ERR_INVALID) {
+		fprintf(stderr, "Overflowing readv: status %d, expected %d\n",
+			(int) res, (int) KDUMP_ERR_INVALID);
+		rc = TEST_FAIL;
+	}
+	for (i = 0; i < OVERFLOW_REQS; ++i)
+		if (vec[i].status != KDUMP_ERR_INVALID) {
+			fprintf(stderr, "Request %u: status %d, expected %d\n",
+				i, (int) vec[i].status,
+				(int) KDUMP_ERR_INVALID);
+			rc = TEST_FAIL;
+			break;
+		}
+
+	return rc;
+}
+
+static int
+readv_fd(int fd, kdump_addr_t start, kdump_addr_t size)
+{
+	kdump_ctx_t *ctx;
+	kdump_status res;
+	int rc, tmprc;
+
+	ctx = kdump_new();
+	if (!ctx) {
+		perror("Cannot initialize dump context");
+		return TEST_ERR;
+	}
+
+	res = kdump_set_number_attr(ctx, KDUMP_ATTR_FILE_FD, fd);
+	if (res != KDUMP_OK) {
+		fprintf(stderr, "Cannot open dump: %s\n", kdump_get_err(ctx));
+		rc = TEST_ERR;
+	} else {
+		rc = check_readv(ctx, start, size);
+		tmprc = check_wrap(ctx, start);
+		if (tmprc != TEST_OK)
+			rc = tmprc;
+		tmprc = check_overflow(ctx);
+		if (tmprc != TEST_OK)
+			rc = tmprc;
+	}
+
+	kdump_free(ctx);
+	return rc;
+}
+
+static void
+usage(const char *name)
+{
+	fprintf(stderr,
+		"Usage: %s [<options>] <dump> <start> <size>\n"
+		"\n"
+		"Options:\n"
+		"  -n requests     Number of read requests (default: %u)\n",
+		name, DEFREQS);
+}
+
+int
+main(int argc, char **argv)
+{
+	unsigned long long start, size;
+	char *p;
+	int opt;
+	int fd;
+	int rc;
+
+	while ((opt = getopt(argc, argv, "hn:")) != -1) {
+		switch (opt) {
+		case 'n':
+			nreqs = strtoul(optarg, &p, 0);
+			if (*p) {
+				fprintf(stderr, "Invalid number: %s\n", optarg);
+				return TEST_ERR;
+			}
+			break;
+
+		case 'h':
+		default:
+			usage(argv[0]);
+			return (opt == 'h') ? TEST_OK : TEST_ERR;
+		}
+	}
+
+	if (argc - optind != 3) {
+		usage(argv[0]);
+		return TEST_ERR;
+	}
+
+	start = strtoull(argv[optind+1], &p, 0);
+	if (*p) {
+		fprintf(stderr, "Invalid number: %s\n", argv[optind+1]);
+		return TEST_ERR;
+	}
+	size = strtoull(argv[optind+2], &p, 0);
+	if (*p || !size) {
+		fprintf(stderr, "Invalid size: %s\n", argv[optind+2]);
+		return TEST_ERR;
+	}
+
+	fd = open(argv[optind], O_RDONLY);
+	if (fd < 0) {
+		perror("open dump");
+		return TEST_ERR;
+	}
+
+	rc = readv_fd(fd, start, size);
+
+	if (close(fd) < 0) {
+		perror("close dump");
+		rc = TEST_ERR;
+	}
+
+	return rc;
+}
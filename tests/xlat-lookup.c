@@ -0,0 +1,311 @@
+/* Table lookup translation with a large or overlapping table.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <libkdumpfile/addrxlat.h>
+
+#include "testutil.h"
+
+#define PAGE_SIZE	0x1000
+
+/* Number of lookup table elements. */
+#define NELEM		100000
+
+/* Step used to shuffle the table (must be coprime with NELEM). */
+#define SHUFFLE		7919
+
+/* Physical base address of the mapped objects. */
+#define DEST_BASE	0x100000000ULL
+
+/* Every other page is mapped, so the gaps can be checked, too. */
+static addrxlat_addr_t
+elem_orig(size_t i)
+{
+	return 2 * i * PAGE_SIZE;
+}
+
+/* Objects are mapped in reverse order. */
+static addrxlat_addr_t
+elem_dest(size_t i)
+{
+	return DEST_BASE + (NELEM - 1 - i) * PAGE_SIZE;
+}
+
+static addrxlat_lookup_elem_t *
+make_table(void)
+{
+	addrxlat_lookup_elem_t *tbl;
+	size_t i, j;
+
+	tbl = malloc(NELEM * sizeof(*tbl));
+	if (!tbl)
+		return NULL;
+
+	/* Store the elements in a scrambled order. */
+	for (i = 0; i < NELEM; ++i) {
+		j = (i * SHUFFLE) % NELEM;
+		tbl[i].orig = elem_orig(j);
+		tbl[i].dest = elem_dest(j);
+	}
+	return tbl;
+}
+
+static addrxlat_status
+storeaddr(void *data, const addrxlat_fulladdr_t *addr)
+{
+	addrxlat_fulladdr_t *result = data;
+	*result = *addr;
+	return ADDRXLAT_OK;
+}
+
+static addrxlat_status
+translate(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys,
+	  addrxlat_addr_t addr, addrxlat_fulladdr_t *result)
+{
+	addrxlat_op_ctl_t ctl;
+	addrxlat_fulladdr_t faddr;
+
+	ctl.ctx = ctx;
+	ctl.sys = sys;
+	ctl.op = storeaddr;
+	ctl.data = result;
+	ctl.caps = ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR);
+	faddr.addr = addr;
+	faddr.as = ADDRXLAT_KVADDR;
+	return addrxlat_op(&ctl, &faddr);
+}
+
+static int
+check_large(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys)
+{
+	addrxlat_fulladdr_t result;
+	addrxlat_addr_t addr, expect;
+	addrxlat_status status;
+	unsigned long nerr;
+	size_t i;
+
+	nerr = 0;
+	for (i = 0; i < NELEM; ++i) {
+		addr = elem_orig(i) + (i % PAGE_SIZE);
+		expect = elem_dest(i) + (i % PAGE_SIZE);
+		status = translate(ctx, sys, addr, &result);
+		if (status != ADDRXLAT_OK) {
+			printf("Cannot translate 0x%"ADDRXLAT_PRIxADDR
+			       ": %s\n", addr, addrxlat_ctx_get_err(ctx));
+			++nerr;
+		} else if (result.as != ADDRXLAT_MACHPHYSADDR ||
+			   result.addr != expect) {
+			printf("0x%"ADDRXLAT_PRIxADDR
+			       " -> 0x%"ADDRXLAT_PRIxADDR
+			       ", expected 0x%"ADDRXLAT_PRIxADDR "\n",
+			       addr, result.addr, expect);
+			++nerr;
+		}
+	}
+
+	for (i = 0; i < NELEM; i += NELEM / 10) {
+		addr = elem_orig(i) + PAGE_SIZE;
+		status = translate(ctx, sys, addr, &result);
+		if (status != ADDRXLAT_ERR_NOTPRESENT) {
+			printf("Unmapped 0x%"ADDRXLAT_PRIxADDR
+			       " translated with status %d\n",
+			       addr, (int) status);
+			++nerr;
+		}
+	}
+
+	printf("Translated %d elements\n", NELEM);
+	return nerr ? TEST_FAIL : TEST_OK;
+}
+
+/* Duplicate and overlapping elements. If more than one element
+ * matches, the one which comes first in the table must win, just
+ * like with a linear search.
+ */
+static addrxlat_lookup_elem_t overlap_tbl[] = {
+	{ 0x10000, 0xa000 },
+	{ 0x10800, 0xb000 },	/* overlaps the preceding element */
+	{ 0x10000, 0xc000 },	/* duplicate of the first element */
+	{ 0x20000, 0xd000 },
+	{ 0x1f800, 0xe000 },	/* overlaps the preceding element */
+};
+
+#define OVERLAP_NELEM	(sizeof(overlap_tbl) / sizeof(overlap_tbl[0]))
+
+static const struct {
+	addrxlat_addr_t addr;
+	addrxlat_addr_t expect;
+} overlap_checks[] = {
+	{ 0x10000, 0xa000 },
+	{ 0x10900, 0xa900 },
+	{ 0x10fff, 0xafff },
+	{ 0x11000, 0xb800 },
+	{ 0x117ff, 0xbfff },
+	{ 0x1f900, 0xe100 },
+	{ 0x20000, 0xd000 },
+	{ 0x20100, 0xd100 },
+	{ 0x20900, 0xd900 },
+};
+
+#define OVERLAP_NCHECKS	(sizeof(overlap_checks) / sizeof(overlap_checks[0]))
+
+static int
+check_overlap(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys)
+{
+	addrxlat_fulladdr_t result;
+	addrxlat_addr_t addr, expect;
+	addrxlat_status status;
+	unsigned long nerr;
+	size_t i;
+
+	nerr = 0;
+	for (i = 0; i < OVERLAP_NCHECKS; ++i) {
+		addr = overlap_checks[i].addr;
+		expect = overlap_checks[i].expect;
+		status = translate(ctx, sys, addr, &result);
+		if (status != ADDRXLAT_OK) {
+			printf("Cannot translate 0x%"ADDRXLAT_PRIxADDR
+			       ": %s\n", addr, addrxlat_ctx_get_err(ctx));
+			++nerr;
+		} else if (result.as != ADDRXLAT_MACHPHYSADDR ||
+			   result.addr != expect) {
+			printf("0x%"ADDRXLAT_PRIxADDR
+			       " -> 0x%"ADDRXLAT_PRIxADDR
+			       ", expected 0x%"ADDRXLAT_PRIxADDR "\n",
+			       addr, result.addr, expect);
+			++nerr;
+		}
+	}
+
+	addr = 0x11800;
+	status = translate(ctx, sys, addr, &result);
+	if (status != ADDRXLAT_ERR_NOTPRESENT) {
+		printf("Unmapped 0x%"ADDRXLAT_PRIxADDR
+		       " translated with status %d\n",
+		       addr, (int) status);
+		++nerr;
+	}
+
+	printf("Checked %zu overlapping translations\n", OVERLAP_NCHECKS);
+	return nerr ? TEST_FAIL : TEST_OK;
+}
+
+/* Create a translation system which maps all kernel virtual addresses
+ * using a lookup table.
+ */
+static addrxlat_sys_t *
+make_sys(addrxlat_lookup_elem_t *tbl, size_t nelem)
+{
+	addrxlat_sys_t *sys;
+	addrxlat_map_t *map;
+	addrxlat_range_t range;
+	addrxlat_meth_t meth;
+	addrxlat_status status;
+
+	sys = addrxlat_sys_new();
+	if (!sys) {
+		perror("Cannot allocate translation system");
+		return NULL;
+	}
+
+	meth.kind = ADDRXLAT_LOOKUP;
+	meth.target_as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.lookup.endoff = PAGE_SIZE - 1;
+	meth.param.lookup.nelem = nelem;
+	meth.param.lookup.tbl = tbl;
+	addrxlat_sys_set_meth(sys, ADDRXLAT_SYS_METH_VMEMMAP, &meth);
+
+	map = addrxlat_map_new();
+	if (!map) {
+		perror("Cannot allocate translation map");
+		addrxlat_sys_decref(sys);
+		return NULL;
+	}
+	range.endoff = ADDRXLAT_ADDR_MAX;
+	range.meth = ADDRXLAT_SYS_METH_VMEMMAP;
+	status = addrxlat_map_set(map, 0, &range);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot set up translation map: %s\n",
+			addrxlat_strerror(status));
+		addrxlat_map_decref(map);
+		addrxlat_sys_decref(sys);
+		return NULL;
+	}
+	addrxlat_sys_set_map(sys, ADDRXLAT_SYS_MAP_HW, map);
+	addrxlat_map_decref(map);
+
+	return sys;
+}
+
+int
+main(int argc, char **argv)
+{
+	addrxlat_ctx_t *ctx;
+	addrxlat_sys_t *sys;
+	addrxlat_lookup_elem_t *tbl;
+	int rc, tmprc;
+
+	tbl = make_table();
+	if (!tbl) {
+		perror("Cannot allocate lookup table");
+		return TEST_ERR;
+	}
+
+	ctx = addrxlat_ctx_new();
+	if (!ctx) {
+		perror("Cannot allocate addrxlat context");
+		free(tbl);
+		return TEST_ERR;
+	}
+
+	sys = make_sys(tbl, NELEM);
+	if (!sys) {
+		rc = TEST_ERR;
+		goto out;
+	}
+	rc = check_large(ctx, sys);
+	addrxlat_sys_decref(sys);
+
+	sys = make_sys(overlap_tbl, OVERLAP_NELEM);
+	if (!sys) {
+		rc = TEST_ERR;
+		goto out;
+	}
+	tmprc = check_overlap(ctx, sys);
+	if (tmprc != TEST_OK)
+		rc = tmprc;
+	addrxlat_sys_decref(sys);
+
+ out:
+	addrxlat_ctx_decref(ctx);
+	free(tbl);
+
+	return rc;
+}
@@ -0,0 +1,412 @@
+/* Range address translation.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <libkdumpfile/addrxlat.h>
+
+#include "testutil.h"
+
+#define PAGE_SIZE	0x1000
+#define NPTES		(PAGE_SIZE / sizeof(uint64_t))
+
+#define _PAGE_PRESENT	0x001
+#define _PAGE_PSE	0x080
+
+/* Page tables are stored at physical address 0x1000 and above. */
+#define PGT_BASE	0x1000
+#define PML4_ADDR	0x1000
+#define PDPT_ADDR	0x2000
+#define PD_ADDR		0x3000
+#define PT_ADDR		0x4000
+
+/* Page table address which cannot be read. */
+#define BAD_PT_ADDR	0x8000
+
+/* Pages mapped by the page table. */
+#define PAGES_BASE	0x100000
+
+/* Physical address of the 2M page which maps 0x200000-0x3fffff. */
+#define HUGE_BASE	0x40000000
+
+static uint64_t pgt[4][NPTES];
+
+static addrxlat_status
+read64(void *data, const addrxlat_fulladdr_t *addr, uint64_t *val)
+{
+	addrxlat_addr_t off;
+
+	if (addr->as != ADDRXLAT_MACHPHYSADDR ||
+	    addr->addr < PGT_BASE || addr->addr >= PGT_BASE + sizeof(pgt))
+		return ADDRXLAT_ERR_NODATA;
+
+	off = addr->addr - PGT_BASE;
+	*val = pgt[off / PAGE_SIZE][(off % PAGE_SIZE) / sizeof(uint64_t)];
+	return ADDRXLAT_OK;
+}
+
+/* Virtual pages 0-3 and 7-511 are mapped linearly, pages 4-5 map
+ * to a different contiguous physical range, and page 6 is not
+ * present. Two adjacent 2M pages follow.
+ *
+ * The page table for 0x14000000-0x141fffff cannot be read, and
+ * 0x14200000 is mapped by another 2M page.
+ */
+static void
+init_pgt(void)
+{
+	unsigned i;
+
+	pgt[0][0] = PDPT_ADDR | _PAGE_PRESENT;
+	pgt[1][0] = PD_ADDR | _PAGE_PRESENT;
+	pgt[2][0] = PT_ADDR | _PAGE_PRESENT;
+	pgt[2][1] = HUGE_BASE | _PAGE_PSE | _PAGE_PRESENT;
+	pgt[2][2] = (HUGE_BASE + 0x200000) | _PAGE_PSE | _PAGE_PRESENT;
+	pgt[2][0xa0] = BAD_PT_ADDR | _PAGE_PRESENT;
+	pgt[2][0xa1] = (HUGE_BASE + 0x400000) | _PAGE_PSE | _PAGE_PRESENT;
+	for (i = 0; i < NPTES; ++i)
+		pgt[3][i] = (PAGES_BASE + i * PAGE_SIZE) | _PAGE_PRESENT;
+	pgt[3][4] = 0x200000 | _PAGE_PRESENT;
+	pgt[3][5] = 0x201000 | _PAGE_PRESENT;
+	pgt[3][6] = 0;
+}
+
+static void
+set_pgt_meth(addrxlat_sys_t *sys, addrxlat_sys_meth_t idx)
+{
+	addrxlat_meth_t meth;
+
+	meth.kind = ADDRXLAT_PGT;
+	meth.target_as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.root.addr = PML4_ADDR;
+	meth.param.pgt.root.as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.pf.pte_format = ADDRXLAT_PTE_X86_64;
+	meth.param.pgt.pf.nfields = 5;
+	meth.param.pgt.pf.fieldsz[0] = 12;
+	meth.param.pgt.pf.fieldsz[1] = 9;
+	meth.param.pgt.pf.fieldsz[2] = 9;
+	meth.param.pgt.pf.fieldsz[3] = 9;
+	meth.param.pgt.pf.fieldsz[4] = 9;
+	addrxlat_sys_set_meth(sys, idx, &meth);
+}
+
+static void
+set_linear_meth(addrxlat_sys_t *sys, addrxlat_sys_meth_t idx,
+		addrxlat_addr_t off)
+{
+	addrxlat_meth_t meth;
+
+	meth.kind = ADDRXLAT_LINEAR;
+	meth.target_as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.linear.off = off;
+	addrxlat_sys_set_meth(sys, idx, &meth);
+}
+
+#define MAXRUNS	4
+
+struct run {
+	addrxlat_addr_t src;
+	addrxlat_addr_t dst;
+	addrxlat_addr_t len;
+};
+
+struct test {
+	addrxlat_addr_t addr;
+	addrxlat_addr_t len;
+	addrxlat_status status;
+	unsigned long walks;
+	unsigned nruns;
+	struct run runs[MAXRUNS];
+};
+
+static const struct test tests[] = {
+	/* Contiguous 4K pages are merged. */
+	{ 0x1000, 0x3000, ADDRXLAT_OK, 3,
+	  1, { { 0x1000, PAGES_BASE + 0x1000, 0x3000 } } },
+
+	/* Runs before a non-present page are reported. */
+	{ 0x1800, 0x5000, ADDRXLAT_ERR_NOTPRESENT, 6,
+	  2, { { 0x1800, PAGES_BASE + 0x1800, 0x2800 },
+	       { 0x4000, 0x200000, 0x2000 } } },
+
+	/* A huge page is translated in one step. */
+	{ 0x200000, 0x200000, ADDRXLAT_OK, 1,
+	  1, { { 0x200000, HUGE_BASE, 0x200000 } } },
+
+	/* Adjacent huge pages are merged. */
+	{ 0x3ff800, 0x1000, ADDRXLAT_OK, 2,
+	  1, { { 0x3ff800, HUGE_BASE + 0x1ff800, 0x1000 } } },
+
+	/* Linear mappings with a contiguous target are merged. */
+	{ 0x10fff000, 0x2000, ADDRXLAT_OK, 0,
+	  1, { { 0x10fff000, 0x80fff000, 0x2000 } } },
+
+	/* Linear mappings are split at the end of a map range. */
+	{ 0x11fff000, 0x2000, ADDRXLAT_OK, 0,
+	  2, { { 0x11fff000, 0x81fff000, 0x1000 },
+	       { 0x12000000, 0x90000000, 0x1000 } } },
+
+	/* A gap in an earlier map ends the run. */
+	{ 0x13000000, 0x3000, ADDRXLAT_OK, 0,
+	  3, { { 0x13000000, 0xa0000000, 0x1000 },
+	       { 0x13001000, 0xb0000000, 0x1000 },
+	       { 0x13002000, 0xa0002000, 0x1000 } } },
+
+	/* A failed page table walk in an earlier map ends the run
+	 * at the page boundary. */
+	{ 0x141ff000, 0x2000, ADDRXLAT_OK, 2,
+	  2, { { 0x141ff000, 0xa11ff000, 0x1000 },
+	       { 0x14200000, HUGE_BASE + 0x400000, 0x1000 } } },
+
+	/* Nothing to do for an empty range. */
+	{ 0x1000, 0, ADDRXLAT_OK, 0, 0 },
+};
+
+struct result {
+	unsigned nruns;
+	struct run runs[MAXRUNS];
+};
+
+static addrxlat_status
+storerun(void *data, const addrxlat_fulladdr_t *src,
+	 const addrxlat_fulladdr_t *dst, addrxlat_addr_t len)
+{
+	struct result *result = data;
+	struct run *run;
+
+	if (dst->as != ADDRXLAT_MACHPHYSADDR) {
+		printf("Unexpected target address space: %u\n",
+		       (unsigned) dst->as);
+		return ADDRXLAT_ERR_INVALID;
+	}
+
+	printf("  0x%"ADDRXLAT_PRIxADDR " -> 0x%"ADDRXLAT_PRIxADDR
+	       " (0x%"ADDRXLAT_PRIxADDR " bytes)\n",
+	       src->addr, dst->addr, len);
+	if (result->nruns >= MAXRUNS)
+		return ADDRXLAT_ERR_NOMEM;
+	run = &result->runs[result->nruns++];
+	run->src = src->addr;
+	run->dst = dst->addr;
+	run->len = len;
+	return ADDRXLAT_OK;
+}
+
+static int
+run_test(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys, const struct test *test)
+{
+	addrxlat_op_range_ctl_t ctl;
+	addrxlat_fulladdr_t faddr;
+	struct result result;
+	unsigned long oldhits, oldmisses, hits, misses;
+	addrxlat_status status;
+	unsigned i;
+	int rc;
+
+	printf("0x%"ADDRXLAT_PRIxADDR " + 0x%"ADDRXLAT_PRIxADDR ":\n",
+	       test->addr, test->len);
+
+	addrxlat_ctx_flush_tlb(ctx);
+	addrxlat_ctx_get_tlb_stats(ctx, &oldhits, &oldmisses);
+
+	result.nruns = 0;
+	ctl.ctx = ctx;
+	ctl.sys = sys;
+	ctl.op = storerun;
+	ctl.data = &result;
+	ctl.caps = ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR);
+	faddr.addr = test->addr;
+	faddr.as = ADDRXLAT_KVADDR;
+	status = addrxlat_op_range(&ctl, &faddr, test->len);
+
+	rc = TEST_OK;
+	if (status != test->status) {
+		printf("Status %d (%s), expected %d\n", (int) status,
+		       addrxlat_ctx_get_err(ctx), (int) test->status);
+		rc = TEST_FAIL;
+	}
+
+	addrxlat_ctx_get_tlb_stats(ctx, &hits, &misses);
+	hits -= oldhits;
+	misses -= oldmisses;
+	if (hits + misses != test->walks) {
+		printf("%lu page table lookups, expected %lu\n",
+		       hits + misses, test->walks);
+		rc = TEST_FAIL;
+	}
+
+	if (result.nruns != test->nruns) {
+		printf("%u runs, expected %u\n", result.nruns, test->nruns);
+		return TEST_FAIL;
+	}
+	for (i = 0; i < result.nruns; ++i) {
+		const struct run *run = &result.runs[i];
+		const struct run *expect = &test->runs[i];
+		if (run->src != expect->src || run->dst != expect->dst ||
+		    run->len != expect->len) {
+			printf("Expected 0x%"ADDRXLAT_PRIxADDR
+			       " -> 0x%"ADDRXLAT_PRIxADDR
+			       " (0x%"ADDRXLAT_PRIxADDR " bytes)\n",
+			       expect->src, expect->dst, expect->len);
+			rc = TEST_FAIL;
+		}
+	}
+
+	return rc;
+}
+
+static addrxlat_status
+set_range(addrxlat_map_t *map, addrxlat_addr_t addr,
+	  addrxlat_addr_t endoff, addrxlat_sys_meth_t meth)
+{
+	addrxlat_range_t range;
+
+	range.endoff = endoff;
+	range.meth = meth;
+	return addrxlat_map_set(map, addr, &range);
+}
+
+int
+main(int argc, char **argv)
+{
+	addrxlat_ctx_t *ctx;
+	addrxlat_sys_t *sys;
+	addrxlat_map_t *map;
+	addrxlat_cb_t cb = {
+		.read64 = read64,
+		.read_caps = ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR),
+	};
+	addrxlat_status status;
+	unsigned i;
+	int rc, res;
+
+	init_pgt();
+
+	ctx = addrxlat_ctx_new();
+	if (!ctx) {
+		perror("Cannot allocate addrxlat context");
+		return TEST_ERR;
+	}
+	addrxlat_ctx_set_cb(ctx, &cb);
+
+	/* Page table lookups are counted as TLB misses. */
+	status = addrxlat_ctx_set_tlb_size(ctx, ADDRXLAT_TLB_DEFAULT_SIZE);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot enable TLB: %s\n",
+			addrxlat_ctx_get_err(ctx));
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+
+	sys = addrxlat_sys_new();
+	if (!sys) {
+		perror("Cannot allocate translation system");
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	set_pgt_meth(sys, ADDRXLAT_SYS_METH_PGT);
+	set_pgt_meth(sys, ADDRXLAT_SYS_METH_UPGT);
+	set_linear_meth(sys, ADDRXLAT_SYS_METH_DIRECT,
+			0x80000000 - 0x10000000);
+	set_linear_meth(sys, ADDRXLAT_SYS_METH_KTEXT,
+			0x81000000 - 0x11000000);
+	set_linear_meth(sys, ADDRXLAT_SYS_METH_VMEMMAP,
+			0x90000000 - 0x12000000);
+	set_linear_meth(sys, ADDRXLAT_SYS_METH_RDIRECT,
+			0xa0000000 - 0x13000000);
+	set_linear_meth(sys, ADDRXLAT_SYS_METH_MACHPHYS_KPHYS,
+			0xb0000000 - 0x13001000);
+
+	map = addrxlat_map_new();
+	if (!map) {
+		perror("Cannot allocate translation map");
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	status = set_range(map, 0, 0x5fffff, ADDRXLAT_SYS_METH_PGT);
+	if (status == ADDRXLAT_OK)
+		status = set_range(map, 0x10000000, 0xffffff,
+				   ADDRXLAT_SYS_METH_DIRECT);
+	if (status == ADDRXLAT_OK)
+		status = set_range(map, 0x11000000, 0xffffff,
+				   ADDRXLAT_SYS_METH_KTEXT);
+	if (status == ADDRXLAT_OK)
+		status = set_range(map, 0x12000000, 0xffffff,
+				   ADDRXLAT_SYS_METH_VMEMMAP);
+	if (status == ADDRXLAT_OK)
+		status = set_range(map, 0x13000000, 0x1ffffff,
+				   ADDRXLAT_SYS_METH_RDIRECT);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot set up translation map: %s\n",
+			addrxlat_strerror(status));
+		addrxlat_map_decref(map);
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	addrxlat_sys_set_map(sys, ADDRXLAT_SYS_MAP_HW, map);
+	addrxlat_map_decref(map);
+
+	/* This map is searched before the hardware map. */
+	map = addrxlat_map_new();
+	if (!map) {
+		perror("Cannot allocate translation map");
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	status = set_range(map, 0x13001000, 0xfff,
+			   ADDRXLAT_SYS_METH_MACHPHYS_KPHYS);
+	if (status == ADDRXLAT_OK)
+		status = set_range(map, 0x14000000, 0xffffff,
+				   ADDRXLAT_SYS_METH_UPGT);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot set up translation map: %s\n",
+			addrxlat_strerror(status));
+		addrxlat_map_decref(map);
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	addrxlat_sys_set_map(sys, ADDRXLAT_SYS_MAP_KV_PHYS, map);
+	addrxlat_map_decref(map);
+
+	rc = TEST_OK;
+	for (i = 0; i < ARRAY_SIZE(tests); ++i) {
+		res = run_test(ctx, sys, &tests[i]);
+		if (res != TEST_OK)
+			rc = res;
+	}
+
+	addrxlat_sys_decref(sys);
+	addrxlat_ctx_decref(ctx);
+
+	return rc;
+}
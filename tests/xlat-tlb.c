@@ -0,0 +1,367 @@
+/* Translation lookaside buffer and paging-structure cache.
+   Copyright (C) 2026 The libkdumpfile authors
+
+   This file is free software; you can redistribute it and/or modify
+   it under the terms of either
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at
+       your option) any later version
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at
+       your option) any later version
+
+   or both in parallel, as here.
+
+   libkdumpfile is distributed in the hope that it will be useful, but
+   WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <libkdumpfile/addrxlat.h>
+
+#include "testutil.h"
+
+#define PAGE_SIZE	0x1000
+#define NPTES		(PAGE_SIZE / sizeof(uint64_t))
+
+#define _PAGE_PRESENT	0x001
+#define _PAGE_PSE	0x080
+
+/* Page tables are stored at physical address 0x1000 and above. */
+#define PGT_BASE	0x1000
+#define PML4_ADDR	0x1000
+#define PDPT_ADDR	0x2000
+#define PD_ADDR		0x3000
+#define PT_ADDR		0x4000
+
+/* Pages mapped by the page table. */
+#define PAGES_BASE	0x100000
+
+/* Physical address of the 2M page which maps 0x200000-0x3fffff. */
+#define HUGE_BASE	0x40000000
+
+/* IA32 page tables for 0x40000000 and above share the PD and PT
+ * with the x86_64 page tables, but use 32-bit entries.
+ */
+#define IA32_BASE	0x40000000
+#define IA32_PGD_ADDR	(PD_ADDR - (IA32_BASE >> 22) * sizeof(uint32_t))
+
+/* Ignored by x86_64, but not by IA32. */
+#define PTE_HIGH_BIT	((uint64_t)1 << 52)
+
+static uint64_t pgt[4][NPTES];
+
+static unsigned long nreads;
+
+static addrxlat_status
+read64(void *data, const addrxlat_fulladdr_t *addr, uint64_t *val)
+{
+	addrxlat_addr_t off;
+
+	if (addr->as != ADDRXLAT_MACHPHYSADDR ||
+	    addr->addr < PGT_BASE || addr->addr >= PGT_BASE + sizeof(pgt))
+		return ADDRXLAT_ERR_NODATA;
+
+	off = addr->addr - PGT_BASE;
+	*val = pgt[off / PAGE_SIZE][(off % PAGE_SIZE) / sizeof(uint64_t)];
+	++nreads;
+	return ADDRXLAT_OK;
+}
+
+static addrxlat_status
+read32(void *data, const addrxlat_fulladdr_t *addr, uint32_t *val)
+{
+	addrxlat_addr_t off;
+	uint64_t val64;
+
+	if (addr->as != ADDRXLAT_MACHPHYSADDR ||
+	    addr->addr < PGT_BASE || addr->addr >= PGT_BASE + sizeof(pgt))
+		return ADDRXLAT_ERR_NODATA;
+
+	off = addr->addr - PGT_BASE;
+	val64 = pgt[off / PAGE_SIZE][(off % PAGE_SIZE) / sizeof(uint64_t)];
+	*val = (off & sizeof(uint32_t)) ? val64 >> 32 : val64;
+	++nreads;
+	return ADDRXLAT_OK;
+}
+
+static void
+init_pgt(void)
+{
+	unsigned i;
+
+	pgt[0][0] = PDPT_ADDR | _PAGE_PRESENT;
+	pgt[1][0] = PD_ADDR | _PAGE_PRESENT;
+	pgt[2][0] = PT_ADDR | _PAGE_PRESENT;
+	pgt[2][1] = HUGE_BASE | _PAGE_PSE | _PAGE_PRESENT;
+	for (i = 0; i < NPTES; ++i)
+		pgt[3][i] = (PAGES_BASE + i * PAGE_SIZE) | _PAGE_PRESENT;
+}
+
+static void
+set_pgt_meth(addrxlat_sys_t *sys)
+{
+	addrxlat_meth_t meth;
+
+	meth.kind = ADDRXLAT_PGT;
+	meth.target_as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.root.addr = PML4_ADDR;
+	meth.param.pgt.root.as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.pf.pte_format = ADDRXLAT_PTE_X86_64;
+	meth.param.pgt.pf.nfields = 5;
+	meth.param.pgt.pf.fieldsz[0] = 12;
+	meth.param.pgt.pf.fieldsz[1] = 9;
+	meth.param.pgt.pf.fieldsz[2] = 9;
+	meth.param.pgt.pf.fieldsz[3] = 9;
+	meth.param.pgt.pf.fieldsz[4] = 9;
+	addrxlat_sys_set_meth(sys, ADDRXLAT_SYS_METH_PGT, &meth);
+}
+
+static void
+set_upgt_meth(addrxlat_sys_t *sys)
+{
+	addrxlat_meth_t meth;
+
+	meth.kind = ADDRXLAT_PGT;
+	meth.target_as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.root.addr = IA32_PGD_ADDR;
+	meth.param.pgt.root.as = ADDRXLAT_MACHPHYSADDR;
+	meth.param.pgt.pf.pte_format = ADDRXLAT_PTE_IA32;
+	meth.param.pgt.pf.nfields = 3;
+	meth.param.pgt.pf.fieldsz[0] = 12;
+	meth.param.pgt.pf.fieldsz[1] = 10;
+	meth.param.pgt.pf.fieldsz[2] = 10;
+	addrxlat_sys_set_meth(sys, ADDRXLAT_SYS_METH_UPGT, &meth);
+}
+
+static addrxlat_status
+storeaddr(void *data, const addrxlat_fulladdr_t *addr)
+{
+	addrxlat_fulladdr_t *result = data;
+	*result = *addr;
+	return ADDRXLAT_OK;
+}
+
+/* Translate an address and check the result, the number of reads
+ * and the TLB statistics.
+ */
+static int
+check(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys,
+      addrxlat_addr_t addr, addrxlat_addr_t expect,
+      unsigned long expect_reads, int expect_hit)
+{
+	addrxlat_op_ctl_t ctl;
+	addrxlat_fulladdr_t faddr, result;
+	unsigned long oldhits, oldmisses, hits, misses;
+	unsigned long oldreads;
+	addrxlat_status status;
+	int rc;
+
+	addrxlat_ctx_get_tlb_stats(ctx, &oldhits, &oldmisses);
+	oldreads = nreads;
+
+	ctl.ctx = ctx;
+	ctl.sys = sys;
+	ctl.op = storeaddr;
+	ctl.data = &result;
+	ctl.caps = ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR);
+	faddr.addr = addr;
+	faddr.as = ADDRXLAT_KVADDR;
+	status = addrxlat_op(&ctl, &faddr);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot translate 0x%"ADDRXLAT_PRIxADDR
+			": %s\n", addr, addrxlat_ctx_get_err(ctx));
+		return TEST_ERR;
+	}
+
+	addrxlat_ctx_get_tlb_stats(ctx, &hits, &misses);
+	printf("0x%"ADDRXLAT_PRIxADDR " -> 0x%"ADDRXLAT_PRIxADDR
+	       " (%lu reads, %lu hits, %lu misses)\n",
+	       addr, result.addr, nreads - oldreads,
+	       hits - oldhits, misses - oldmisses);
+
+	rc = TEST_OK;
+	if (result.as != ADDRXLAT_MACHPHYSADDR || result.addr != expect) {
+		printf("Expected 0x%"ADDRXLAT_PRIxADDR "\n", expect);
+		rc = TEST_FAIL;
+	}
+	if (nreads - oldreads != expect_reads) {
+		printf("Expected %lu reads\n", expect_reads);
+		rc = TEST_FAIL;
+	}
+	if (expect_hit >= 0 &&
+	    (hits - oldhits != expect_hit ||
+	     misses - oldmisses != !expect_hit)) {
+		printf("Expected a TLB %s\n", expect_hit ? "hit" : "miss");
+		rc = TEST_FAIL;
+	}
+	return rc;
+}
+
+static int
+run_tests(addrxlat_ctx_t *ctx, addrxlat_sys_t *sys)
+{
+	int rc = TEST_OK;
+	int res;
+
+#define CHECK(addr, expect, reads, hit)				\
+	do {							\
+		res = check(ctx, sys, addr, expect, reads, hit);	\
+		if (res == TEST_ERR)				\
+			return res;				\
+		if (res != TEST_OK)				\
+			rc = res;				\
+	} while (0)
+
+	/* Upper-level entries are cached, so a TLB miss on a
+	 * neighbouring page reads only the lowest-level entry.
+	 */
+	puts("4K pages:");
+	CHECK(0x1234, 0x101234, 4, 0);
+	CHECK(0x1ff8, 0x101ff8, 0, 1);
+	CHECK(0x5678, 0x105678, 1, 0);
+	CHECK(0x1000, 0x101000, 0, 1);
+
+	puts("2M page:");
+	CHECK(0x212345, HUGE_BASE + 0x12345, 1, 0);
+	CHECK(0x212fff, HUGE_BASE + 0x12fff, 0, 1);
+	CHECK(0x3ff000, HUGE_BASE + 0x1ff000, 0, -1);
+
+	puts("Changed method:");
+	set_pgt_meth(sys);
+	CHECK(0x1234, 0x101234, 4, 0);
+
+	puts("Changed callbacks:");
+	pgt[3][1] = 0x200000 | _PAGE_PRESENT;
+	CHECK(0x1234, 0x101234, 0, 1);
+	addrxlat_ctx_set_cb(ctx, addrxlat_ctx_get_cb(ctx));
+	CHECK(0x1234, 0x200234, 4, 0);
+
+	puts("Explicit flush:");
+	pgt[3][1] = (PAGES_BASE + PAGE_SIZE) | _PAGE_PRESENT;
+	addrxlat_ctx_flush_tlb(ctx);
+	CHECK(0x1234, 0x101234, 4, 0);
+
+	puts("Disabled TLB:");
+	if (addrxlat_ctx_set_tlb_size(ctx, 0) != ADDRXLAT_OK ||
+	    addrxlat_ctx_get_tlb_size(ctx) != 0) {
+		puts("Cannot disable TLB");
+		rc = TEST_FAIL;
+	}
+	CHECK(0x1234, 0x101234, 4, -1);
+	CHECK(0x1234, 0x101234, 4, -1);
+
+	if (addrxlat_ctx_set_tlb_size(ctx, 5) != ADDRXLAT_OK ||
+	    addrxlat_ctx_get_tlb_size(ctx) != 8) {
+		printf("TLB size %zu, expected 8\n",
+		       addrxlat_ctx_get_tlb_size(ctx));
+		rc = TEST_FAIL;
+	}
+	CHECK(0x1234, 0x101234, 4, 0);
+	CHECK(0x1234, 0x101234, 0, 1);
+
+	/* The same PD entry is read as a 64-bit and as a 32-bit entry. */
+	puts("Different entry size:");
+	pgt[2][0] |= PTE_HIGH_BIT;
+	addrxlat_ctx_flush_tlb(ctx);
+	CHECK(0x1234, 0x101234, 4, 0);
+	CHECK(IA32_BASE + 0x2234, 0x101234, 2, 0);
+	pgt[2][0] &= ~PTE_HIGH_BIT;
+
+#undef CHECK
+
+	return rc;
+}
+
+int
+main(int argc, char **argv)
+{
+	addrxlat_ctx_t *ctx;
+	addrxlat_sys_t *sys;
+	addrxlat_map_t *map;
+	addrxlat_range_t range;
+	addrxlat_cb_t cb = {
+		.read32 = read32,
+		.read64 = read64,
+		.read_caps = ADDRXLAT_CAPS(ADDRXLAT_MACHPHYSADDR),
+	};
+	addrxlat_status status;
+	int rc;
+
+	init_pgt();
+
+	ctx = addrxlat_ctx_new();
+	if (!ctx) {
+		perror("Cannot allocate addrxlat context");
+		return TEST_ERR;
+	}
+	addrxlat_ctx_set_cb(ctx, &cb);
+
+	if (addrxlat_ctx_get_tlb_size(ctx) != 0) {
+		printf("Default TLB size %zu, expected 0\n",
+		       addrxlat_ctx_get_tlb_size(ctx));
+		addrxlat_ctx_decref(ctx);
+		return TEST_FAIL;
+	}
+	status = addrxlat_ctx_set_tlb_size(ctx, ADDRXLAT_TLB_DEFAULT_SIZE);
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot enable TLB: %s\n",
+			addrxlat_ctx_get_err(ctx));
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+
+	sys = addrxlat_sys_new();
+	if (!sys) {
+		perror("Cannot allocate translation system");
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	set_pgt_meth(sys);
+	set_upgt_meth(sys);
+
+	map = addrxlat_map_new();
+	if (!map) {
+		perror("Cannot allocate translation map");
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	range.endoff = IA32_BASE - 1;
+	range.meth = ADDRXLAT_SYS_METH_PGT;
+	status = addrxlat_map_set(map, 0, &range);
+	if (status == ADDRXLAT_OK) {
+		range.endoff = IA32_BASE - 1;
+		range.meth = ADDRXLAT_SYS_METH_UPGT;
+		status = addrxlat_map_set(map, IA32_BASE, &range);
+	}
+	if (status != ADDRXLAT_OK) {
+		fprintf(stderr, "Cannot set up translation map: %s\n",
+			addrxlat_strerror(status));
+		addrxlat_map_decref(map);
+		addrxlat_sys_decref(sys);
+		addrxlat_ctx_decref(ctx);
+		return TEST_ERR;
+	}
+	addrxlat_sys_set_map(sys, ADDRXLAT_SYS_MAP_HW, map);
+	addrxlat_map_decref(map);
+
+	rc = run_tests(ctx, sys);
+
+	addrxlat_sys_decref(sys);
+	addrxlat_ctx_decref(ctx);
+
+	return rc;
+}